@@ -45,3 +45,24 @@ CREATE TABLE IF NOT EXISTS events_commands (
   event_id INTEGER NOT NULL,
   FOREIGN KEY(event_id) REFERENCES scheduled_events(event_id)
 );
+
+CREATE TABLE IF NOT EXISTS events_options (
+  option_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+  name VARCHAR(32) NOT NULL,
+  value VARCHAR(256),
+  event_id INTEGER NOT NULL,
+  FOREIGN KEY(event_id) REFERENCES scheduled_events(event_id)
+);
+
+CREATE TABLE IF NOT EXISTS events_metrics (
+  event_id INTEGER PRIMARY KEY NOT NULL,
+  runs INTEGER DEFAULT 0,
+  failures INTEGER DEFAULT 0,
+  timeouts INTEGER DEFAULT 0,
+  last_duration INTEGER DEFAULT 0,
+  total_duration INTEGER DEFAULT 0,
+  max_duration INTEGER DEFAULT 0,
+  histogram VARCHAR(128),
+  coalesced INTEGER DEFAULT 0,
+  FOREIGN KEY(event_id) REFERENCES scheduled_events(event_id)
+);
@@ -144,7 +144,7 @@ if __name__ == "__main__":
   #Create backup of makefile
   copyfile(MAKEFILE_AM, MAKEFILE_AM_BAK)
   #Print sources in Makefile
-  sourcesFiles = "murmure_SOURCES += "
+  sourcesFiles = "MURMURE_COMMON_SOURCES += "
   for module in moduleSelectionList:
     sourcesFiles += "core/modules/" + module + ".cpp "
   try:
@@ -0,0 +1,139 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef AGENTX_PDU_HPP
+#define AGENTX_PDU_HPP
+
+#include <core/varbind.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//AgentX protocol (RFC 2741)
+#define AGENTX_VERSION 1
+#define AGENTX_HEADER_SIZE 20
+#define AGENTX_MAX_PDU 1048576 //Max payload accepted from master agent
+
+//Header flags
+#define AGENTX_FLAG_INSTANCE_REGISTRATION 0x01
+#define AGENTX_FLAG_NON_DEFAULT_CONTEXT 0x08
+#define AGENTX_FLAG_NETWORK_BYTE_ORDER 0x10
+
+//Response errors
+#define AGENTX_ERR_NOERROR 0
+#define AGENTX_ERR_GENERR 5
+#define AGENTX_ERR_WRONGTYPE 7
+#define AGENTX_ERR_WRONGVALUE 10
+#define AGENTX_ERR_NOCREATION 11
+#define AGENTX_ERR_COMMITFAILED 14
+#define AGENTX_ERR_UNDOFAILED 15
+#define AGENTX_ERR_NOTWRITABLE 17
+#define AGENTX_ERR_PARSEERROR 266
+#define AGENTX_ERR_PROCESSINGERROR 268
+
+//Close reasons
+#define AGENTX_CLOSE_PARSEERROR 2
+#define AGENTX_CLOSE_SHUTDOWN 5
+
+namespace murmure {
+namespace agentx {
+
+enum class PduType : uint8_t {
+  OPEN = 1,
+  CLOSE = 2,
+  REGISTER = 3,
+  UNREGISTER = 4,
+  GET = 5,
+  GETNEXT = 6,
+  GETBULK = 7,
+  TESTSET = 8,
+  COMMITSET = 9,
+  UNDOSET = 10,
+  CLEANUPSET = 11,
+  NOTIFY = 12,
+  PING = 13,
+  RESPONSE = 18
+};
+
+typedef struct {
+  PduType type;
+  uint8_t flags;
+  uint32_t sessionId;
+  uint32_t transactionId;
+  uint32_t packetId;
+  uint32_t payloadLength;
+} pduHeader;
+
+typedef struct {
+  std::string start; //Dotted OID
+  bool include;      //Start OID itself can be returned
+  std::string end;   //Dotted OID; empty if unbounded
+} searchRange;
+
+bool readHeader(const char* data, pduHeader& header);
+
+//Decodes PDU payload fields
+class PduReader {
+public:
+  PduReader(const char* payload, size_t length, bool networkOrder);
+  bool readUint8(uint8_t& value);
+  bool readUint16(uint16_t& value);
+  bool readUint32(uint32_t& value);
+  bool readUint64(uint64_t& value);
+  bool readOid(std::string& oid, bool& include);
+  bool readOctets(std::string& octets);
+  bool readSearchRange(searchRange& range);
+  bool readVarbind(varbind& binding);
+  bool skip(size_t length);
+  bool atEnd();
+
+private:
+  const char* payload;
+  size_t length;
+  size_t position;
+  bool networkOrder;
+};
+
+//Encodes a PDU, in network byte order
+class PduWriter {
+public:
+  PduWriter();
+  void begin(PduType type, uint8_t flags, uint32_t sessionId, uint32_t transactionId, uint32_t packetId);
+  const std::string& finish();
+  void writeUint8(uint8_t value);
+  void writeUint16(uint16_t value);
+  void writeUint32(uint32_t value);
+  void writeUint64(uint64_t value);
+  void writeOid(const std::string& oid, bool include = false);
+  void writeOctets(const std::string& octets);
+  void writeVarbind(const varbind& binding);
+
+private:
+  std::string buffer; //Reused across PDUs
+};
+
+} // namespace agentx
+} // namespace murmure
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef AGENTX_SUBAGENT_HPP
+#define AGENTX_SUBAGENT_HPP
+
+#include <agentx/pdu.hpp>
+#include <core/settransaction.hpp>
+#include <mibscheduler/scheduler.hpp>
+
+#include <csignal>
+#include <string>
+#include <vector>
+
+#define DEFAULT_AGENTX_SOCKET "/var/agentx/master" //Net-SNMP master agent default
+#define AGENTX_RECONNECT_INTERVAL 5                //Seconds between connection attempts to master agent
+#define AGENTX_POLL_INTERVAL 1000                  //Max time a stop request waits (ms)
+#define AGENTX_RESPONSE_TIMEOUT 5000               //Max time to wait for master agent responses (ms)
+#define AGENTX_PRIORITY 127                        //Registration priority (default)
+
+namespace murmure {
+namespace agentx {
+
+class Subagent {
+
+public:
+  Subagent(Mibtable* mibtable, Scheduler* scheduler, const std::string& masterPath);
+  ~Subagent();
+  bool run(std::string& error);
+  static void requestStop();
+
+private:
+  bool openSession(std::string& error);
+  bool request(std::string& error);
+  bool sendPdu(const std::string& pdu);
+  int readPdu(pduHeader& header, std::string& payload, int timeout);
+  void serve();
+  void closeSession(uint8_t reason);
+  bool handlePdu(const pduHeader& header, const std::string& payload);
+  void respond(const pduHeader& header, uint16_t error, uint16_t index, const std::vector<varbind>& varbinds);
+  bool get(PduReader& reader, std::vector<varbind>& varbinds);
+  bool getNext(PduReader& reader, std::vector<varbind>& varbinds);
+  bool getBulk(PduReader& reader, std::vector<varbind>& varbinds);
+  uint16_t testSet(PduReader& reader, uint16_t& index);
+  bool encodeValue(Oid* oid, varbind& binding);
+  std::string findRoot();
+  Mibtable* mibtable;
+  Scheduler* scheduler;
+  std::string masterPath;
+  std::string rootOid;           //Registered subtree
+  int sockFd;
+  uint32_t sessionId;
+  uint32_t packetId;             //Last packet id sent
+  std::string input;             //Bytes received and not processed yet
+  PduWriter writer;
+  SetTransaction transaction;
+  walkCursor cursor;             //GetNext walks of the master agent
+  static volatile sig_atomic_t stopRequested;
+};
+
+} // namespace agentx
+} // namespace murmure
+
+#endif
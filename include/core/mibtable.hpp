@@ -25,10 +25,23 @@
 #define MIBTABLE_HPP
 
 #include <core/oid.hpp>
+#include <utils/rwlock.hpp>
+
+#include <atomic>
+#include <unordered_map>
 #include <vector>
 
+//OIDs per 64 bit word of the lookup filter beyond which the filter is rebuilt twice as large
+#define MIBTABLE_FILTER_OIDS_PER_WORD 4
+
 namespace murmure {
 
+//Table position of the last OID returned to a client by getNext; a walk continuing from it needs no search
+typedef struct {
+  size_t position = 0;
+  uint64_t generation = 0; //Table generation the position belongs to; 0 is never valid
+} walkCursor;
+
 class Mibtable {
 
 public:
@@ -39,13 +52,30 @@ public:
   bool clearMibtable();
   void sortMibTable();
   Oid* getOidByOid(const std::string& oid);
+  Oid* getOidByKey(uint64_t key);
   Oid* getOidByName(const std::string& name);
   std::string getNextOid(const std::string& oid);
+  Oid* getSuccessor(const std::string& oid, bool inclusive = false);
+  size_t getSuccessors(const std::string& oid, size_t amount, std::vector<Oid*>& successors, bool (*accept)(Oid*) = nullptr);
+  Oid* getNext(const std::string& oid, walkCursor& cursor, bool (*accept)(Oid*) = nullptr);
+  void getCursorStats(uint64_t& hits, uint64_t& misses);
   std::string getPreviousOid(const std::string& oid);
   bool isTableChild(const std::string& oid);
 
 private:
+  void indexOid(Oid* oid);
+  void buildFilter();
+  bool filterMayContain(uint64_t key);
+  void sortOids();
+  Oid* findOid(const std::string& oid);
+  std::string findPreviousOid(const std::string& oid);
   std::vector<Oid*> oids;
+  std::unordered_map<uint64_t, Oid*> oidIndex; //OID key => Oid
+  std::vector<uint64_t> filter; //Blocked bloom filter over OID keys; rejects most nonexistent OIDs before the index is looked up
+  RWLock tableLock; //Shared by lookups, exclusive for inserts and sorting; OID values have their own lock
+  uint64_t generation; //Incremented whenever positions change; invalidates walk cursors
+  std::atomic<uint64_t> cursorHits;
+  std::atomic<uint64_t> cursorMisses;
 };
 
 } // namespace murmure
@@ -31,26 +31,44 @@
   "\
 Usage:\n\
 \t-D\t\t\t\t\tStart Murmure as daemon (use for NET-SNMP pass_persist)\n\
+\t-X --agentx [master socket]\t\tStart Murmure as AgentX subagent\n\
+\t-P --snmp [[address:]port]\t\tStart Murmure as standalone SNMPv2c agent (default 127.0.0.1:161)\n\
 \t-g <OID>\t\t\t\tissue 'get' on specified OID\n\
 \t-n <OID>\t\t\t\tissue 'get next' on specified OID\n\
 \t-s <OID> <type> <value>\t\t\tissue 'set' on specified OID\n\
+\t--walk <OID>\t\t\t\tprint all the OIDs beneath specified OID\n\
 \t-M --parse-mib <rootOID> <MIBfile>\tParse and configure Murmure for selected MIB\n\
 \t-S --schedule [schedule file]\t\tConfigure Murmure schedulation.\n\
 \t--dump-scheduling [outfile]\t\tDump scheduling.\n\
+\t--dump-metrics [outfile]\t\tDump events execution metrics.\n\
+\t-T <milliseconds>\t\t\tDefault events execution timeout (0 = none)\n\
+\t-Q <class>:<slots>[:<nice>[:<ioprio>]]\tExecution class limits (request/background)\n\
+\t-U <socket>\t\t\t\tDaemon socket; -g/-n/-s are forwarded to the daemon listening on it\n\
+\t-W <workers>\t\t\t\tThreads serving daemon socket clients (default 4)\n\
+\t-c --community <name>[:ro|:rw]\t\tSNMP agent community (default public:ro)\n\
+\t--snmp-threads <threads>\t\tSNMP agent receiving threads, sharing the port (default 1)\n\
+\t--ingest [ring file]\t\t\tApply values pushed by collectors through a shared ring (default /dev/shm/murmure.ingest)\n\
 \t--reset\t\t\t\t\tReset entire mib and event tables\n\
 \t-C --change <OID> <value>\t\tSet value for OID manually to value\n\
+\t--batch <file|->\t\t\tExecute get/getnext/set/change lines in one process and transaction\n\
 \t-h --help\t\t\t\tShow this page\n\
 "
 
+#include <agentx/subagent.hpp>
+#include <ingest/consumer.hpp>
+#include <snmp/agent.hpp>
 #include <core/mibtable.hpp>
 #include <utils/getopts.hpp>
 #include <utils/logger.hpp>
+#include <utils/process.hpp>
+#include <utils/strutils.hpp>
 #include <utils/databasefacade.hpp>
 
 #include <mibparser/mibparser.hpp>
 #include <mibscheduler/scheduler.hpp>
 
 #include <algorithm>
+#include <csignal>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -81,6 +99,20 @@ Usage:\n\
 #define DEFAULT_DATABASEPATH QUOTE(DBPATH)
 #endif
 
+//Daemon socket, used by one-shot requests
+#ifndef SOCKETFILE
+#define DEFAULT_MURMURE_SOCKET "/var/run/murmure.sock"
+#else
+#define DEFAULT_MURMURE_SOCKET QUOTE(SOCKETFILE)
+#endif
+
+#define DEFAULT_SOCKET_WORKERS 4 //Threads serving daemon socket connections
+#define DEFAULT_MURMURE_INGEST "/dev/shm/murmure.ingest" //Ingestion ring file (--ingest)
+#define WALK_BULK_SIZE 1000 //OIDs requested at a time by --walk
+#define BATCH_COMMIT_INTERVAL 500 //Longest time batch changes are kept in an open transaction (ms)
+#define NO_SUCH_NAME_LOG_BURST 10 //no-such-name warnings logged per interval; further ones are counted only
+#define NO_SUCH_NAME_LOG_INTERVAL 60 //seconds
+
 #define COMPONENT "Core"
 
 
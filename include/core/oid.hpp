@@ -26,16 +26,25 @@
 
 #include <core/accessmode.hpp>
 #include <core/primitives/primitive.hpp>
+#include <mibscheduler/eventmode.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace murmure {
 
+class Event;
+
 class Oid {
 
 public:
   Oid(const std::string& oid, const std::string& type, const std::string& value, const int access, const std::string& name = "");
   ~Oid();
   std::string getOid();
+  uint64_t getKey();
   std::string getType();
   std::string getPrimitiveType();
   std::string getName();
@@ -43,18 +52,38 @@ public:
   AccessMode getAccessMode();
   int getAccessModeInteger();
   bool setValue(std::string printableValue);
+  bool reloadValue();
+  bool loadValue(const std::string& printableValue);
+  std::chrono::steady_clock::time_point getLastUpdate();
+  void markRead();
+  std::chrono::steady_clock::time_point getLastRead();
   bool isTypeValid();
+  //Events bound to this OID
+  void attachEvent(Event* event);
+  void detachEvent(Event* event);
+  void detachEvents();
+  const std::vector<Event*>& getEvents(EventMode mode);
 
 private:
+  void* newData(const std::string& value);
+  void freeData(void* data);
   std::string oid;           //OID which identifies this instance
+  uint64_t key;              //Numeric key of OID string (see oidKey)
   std::string name;          //optional name for OID
   AccessMode accessMode;     //Access level for OID
   std::string dataType;      //Type string
   std::string primitiveType; //Primitive type string
   void* data;                //Wrapper of value (void pointer to Primitive extension class)
+  std::mutex valueMutex;     //Guards data, which can be refreshed by scheduler threads
+  std::chrono::steady_clock::time_point lastUpdate; //Last time value was set or reloaded
+  std::chrono::steady_clock::time_point lastRead;   //Last time value was requested by a GET/GETNEXT
+  std::vector<Event*> getEventList; //GET events associated to this OID
+  std::vector<Event*> setEventList; //SET events associated to this OID
 };
 
 bool sortByOid(Oid* firstOid, Oid* secondOid);
+int compareOids(const std::string& firstOid, const std::string& secondOid);
+uint64_t oidKey(const std::string& oid);
 
 } // namespace murmure
 
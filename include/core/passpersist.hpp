@@ -0,0 +1,70 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef PASSPERSIST_HPP
+#define PASSPERSIST_HPP
+
+#include <cstddef>
+#include <string>
+
+#define PASSPERSIST_BUFFER_SIZE 65536 //Max length of a request line
+
+namespace murmure {
+
+//Line of the input buffer (without newline); valid until the next read
+class LineView {
+public:
+  LineView();
+  LineView(const char* data, size_t length);
+  bool equals(const char* text) const;
+  bool empty() const;
+  size_t find(char character) const;
+  void copyTo(std::string& target) const;
+  const char* data;
+  size_t length;
+};
+
+//Pass_persist protocol I/O: buffered reads of request lines and a single write per response
+class PassPersist {
+public:
+  PassPersist(int inputFd, int outputFd);
+  ~PassPersist();
+  bool readLine(LineView& line);
+  std::string& getResponse();
+  bool flush();
+
+private:
+  bool fill();
+  int inputFd;
+  int outputFd;
+  char* buffer;         //Input buffer
+  size_t begin;         //Start of data not read yet
+  size_t end;           //End of data in buffer
+  bool eof;
+  bool discarding;      //Skipping the rest of a line longer than the buffer
+  std::string response; //Response being prepared; its capacity is reused
+};
+
+} // namespace murmure
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef SETTRANSACTION_HPP
+#define SETTRANSACTION_HPP
+
+#include <core/varbind.hpp>
+#include <mibscheduler/scheduler.hpp>
+
+#include <string>
+#include <vector>
+
+namespace murmure {
+
+//Varbind of a SET transaction
+typedef struct {
+  std::string oid;
+  Oid* target;           //nullptr if the OID is created
+  Oid* parent;           //Table OID of a created OID
+  std::string value;     //Printable value to set
+  std::string previous;  //Printable value before commit
+  bool applied;
+} pendingSet;
+
+//Multi-varbind SET: test, commit, undo and cleanup phases (RFC 3416 / RFC 2741)
+class SetTransaction {
+
+public:
+  SetTransaction(Mibtable* mibtable, Scheduler* scheduler);
+  uint16_t test(const varbind& binding);
+  uint16_t commit(uint16_t& index);
+  uint16_t undo(uint16_t& index);
+  void cleanup();
+  void clear();
+
+private:
+  Mibtable* mibtable;
+  Scheduler* scheduler;
+  std::vector<pendingSet> pendingSets;
+  bool committed; //Pending sets have been committed
+};
+
+} // namespace murmure
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef VARBIND_HPP
+#define VARBIND_HPP
+
+#include <core/mibtable.hpp>
+
+#include <cstdint>
+#include <string>
+
+//SNMP error status (shared by AgentX)
+#define SNMP_ERR_NOERROR 0
+#define SNMP_ERR_TOOBIG 1
+#define SNMP_ERR_GENERR 5
+#define SNMP_ERR_NOACCESS 6
+#define SNMP_ERR_WRONGTYPE 7
+#define SNMP_ERR_NOCREATION 11
+#define SNMP_ERR_COMMITFAILED 14
+#define SNMP_ERR_UNDOFAILED 15
+#define SNMP_ERR_NOTWRITABLE 17
+
+namespace murmure {
+
+//SNMP value types; numbering is shared by AgentX and by BER tags
+enum class VarbindType : uint16_t {
+  INTEGER = 2,
+  OCTETSTRING = 4,
+  NULLVALUE = 5,
+  OBJECTIDENTIFIER = 6,
+  IPADDRESS = 64,
+  COUNTER32 = 65,
+  GAUGE32 = 66,
+  TIMETICKS = 67,
+  OPAQUE = 68,
+  COUNTER64 = 70,
+  NOSUCHOBJECT = 128,
+  NOSUCHINSTANCE = 129,
+  ENDOFMIBVIEW = 130
+};
+
+typedef struct {
+  VarbindType type;
+  std::string oid;  //Dotted OID
+  uint64_t number;  //Integer types value
+  std::string data; //Octet string bytes or dotted OID
+} varbind;
+
+bool isLeaf(Oid* oid);
+Oid* nextLeaf(Mibtable* mibtable, const std::string& start, bool include, const std::string& end = "", walkCursor* cursor = nullptr);
+bool encodeValue(Oid* oid, varbind& binding);
+bool decodeValue(const varbind& binding, const std::string& primitiveType, std::string& value);
+
+} // namespace murmure
+
+#endif
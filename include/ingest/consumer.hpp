@@ -0,0 +1,72 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef INGEST_CONSUMER_HPP
+#define INGEST_CONSUMER_HPP
+
+#include <core/mibtable.hpp>
+#include <ingest/murmureingest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_INGEST_CAPACITY 65536 //Records of the ring (4 MB)
+#define INGEST_BATCH_SIZE 4096        //Records applied at a time, in one database transaction
+#define INGEST_IDLE_SLEEP 5           //Time the consumer waits when the ring is empty (ms)
+
+namespace murmure {
+namespace ingest {
+
+//Applies the records pushed by collectors through the shared ingestion ring (see murmureingest.h)
+class Consumer {
+
+public:
+  Consumer(Mibtable* mibtable);
+  ~Consumer();
+  bool start(const std::string& path, std::string& error);
+  void stop();
+  static void getStats(uint64_t& records, uint64_t& applied, uint64_t& unknown, uint64_t& invalid, uint64_t& dropped);
+
+private:
+  void run();
+  size_t drain(std::vector<murmure_ingest_record>& batch);
+  void apply(std::vector<murmure_ingest_record>& batch);
+  Mibtable* mibtable;
+  murmure_ingest_header* header;
+  murmure_ingest_record* records;
+  size_t mappedSize;
+  std::thread* consumerThread;
+  std::atomic<bool> stopping;
+  static std::atomic<uint64_t> recordsRead; //Records read from the ring
+  static std::atomic<uint64_t> applied;     //Values written, after coalescing the records of a batch by OID
+  static std::atomic<uint64_t> unknown;     //Records for keys which aren't in the MIB table
+  static std::atomic<uint64_t> invalid;     //Records whose value couldn't be set
+  static std::atomic<uint64_t> dropped;     //Records dropped by producers, as of the last batch
+};
+
+} // namespace ingest
+} // namespace murmure
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * Murmure ingestion ring C ABI
+ * The daemon started with --ingest maps a ring of records in a shared file; collectors on the same host
+ * open it with murmure_ingest_open and push (OID key, value) records, which the daemon applies to its
+ * OIDs in batches, writing them to the database as -C does (no events are executed).
+ * Any amount of producers (threads or processes) can push concurrently; pushing never blocks: when the
+ * ring is full the record is dropped, counted, and MURMURE_INGEST_FULL is returned.
+ * Link with -lmurmureingest
+**/
+
+#ifndef MURMUREINGEST_H
+#define MURMUREINGEST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MURMURE_INGEST_ABI_VERSION 1
+#define MURMURE_INGEST_MAGIC 0x4e49524dU //"MRIN"
+
+//Record value types
+#define MURMURE_INGEST_INTEGER 1 //INTEGER, COUNTER, GAUGE, TIMETICKS OIDs
+#define MURMURE_INGEST_STRING 2  //Any OID, value as printed by murmure -g
+
+//Maximum length of a string value (not terminated in the record)
+#define MURMURE_INGEST_STRING_MAX 40
+
+//Push return values
+#define MURMURE_INGEST_OK 0     //Record pushed
+#define MURMURE_INGEST_FULL 1   //Ring is full; record has been dropped
+#define MURMURE_INGEST_ERROR -1 //Invalid record, or ring not initialized by the daemon
+
+//A slot of the ring; 64 bytes
+typedef struct {
+  uint64_t sequence; //Slot state; written last by producers, so that the consumer never reads a partial record
+  uint64_t key;      //OID key (see murmure_ingest_key)
+  uint32_t type;     //MURMURE_INGEST_*
+  uint32_t length;   //Length of string value
+  union {
+    int64_t integer;
+    char string[MURMURE_INGEST_STRING_MAX];
+  } value;
+} murmure_ingest_record;
+
+//Ring header; records follow it. Producers and consumer positions lie on different cache lines
+typedef struct {
+  uint32_t magic;       //MURMURE_INGEST_MAGIC once the daemon has initialized the ring
+  uint32_t abi_version; //MURMURE_INGEST_ABI_VERSION
+  uint64_t capacity;    //Amount of records; power of 2
+  uint64_t dropped;     //Records dropped by producers because the ring was full
+  char reserved0[40];
+  uint64_t tail; //Next position reserved by producers
+  char reserved1[56];
+  uint64_t head; //Next position read by the daemon
+  char reserved2[56];
+} murmure_ingest_header;
+
+typedef struct murmure_ingest murmure_ingest;
+
+murmure_ingest* murmure_ingest_open(const char* path);
+void murmure_ingest_close(murmure_ingest* ring);
+uint64_t murmure_ingest_key(const char* oid);
+int murmure_ingest_integer(murmure_ingest* ring, uint64_t key, int64_t value);
+int murmure_ingest_string(murmure_ingest* ring, uint64_t key, const char* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
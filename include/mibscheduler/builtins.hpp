@@ -0,0 +1,54 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef BUILTINS_HPP
+#define BUILTINS_HPP
+
+#include <core/mibtable.hpp>
+#include <mibscheduler/eventmode.hpp>
+
+#include <string>
+
+//Builtin actions are event commands executed in-process against the MIB table
+#define BUILTIN_PREFIX '@'
+#define BUILTIN_SET "@set"             //@set <oid> <value>
+#define BUILTIN_INCREMENT "@increment" //@increment <oid> [amount]
+#define BUILTIN_COPYFILE "@copyfile"   //@copyfile <oid> <file>
+#define BUILTIN_COPYOID "@copyoid"     //@copyoid <oid> <source oid>
+#define BUILTIN_TIMESTAMP "@timestamp" //@timestamp <oid>
+#define BUILTIN_PLUGIN "@plugin"       //@plugin <library>:<function> (see murmureplugin.h)
+
+#define BUILTIN_VALUE_VARIABLE "$SNMP_VALUE" //Replaced by the value which triggered the event
+#define BUILTIN_OID_VARIABLE "$SNMP_OID"     //Replaced by the OID which triggered the event
+
+namespace murmure {
+namespace builtins {
+
+bool isBuiltin(const std::string& command);
+bool check(Mibtable* mibtable, const std::string& command, std::string& error);
+bool run(Mibtable* mibtable, const std::string& command, const std::string& eventOid, EventMode mode, const std::string& value, std::string& error);
+
+} // namespace builtins
+} // namespace murmure
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+
+namespace murmure {
+
+//Time source of the scheduler thread
+class Clock {
+public:
+  virtual ~Clock() {}
+  virtual std::chrono::steady_clock::time_point now() = 0;
+  virtual time_t wallTime() = 0;
+  virtual void sleepUntil(std::chrono::steady_clock::time_point when) = 0;
+  virtual void interrupt(bool interrupted) {} //While interrupted, sleeping returns immediately
+};
+
+//Real time
+class SystemClock : public Clock {
+public:
+  SystemClock();
+  std::chrono::steady_clock::time_point now();
+  time_t wallTime();
+  void sleepUntil(std::chrono::steady_clock::time_point when);
+  void interrupt(bool interrupted);
+
+private:
+  std::mutex sleepMutex;
+  std::condition_variable sleepCondition;
+  bool interrupted;
+};
+
+//Simulated time: sleeping fast-forwards the clock instead of waiting
+class VirtualClock : public Clock {
+public:
+  VirtualClock();
+  std::chrono::steady_clock::time_point now();
+  time_t wallTime();
+  void sleepUntil(std::chrono::steady_clock::time_point when);
+  void advance(std::chrono::steady_clock::duration amount);
+
+private:
+  std::mutex clockMutex;
+  std::chrono::steady_clock::time_point origin; //Steady time when clock was created
+  time_t wallOrigin;                            //Wall time when clock was created
+  std::chrono::steady_clock::time_point current;
+};
+
+} // namespace murmure
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef CRONSCHEDULE_HPP
+#define CRONSCHEDULE_HPP
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace murmure {
+
+//Cron-style schedule: "minute hour day-of-month month day-of-week"
+class CronSchedule {
+public:
+  CronSchedule();
+  bool parse(const std::string& expression, std::string& error);
+  bool isSet();
+  time_t next(time_t after);
+
+private:
+  bool matchesDay(const struct tm& date);
+  static bool parseField(const std::string& field, int minValue, int maxValue, std::vector<bool>& values, bool& restricted);
+  std::vector<bool> minutes;
+  std::vector<bool> hours;
+  std::vector<bool> daysOfMonth;
+  std::vector<bool> months;
+  std::vector<bool> daysOfWeek;
+  bool domRestricted;
+  bool dowRestricted;
+  bool set;
+};
+
+} // namespace murmure
+
+#endif
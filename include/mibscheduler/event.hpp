@@ -24,24 +24,117 @@
 #ifndef EVENT_HPP
 #define EVENT_HPP
 
+#include <mibscheduler/cronschedule.hpp>
+#include <mibscheduler/eventmetrics.hpp>
 #include <mibscheduler/eventmode.hpp>
+#include <mibscheduler/eventoptions.hpp>
+#include <utils/process.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace murmure {
+
+class Mibtable;
+
+//Result of a trigger passed through the event debounce
+enum class TriggerResult {
+  RUN,      //Execute now
+  DEFER,    //Execute later (at the returned time)
+  SUPPRESS  //Do not execute (merged into a pending execution or dropped)
+};
+
+//Command => result of its execution; shared by events executed in the same scheduler tick
+typedef std::map<std::string, process::execResult> CommandResults;
+
+//Behaviour of AUTO events while their OID is not read
+enum class IdleMode {
+  SUSPEND, //Executions are skipped
+  STRETCH  //Executions are spaced out
+};
+
 class Event {
 public:
   Event(const std::string& oid, EventMode evMode, const std::vector<std::string>& commandList);
-  int executeCommands();
+  int executeCommands(const std::string& value = "", const std::string& triggerOid = "", CommandResults* sharedResults = nullptr);
+  int getId();
+  void setId(int eventId);
   std::string getOid();
   EventMode getMode();
   std::string getModeName();
   std::vector<std::string> getCommandList();
+  EventOptions getOptions();
+  bool setOption(const std::string& name, const std::string& value, std::string& error);
+  //Debounce
+  TriggerResult trigger(const std::string& value, const std::string& triggerOid, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& deferUntil);
+  bool complete(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& deferUntil);
+  std::string takePendingValue(std::string& triggerOid);
+  //Binding
+  bool isSubtree();
+  //Startup ordering (INIT)
+  std::vector<std::string> getAfter();
+  //Lifetime
+  void pin();
+  void unpin();
+  bool isBusy();
+  //Freshness
+  bool hasFreshness();
+  std::chrono::milliseconds getMaxAge();
+  std::chrono::milliseconds getGrace();
+  std::chrono::milliseconds getDeadline();
+  //Execution
+  EventMetrics takeMetrics();
+  static void setDefaultExecTimeout(int timeout);
+  static void setMibtable(Mibtable* mTable);
+  static uint64_t getRequestFailures();
 
 protected:
+  int eventId; //ID in scheduled_events table
   std::string oid;
   EventMode mode;
   std::vector<std::string> commandList;
+  EventOptions options;
+  bool subtree; //Bound to OID prefix
+  std::vector<std::string> after; //OIDs whose INIT events must complete before this one
+  //Debounce settings
+  std::chrono::milliseconds minInterval;
+  bool trailing;
+  bool coalesce;
+  //Freshness settings
+  bool freshness;
+  std::chrono::milliseconds maxAge;
+  std::chrono::milliseconds grace;
+  std::chrono::milliseconds deadline;
+  //Schedule settings (AUTO)
+  int phase;
+  int jitter;
+  CronSchedule cron;
+  int idle; //Idle window (s); 0 if executions don't depend on reads
+  IdleMode idleMode;
+  bool share; //Command results can be shared with other events (output doesn't depend on the OID)
+  //Execution settings
+  std::chrono::milliseconds execTimeout;
+  std::chrono::milliseconds killGrace;
+  static std::chrono::milliseconds defaultExecTimeout;
+  static Mibtable* mibtable; //Target of builtin actions
+  static std::atomic<uint64_t> requestFailures; //Failed executions of GET and SET events
+  //Metrics recorded since last takeMetrics
+  std::mutex metricsMutex;
+  EventMetrics metrics;
+  //Trigger state
+  std::mutex stateMutex;
+  std::chrono::steady_clock::time_point lastRun;
+  bool hasRun;
+  int inFlight;         //Executions currently running
+  bool rerunPending;    //A trigger arrived while running (coalesce)
+  bool deferredPending; //A deferred execution is queued in the scheduler
+  std::string pendingValue;
+  std::string pendingOid;
+  int pins;             //Users holding the event outside of the scheduler lists
 };
 } // namespace murmure
 
@@ -0,0 +1,57 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef EVENTMETRICS_HPP
+#define EVENTMETRICS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+//Histogram of execution durations; bucket upper bounds in ms (last bucket is unbounded)
+#define METRICS_HISTOGRAM_BUCKETS 8
+#define METRICS_HISTOGRAM_BOUNDS {10, 50, 100, 500, 1000, 5000, 30000}
+
+namespace murmure {
+
+class EventMetrics {
+public:
+  EventMetrics();
+  void record(std::chrono::milliseconds duration, bool failed, bool timedOut, bool coalesced = false);
+  void merge(const EventMetrics& metrics);
+  void reset();
+  std::string getHistogram() const;
+  bool setHistogram(const std::string& histogram);
+  uint64_t runs;
+  uint64_t failures;
+  uint64_t timeouts;
+  uint64_t coalesced;     //Runs which shared command results with other events
+  uint64_t lastDuration;  //ms
+  uint64_t totalDuration; //ms
+  uint64_t maxDuration;   //ms
+  uint64_t histogram[METRICS_HISTOGRAM_BUCKETS];
+};
+
+} // namespace murmure
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef EVENTOPTIONS_HPP
+#define EVENTOPTIONS_HPP
+
+#include <map>
+#include <string>
+
+//Trigger options
+#define EVENTOPTION_DEBOUNCE "debounce" //Minimum interval between two executions (ms)
+#define EVENTOPTION_TRAILING "trailing" //Execute once more after debounce interval if triggers were suppressed (0/1)
+#define EVENTOPTION_COALESCE "coalesce" //At most one execution in flight; triggers meanwhile are queued into one rerun (0/1)
+//Binding options (GET and SET events)
+#define EVENTOPTION_SUBTREE "subtree" //Trigger the event for any OID beneath the event OID too (0/1)
+//Startup options (INIT events)
+#define EVENTOPTION_AFTER "after" //Run after the INIT events of these OIDs have completed (comma separated)
+//Freshness options (GET events)
+#define EVENTOPTION_MAXAGE "maxage"     //Value younger than maxage is served without refresh (ms)
+#define EVENTOPTION_GRACE "grace"       //Value stale by less than grace is served while refreshed asynchronously (ms)
+#define EVENTOPTION_DEADLINE "deadline" //Maximum time to wait for a refresh beyond grace (ms)
+
+//Execution options
+#define EVENTOPTION_EXECTIMEOUT "exectimeout" //Maximum execution time of the command list; overrides global timeout (ms)
+#define EVENTOPTION_KILLGRACE "killgrace"     //Time between SIGTERM and SIGKILL when execution times out (ms)
+
+//Schedule options (AUTO events)
+#define EVENTOPTION_PHASE "phase"   //Offset of executions inside the timeout period (s)
+#define EVENTOPTION_JITTER "jitter" //Maximum deterministic delay added to each execution (s)
+#define EVENTOPTION_CRON "cron"     //Cron expression used instead of timeout (minute hour dom month dow)
+#define EVENTOPTION_IDLE "idle"     //Window after which an OID which is not read is considered idle (s)
+#define EVENTOPTION_IDLEMODE "idlemode" //What to do while OID is idle (suspend/stretch)
+#define EVENTOPTION_SHARE "share"   //Share command results with the other sharing events due at the same time (0/1)
+
+#define IDLEMODE_SUSPEND "suspend" //Skip executions until OID is read again
+#define IDLEMODE_STRETCH "stretch" //Double the period at each execution, up to the idle window
+
+#define DEFAULT_REFRESH_DEADLINE 1000
+#define DEFAULT_EXEC_TIMEOUT 0 //No timeout
+
+namespace murmure {
+
+//Option name => option value, as stored in events_options table
+typedef std::map<std::string, std::string> EventOptions;
+
+} /* namespace murmure */
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * Murmure event plugin C ABI
+ * A plugin is a shared object exporting one or more hook functions with the murmure_hook signature.
+ * Hooks are referenced in the scheduling as '@plugin /path/to/plugin.so:hook_name' and are called
+ * in-process every time the event is executed, with the same semantics of a command.
+ * NOTE: hooks can be called concurrently by different threads
+**/
+
+#ifndef MURMUREPLUGIN_H
+#define MURMUREPLUGIN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MURMURE_PLUGIN_ABI_VERSION 1
+
+//Event modes
+#define MURMURE_EVENT_GET 0
+#define MURMURE_EVENT_SET 1
+#define MURMURE_EVENT_AUTO 2
+#define MURMURE_EVENT_INIT 3
+
+//Hook return values; any other value is a failure
+#define MURMURE_HOOK_OK 0       //Success
+#define MURMURE_HOOK_SETVALUE 1 //Success; new_value has been filled and has to be set to the OID
+
+//Maximum length of new_value (including terminator)
+#define MURMURE_VALUE_MAX_LENGTH 4096
+
+typedef struct {
+  unsigned int abi_version; //MURMURE_PLUGIN_ABI_VERSION
+  const char* oid;          //OID the event is associated to
+  int mode;                 //MURMURE_EVENT_*
+  const char* value;        //Value which triggered the event (SET); empty string otherwise
+  char* new_value;          //Buffer where the hook can write a new value for the OID
+  size_t new_value_size;    //Size of new_value buffer
+} murmure_event;
+
+typedef int (*murmure_hook)(murmure_event* event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,6 +26,7 @@
 
 #include <mibscheduler/event.hpp>
 #include <mibscheduler/eventmode.hpp>
+#include <ctime>
 #include <string>
 #include <vector>
 
@@ -33,22 +34,30 @@ namespace murmure {
 class ScheduledEvent : public Event {
 public:
   ScheduledEvent(const std::string& oid, EventMode evMode, const std::vector<std::string>& commandList, int timeout);
-  int executeCommands();
-  int calcRelativeTimeout(time_t elapsedTime);
+  int executeCommands(CommandResults* sharedResults = nullptr);
+  time_t schedule(time_t elapsedTime, time_t wallTime);
+  bool checkSchedule(std::string& error);
   std::string getOid();
   EventMode getMode();
   std::string getModeName();
   std::vector<std::string> getCommandList();
   int getTimeout();
-  int getRelativeTimeout();
+  time_t getNextRun();
+  //Demand-driven executions
+  int getIdle();
+  bool admit(time_t elapsedTime, bool idle);
+  bool isSuspended();
 
 private:
+  int jitterDelay(uint64_t runIndex);
   int timeout;
-  int relativeTimeout;
+  time_t nextRun;  //Seconds since scheduler start; -1 if not scheduled
+  time_t lastExec; //Seconds since scheduler start of last admitted execution; -1 if never executed
+  int stretch;     //Current period (s) while idle (stretch mode); 0 if not stretched
+  bool suspended;  //Executions are being skipped, since OID is idle (suspend mode)
 };
 
 bool sortByTimeout(ScheduledEvent* firstEv, ScheduledEvent* secondEv);
-bool sortByRelativeTimeout(ScheduledEvent* firstEv, ScheduledEvent* secondEv);
 
 } // namespace murmure
 
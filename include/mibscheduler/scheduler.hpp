@@ -24,11 +24,23 @@
 #ifndef SCHEDULER_HPP
 #define SCHEDULER_HPP
 
+#include <mibscheduler/clock.hpp>
 #include <mibscheduler/event.hpp>
 #include <mibscheduler/scheduledevent.hpp>
 #include <core/mibtable.hpp>
 
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
 #include <thread>
+#include <unordered_map>
+
+#define METRICS_FLUSH_INTERVAL 60 //Seconds between two metrics flushes to database
+#define INIT_WORKERS 4            //Threads executing INIT events at startup
 
 namespace murmure {
 
@@ -39,21 +51,67 @@ public:
   ~Scheduler();
   bool loadEvents();
   int fetchAndExec(const std::string& oid, EventMode mode);
+  int fetchAndExec(Oid* oid, EventMode mode, const std::string& value = "", const std::string& triggerOid = "");
+  int refresh(Oid* oid);
+  bool hasEvents(Oid* oid, EventMode mode);
   bool startScheduler();
   //Scheduler setups
-  bool parseScheduling(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, std::string& error, int timeout = 0);
+  bool parseScheduling(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, std::string& error, int timeout = 0, const EventOptions& options = EventOptions());
   bool parseScheduling(const std::string& filename, std::string& error);
   bool clearEvents();
   bool dumpScheduling(const std::string& dumpFile = "");
+  bool dumpMetrics(const std::string& dumpFile = "");
+  static void setExecTimeout(int timeout);
+  static void requestReload();
+  static void setClock(Clock* clock);
+  void adoptEvent(ScheduledEvent* event);
 
 private:
   static int runScheduler();
-  bool addEvent(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, int timeout = 0);
+  static void buildTimeline(std::multimap<time_t, ScheduledEvent*>& timeline, time_t elapsedTime);
+  static bool isIdle(ScheduledEvent* event, std::chrono::steady_clock::time_point since);
+  static int runDispatcher();
+  static int runInitEvents(std::vector<Event*> initEvents);
+  static bool isInitPending(const std::string& oid);
+  static void flushMetrics();
+  static bool readEvents(std::vector<Event*>& eventList, std::vector<ScheduledEvent*>& scheduledEventList);
+  static bool reloadEvents();
+  static void reapEvents();
+  static std::vector<Event*> pinEvents(Oid* oid, EventMode mode);
+  static void unpinEvents(const std::vector<Event*>& eventList);
+  static int triggerEvent(Event* event, const std::string& value, const std::string& triggerOid);
+  static void deferEvent(Event* event, std::chrono::steady_clock::time_point when);
+  static void requestRefresh(Oid* oid);
+  static void refreshOid(Oid* oid);
+  bool addEvent(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, std::string& error, int timeout = 0, const EventOptions& options = EventOptions());
+  bool addEventOptions(const std::string& eventId, const EventOptions& options, std::string& error);
+  static bool loadEventOptions(Event* event, const std::string& eventId);
+  static void bindEvent(Event* event);
+  static void unbindEvent(Event* event);
   static std::vector<Event*> events;
   static std::vector<ScheduledEvent*> scheduledEvents;
-  Mibtable* mibtable;
+  static Mibtable* mibtable;
+  static Clock* schedulerClock; //Time source of the scheduler thread
   static std::thread* schedulerThread;
   static bool stopCalled;
+  //Deferred (debounced) executions
+  static std::multimap<std::chrono::steady_clock::time_point, Event*> deferredEvents;
+  static std::mutex dispatchMutex;
+  static std::condition_variable dispatchCondition;
+  static std::thread* dispatcherThread;
+  //Asynchronous OID refreshes (stale-while-revalidate)
+  static std::deque<Oid*> refreshQueue;
+  static std::set<Oid*> refreshingOids;
+  static std::condition_variable refreshCondition;
+  //Hot reload
+  static volatile std::sig_atomic_t reloadRequested;
+  static std::mutex eventsMutex; //Guards events bound to OIDs
+  static std::unordered_map<uint64_t, std::vector<Event*>> subtreeEvents; //OID prefix key => subtree events
+  static std::vector<Event*> retiredEvents;
+  //Startup (INIT events run in background)
+  static std::thread* initThread;
+  static std::multiset<std::string> pendingInits; //OIDs whose INIT events haven't completed yet
+  static std::mutex initMutex;
 };
 } // namespace murmure
 
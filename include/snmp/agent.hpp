@@ -0,0 +1,80 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef SNMP_AGENT_HPP
+#define SNMP_AGENT_HPP
+
+#include <core/accessmode.hpp>
+#include <core/settransaction.hpp>
+#include <mibscheduler/scheduler.hpp>
+#include <snmp/ber.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#define DEFAULT_SNMP_ADDRESS "127.0.0.1"
+#define DEFAULT_SNMP_PORT 161
+#define DEFAULT_SNMP_COMMUNITY "public"
+#define SNMP_POLL_INTERVAL 1000     //Max time a stop request waits (ms)
+#define SNMP_RECEIVE_BATCH 32       //Datagrams received (and answered) per system call
+#define SNMP_MAX_BULK_VARBINDS 2048 //GetBulk responses are cut at this amount of varbinds
+#define SNMP_WALK_CURSORS 64        //Walk cursors per receiving thread; managers are spread among them by address
+
+namespace murmure {
+namespace snmp {
+
+//Standalone SNMPv2c agent
+class Agent {
+
+public:
+  Agent(Mibtable* mibtable, Scheduler* scheduler);
+  bool addCommunity(const std::string& spec, std::string& error);
+  bool run(const std::string& endpoint, int threads, std::string& error);
+  static void requestStop();
+
+private:
+  int openSocket(const std::string& address, int port, bool reusePort, std::string& error);
+  void receive(int sockFd);
+  bool handleMessage(const char* data, size_t length, message& request, BerWriter& writer, SetTransaction& transaction, walkCursor& cursor);
+  void get(message& request);
+  void getNext(message& request, walkCursor& cursor);
+  void getBulk(message& request);
+  void set(message& request, AccessMode access, SetTransaction& transaction);
+  bool encodeValue(Oid* oid, varbind& binding);
+  Mibtable* mibtable;
+  Scheduler* scheduler;
+  std::unordered_map<std::string, AccessMode> communities; //Community => granted access
+  std::mutex setMutex;                                      //SET requests are applied one at a time
+  std::atomic<uint64_t> served;
+  std::atomic<uint64_t> badCommunities;
+  std::atomic<uint64_t> malformed;
+  static volatile sig_atomic_t stopRequested;
+};
+
+} // namespace snmp
+} // namespace murmure
+
+#endif
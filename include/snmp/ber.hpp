@@ -0,0 +1,116 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef SNMP_BER_HPP
+#define SNMP_BER_HPP
+
+#include <core/varbind.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//SNMP messages (RFC 3416), Basic Encoding Rules
+#define SNMP_VERSION_1 0
+#define SNMP_VERSION_2C 1
+#define SNMP_MAX_MESSAGE 65507 //Max UDP payload
+
+//Universal tags
+#define BER_INTEGER 0x02
+#define BER_OCTETSTRING 0x04
+#define BER_NULL 0x05
+#define BER_OBJECTIDENTIFIER 0x06
+#define BER_SEQUENCE 0x30
+
+namespace murmure {
+namespace snmp {
+
+enum class PduType : uint8_t {
+  GET = 0xA0,
+  GETNEXT = 0xA1,
+  RESPONSE = 0xA2,
+  SET = 0xA3,
+  GETBULK = 0xA5,
+  INFORM = 0xA6,
+  TRAP = 0xA7,
+  REPORT = 0xA8
+};
+
+typedef struct {
+  int32_t version;
+  std::string community;
+  PduType type;
+  int32_t requestId;
+  int32_t errorStatus; //Non repeaters in GetBulk
+  int32_t errorIndex;  //Max repetitions in GetBulk
+  std::vector<varbind> varbinds;
+} message;
+
+//Decodes BER elements from a buffer
+class BerReader {
+public:
+  BerReader(const char* data, size_t length);
+  bool readHeader(uint8_t& tag, size_t& length);
+  bool readInteger(int64_t& value);
+  bool readUnsigned(uint8_t tag, uint64_t& value);
+  bool readOctets(uint8_t tag, std::string& octets);
+  bool readOid(std::string& oid);
+  bool readVarbind(varbind& binding);
+  bool enter(uint8_t tag, BerReader& inner);
+  bool atEnd();
+
+private:
+  const char* data;
+  size_t length;
+  size_t position;
+};
+
+//Encodes BER elements; constructed elements are opened and closed around their content
+class BerWriter {
+public:
+  BerWriter();
+  void clear();
+  size_t open(uint8_t tag);
+  void close(size_t mark);
+  void writeInteger(uint8_t tag, int64_t value);
+  void writeUnsigned(uint8_t tag, uint64_t value);
+  void writeOctets(uint8_t tag, const std::string& octets);
+  void writeNull(uint8_t tag);
+  void writeOid(const std::string& oid);
+  void writeVarbind(const varbind& binding);
+  size_t size();
+  void truncate(size_t size);
+  const std::string& getBuffer();
+
+private:
+  std::string buffer; //Reused across messages
+};
+
+bool decodeMessage(const char* data, size_t length, message& request);
+size_t encodeMessage(BerWriter& writer, const message& response, size_t maxSize = SNMP_MAX_MESSAGE);
+
+} // namespace snmp
+} // namespace murmure
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef TESTS_CHECK_HPP
+#define TESTS_CHECK_HPP
+
+#include <iostream>
+
+//Minimal assertions for unit tests (make check): failures are reported and counted, the test goes on
+#define CHECK(condition) tests::check((condition), #condition, __FILE__, __LINE__)
+
+namespace tests {
+
+static int failures = 0;
+static int checks = 0;
+
+/**
+ * @function check
+ * @description record the outcome of a check; failed ones are reported on stderr
+ * @param bool: check outcome
+ * @param const char* checked expression
+ * @param const char* source file
+ * @param int source line
+ * @returns bool: check outcome
+**/
+
+inline bool check(bool passed, const char* expression, const char* file, int line) {
+  checks++;
+  if (!passed) {
+    failures++;
+    std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+  }
+  return passed;
+}
+
+/**
+ * @function report
+ * @description print the checks summary
+ * @param const char* test name
+ * @returns int: test exit code (0 if all checks passed)
+**/
+
+inline int report(const char* name) {
+  std::cout << name << ": " << checks - failures << "/" << checks << " checks passed" << std::endl;
+  return failures == 0 ? 0 : 1;
+}
+
+} // namespace tests
+
+#endif
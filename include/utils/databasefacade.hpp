@@ -27,6 +27,8 @@
 #define Q(x) #x
 #define QUOTE(x) Q(x)
 
+#define DATABASE_BUSY_TIMEOUT 5000 //Time a statement waits for other processes' locks (ms)
+
 #include <vector>
 #include <string>
 
@@ -34,7 +36,11 @@ namespace database {
 
 void init(const std::string& dbPath);
 bool exec(std::string query, std::string& error);
+bool execBatch(const std::vector<std::string>& queries, std::string& error);
 bool select(std::vector<std::vector<std::string>>* result, std::string query, std::string& error);
+bool begin(std::string& error);
+bool commit(std::string& error);
+bool rollback(std::string& error);
 
 }
 
@@ -33,14 +33,19 @@ namespace murmure {
 
 enum class Command {
   DAEMON,
+  AGENTX,
+  SNMP_AGENT,
   GET,
   SET,
   GET_NEXT,
+  WALK,
   PARSE_MIB,
   SCHEDULE,
   DUMP_SCHEDULE,
+  DUMP_METRICS,
   RESET,
   CHANGE,
+  BATCH,
   HELP
 };
 
@@ -53,6 +58,18 @@ typedef struct {
   bool dbPathSet = false;
   int logLevel;
   bool logLevelSet = false;
+  int execTimeout;
+  bool execTimeoutSet = false;
+  std::vector<std::string> execClasses; //Execution classes specifications (-Q)
+  std::string socketPath;
+  bool socketPathSet = false;
+  int workers;
+  bool workersSet = false;
+  std::vector<std::string> communities; //SNMP communities specifications (-c)
+  int snmpThreads;
+  bool snmpThreadsSet = false;
+  std::string ingestPath; //Ingestion ring file (--ingest); empty for default
+  bool ingestSet = false;
 } options;
 
 bool getOpts(options* optStruct, int argc, char* argv[], std::string& error);
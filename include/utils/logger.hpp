@@ -24,6 +24,8 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <atomic>
+#include <ctime>
 #include <string>
 
 #define LOG_DEBUG 5
@@ -40,6 +42,22 @@ extern int logLevel;
 
 void log(const std::string& component, int level, const std::string& logContent);
 
+//Admits at most a burst of messages of a kind per interval; suppressed messages are counted and reported when the next interval starts
+class RateLimit {
+public:
+  RateLimit(const std::string& component, int level, unsigned burst, unsigned interval);
+  bool admit();
+
+private:
+  std::string component;
+  int level;
+  unsigned burst;
+  time_t interval;
+  std::atomic<time_t> windowStart;
+  std::atomic<unsigned> admitted;
+  std::atomic<unsigned> suppressed;
+};
+
 } // namespace logger
 
 #endif
@@ -0,0 +1,75 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef PROCESS_HPP
+#define PROCESS_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define DEFAULT_KILL_GRACE 2000 //Time between SIGTERM and SIGKILL (ms)
+#define MAX_COMMAND_OUTPUT 4096 //Max amount of bytes of command output which is kept
+
+//Execution classes
+#define EXECCLASS_REQUEST "request"
+#define EXECCLASS_BACKGROUND "background"
+#define DEFAULT_BACKGROUND_SLOTS 0       //Concurrent background executions (0: unlimited)
+#define DEFAULT_BACKGROUND_NICENESS 0    //Nice increment of background commands
+#define DEFAULT_BACKGROUND_IOPRIORITY -1 //Best-effort I/O priority of background commands (-1: inherited)
+
+namespace process {
+
+//Commands are executed in classes, each with its own queue, limits and priority
+enum class ExecClass {
+  REQUEST,   //Triggered by SNMP requests (GET and SET events); ordered by deadline
+  BACKGROUND //Scheduled work (AUTO and INIT events); ordered by arrival
+};
+
+typedef struct {
+  int slots;      //Max concurrent executions; 0 for unlimited
+  int niceness;   //Nice increment of commands
+  int ioPriority; //Best-effort I/O priority of commands (0 highest, 7 lowest); -1 to inherit
+} classSettings;
+
+typedef struct {
+  int exitCode = -1;      //Exit code if exited; -1 otherwise
+  bool signaled = false;  //Terminated by a signal
+  bool timedOut = false;  //Killed because of timeout
+  std::chrono::milliseconds duration;
+  std::string output;     //Command stdout and stderr (truncated to MAX_COMMAND_OUTPUT)
+} execResult;
+
+//Replaces command execution (e.g. in benchmarks); returns whether command has been executed
+typedef bool (*runHook)(const std::string& command, const std::vector<std::string>& environment, execResult& result, std::string& error);
+
+bool startExecutor(std::string& error);
+void stopExecutor();
+bool configureClass(const std::string& spec, std::string& error);
+void setClassSettings(ExecClass execClass, const classSettings& settings);
+void setRunHook(runHook hook);
+bool run(const std::string& command, const std::vector<std::string>& environment, int timeout, int killGrace, execResult& result, std::string& error, ExecClass execClass = ExecClass::BACKGROUND, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+} // namespace process
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#ifndef RWLOCK_HPP
+#define RWLOCK_HPP
+
+#include <pthread.h>
+
+namespace murmure {
+
+//Reader/writer lock (std::shared_mutex is not available in C++11)
+class RWLock {
+public:
+  RWLock();
+  ~RWLock();
+  void lockShared();
+  void unlockShared();
+  void lock();
+  void unlock();
+
+private:
+  RWLock(const RWLock&) = delete;
+  RWLock& operator=(const RWLock&) = delete;
+  pthread_rwlock_t rwlock;
+};
+
+//Holds a RWLock in shared mode for its scope
+class ReadGuard {
+public:
+  explicit ReadGuard(RWLock& lock);
+  ~ReadGuard();
+
+private:
+  RWLock& rwlock;
+};
+
+//Holds a RWLock in exclusive mode for its scope
+class WriteGuard {
+public:
+  explicit WriteGuard(RWLock& lock);
+  ~WriteGuard();
+
+private:
+  RWLock& rwlock;
+};
+
+} // namespace murmure
+
+#endif
@@ -0,0 +1,467 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <agentx/pdu.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace murmure {
+namespace agentx {
+
+//Internet prefix (1.3.6.1) which can be compressed in OIDs
+static const uint32_t internetPrefix[] = {1, 3, 6, 1};
+
+/**
+ * @function decodeUint32
+ * @description decode a 32 bit integer
+ * @param const char* data
+ * @param bool: big endian if true; little endian otherwise
+ * @returns uint32_t
+**/
+
+static uint32_t decodeUint32(const char* data, bool networkOrder) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  if (networkOrder) {
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+  }
+  return (static_cast<uint32_t>(bytes[3]) << 24) | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[1]) << 8) | bytes[0];
+}
+
+/**
+ * @function parseOid
+ * @description split a dotted OID string into sub-identifiers
+ * @param std::string oid
+ * @param std::vector<uint32_t>& sub-identifiers
+**/
+
+static void parseOid(const std::string& oid, std::vector<uint32_t>& subids) {
+  subids.clear();
+  size_t position = 0;
+  while (position < oid.length()) {
+    if (oid[position] == '.') {
+      position++;
+      continue;
+    }
+    uint32_t subid = 0;
+    while (position < oid.length() && oid[position] != '.') {
+      subid = subid * 10 + (oid[position++] - '0');
+    }
+    subids.push_back(subid);
+  }
+}
+
+/**
+ * @function readHeader
+ * @description decode PDU header
+ * @param const char* data, at least AGENTX_HEADER_SIZE bytes
+ * @param pduHeader& header
+ * @returns bool: false if version is not supported
+**/
+
+bool readHeader(const char* data, pduHeader& header) {
+  if (static_cast<uint8_t>(data[0]) != AGENTX_VERSION) {
+    return false;
+  }
+  header.type = static_cast<PduType>(data[1]);
+  header.flags = static_cast<uint8_t>(data[2]);
+  bool networkOrder = (header.flags & AGENTX_FLAG_NETWORK_BYTE_ORDER) != 0;
+  header.sessionId = decodeUint32(data + 4, networkOrder);
+  header.transactionId = decodeUint32(data + 8, networkOrder);
+  header.packetId = decodeUint32(data + 12, networkOrder);
+  header.payloadLength = decodeUint32(data + 16, networkOrder);
+  return true;
+}
+
+/**
+ * @function PduReader
+ * @description PduReader class constructor
+ * @param const char* payload
+ * @param size_t payload length
+ * @param bool: payload is in network byte order
+**/
+
+PduReader::PduReader(const char* payload, size_t length, bool networkOrder) {
+  this->payload = payload;
+  this->length = length;
+  this->position = 0;
+  this->networkOrder = networkOrder;
+}
+
+/**
+ * @function readUint8
+ * @description read a byte
+ * @param uint8_t& value
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readUint8(uint8_t& value) {
+  if (position + 1 > length) {
+    return false;
+  }
+  value = static_cast<uint8_t>(payload[position++]);
+  return true;
+}
+
+/**
+ * @function readUint16
+ * @description read a 16 bit integer
+ * @param uint16_t& value
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readUint16(uint16_t& value) {
+  if (position + 2 > length) {
+    return false;
+  }
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(payload + position);
+  value = networkOrder ? (bytes[0] << 8) | bytes[1] : (bytes[1] << 8) | bytes[0];
+  position += 2;
+  return true;
+}
+
+/**
+ * @function readUint32
+ * @description read a 32 bit integer
+ * @param uint32_t& value
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readUint32(uint32_t& value) {
+  if (position + 4 > length) {
+    return false;
+  }
+  value = decodeUint32(payload + position, networkOrder);
+  position += 4;
+  return true;
+}
+
+/**
+ * @function readUint64
+ * @description read a 64 bit integer
+ * @param uint64_t& value
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readUint64(uint64_t& value) {
+  uint32_t first;
+  uint32_t second;
+  if (!readUint32(first) || !readUint32(second)) {
+    return false;
+  }
+  value = networkOrder ? (static_cast<uint64_t>(first) << 32) | second : (static_cast<uint64_t>(second) << 32) | first;
+  return true;
+}
+
+/**
+ * @function readOid
+ * @description read an object identifier
+ * @param std::string& dotted OID; empty for null OID
+ * @param bool& include field
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readOid(std::string& oid, bool& include) {
+  uint8_t subidAmount;
+  uint8_t prefix;
+  uint8_t includeField;
+  uint8_t reserved;
+  if (!readUint8(subidAmount) || !readUint8(prefix) || !readUint8(includeField) || !readUint8(reserved)) {
+    return false;
+  }
+  include = includeField != 0;
+  oid.clear();
+  if (prefix != 0) {
+    oid = ".1.3.6.1." + std::to_string(prefix);
+  }
+  for (uint8_t i = 0; i < subidAmount; i++) {
+    uint32_t subid;
+    if (!readUint32(subid)) {
+      return false;
+    }
+    oid += '.';
+    oid += std::to_string(subid);
+  }
+  return true;
+}
+
+/**
+ * @function readOctets
+ * @description read an octet string (padded to 4 bytes)
+ * @param std::string& octets
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readOctets(std::string& octets) {
+  uint32_t octetsLength;
+  if (!readUint32(octetsLength) || octetsLength > length - position) {
+    return false;
+  }
+  octets.assign(payload + position, octetsLength);
+  return skip((octetsLength + 3) & ~3u);
+}
+
+/**
+ * @function readSearchRange
+ * @description read a search range
+ * @param searchRange& range
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::readSearchRange(searchRange& range) {
+  bool endInclude;
+  return readOid(range.start, range.include) && readOid(range.end, endInclude);
+}
+
+/**
+ * @function readVarbind
+ * @description read a variable binding
+ * @param varbind& binding
+ * @returns bool: false if payload is truncated or type is unknown
+**/
+
+bool PduReader::readVarbind(varbind& binding) {
+  uint16_t type;
+  uint16_t reserved;
+  bool include;
+  if (!readUint16(type) || !readUint16(reserved) || !readOid(binding.oid, include)) {
+    return false;
+  }
+  binding.type = static_cast<VarbindType>(type);
+  binding.number = 0;
+  binding.data.clear();
+  uint32_t number;
+  switch (binding.type) {
+  case VarbindType::INTEGER:
+  case VarbindType::COUNTER32:
+  case VarbindType::GAUGE32:
+  case VarbindType::TIMETICKS:
+    if (!readUint32(number)) {
+      return false;
+    }
+    binding.number = number;
+    return true;
+  case VarbindType::COUNTER64:
+    return readUint64(binding.number);
+  case VarbindType::OCTETSTRING:
+  case VarbindType::IPADDRESS:
+  case VarbindType::OPAQUE:
+    return readOctets(binding.data);
+  case VarbindType::OBJECTIDENTIFIER:
+    return readOid(binding.data, include);
+  case VarbindType::NULLVALUE:
+  case VarbindType::NOSUCHOBJECT:
+  case VarbindType::NOSUCHINSTANCE:
+  case VarbindType::ENDOFMIBVIEW:
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @function skip
+ * @description skip bytes
+ * @param size_t amount of bytes
+ * @returns bool: false if payload is truncated
+**/
+
+bool PduReader::skip(size_t skipLength) {
+  if (skipLength > length - position) {
+    return false;
+  }
+  position += skipLength;
+  return true;
+}
+
+/**
+ * @function atEnd
+ * @description returns whether the whole payload has been read
+ * @returns bool
+**/
+
+bool PduReader::atEnd() {
+  return position >= length;
+}
+
+/**
+ * @function PduWriter
+ * @description PduWriter class constructor
+**/
+
+PduWriter::PduWriter() {
+}
+
+/**
+ * @function begin
+ * @description start a new PDU
+ * @param PduType
+ * @param uint8_t flags; network byte order flag is always added
+ * @param uint32_t session id
+ * @param uint32_t transaction id
+ * @param uint32_t packet id
+**/
+
+void PduWriter::begin(PduType type, uint8_t flags, uint32_t sessionId, uint32_t transactionId, uint32_t packetId) {
+  buffer.clear();
+  writeUint8(AGENTX_VERSION);
+  writeUint8(static_cast<uint8_t>(type));
+  writeUint8(flags | AGENTX_FLAG_NETWORK_BYTE_ORDER);
+  writeUint8(0);
+  writeUint32(sessionId);
+  writeUint32(transactionId);
+  writeUint32(packetId);
+  writeUint32(0); //Payload length, set by finish
+}
+
+/**
+ * @function finish
+ * @description complete PDU setting its payload length
+ * @returns const std::string&: encoded PDU, valid until next begin
+**/
+
+const std::string& PduWriter::finish() {
+  uint32_t payloadLength = static_cast<uint32_t>(buffer.length() - AGENTX_HEADER_SIZE);
+  buffer[16] = static_cast<char>(payloadLength >> 24);
+  buffer[17] = static_cast<char>(payloadLength >> 16);
+  buffer[18] = static_cast<char>(payloadLength >> 8);
+  buffer[19] = static_cast<char>(payloadLength);
+  return buffer;
+}
+
+/**
+ * @function writeUint8
+ * @description append a byte
+ * @param uint8_t
+**/
+
+void PduWriter::writeUint8(uint8_t value) {
+  buffer += static_cast<char>(value);
+}
+
+/**
+ * @function writeUint16
+ * @description append a 16 bit integer
+ * @param uint16_t
+**/
+
+void PduWriter::writeUint16(uint16_t value) {
+  buffer += static_cast<char>(value >> 8);
+  buffer += static_cast<char>(value);
+}
+
+/**
+ * @function writeUint32
+ * @description append a 32 bit integer
+ * @param uint32_t
+**/
+
+void PduWriter::writeUint32(uint32_t value) {
+  buffer += static_cast<char>(value >> 24);
+  buffer += static_cast<char>(value >> 16);
+  buffer += static_cast<char>(value >> 8);
+  buffer += static_cast<char>(value);
+}
+
+/**
+ * @function writeUint64
+ * @description append a 64 bit integer
+ * @param uint64_t
+**/
+
+void PduWriter::writeUint64(uint64_t value) {
+  writeUint32(static_cast<uint32_t>(value >> 32));
+  writeUint32(static_cast<uint32_t>(value));
+}
+
+/**
+ * @function writeOid
+ * @description append an object identifier; the internet prefix is compressed
+ * @param std::string dotted OID; empty for null OID
+ * @param bool include field
+**/
+
+void PduWriter::writeOid(const std::string& oid, bool include /* = false */) {
+  std::vector<uint32_t> subids;
+  parseOid(oid, subids);
+  size_t first = 0;
+  uint8_t prefix = 0;
+  if (subids.size() >= 5 && std::equal(internetPrefix, internetPrefix + 4, subids.begin()) && subids.at(4) > 0 && subids.at(4) <= 0xFF) {
+    prefix = static_cast<uint8_t>(subids.at(4));
+    first = 5;
+  }
+  writeUint8(static_cast<uint8_t>(subids.size() - first));
+  writeUint8(prefix);
+  writeUint8(include ? 1 : 0);
+  writeUint8(0);
+  for (size_t i = first; i < subids.size(); i++) {
+    writeUint32(subids.at(i));
+  }
+}
+
+/**
+ * @function writeOctets
+ * @description append an octet string, padded to 4 bytes
+ * @param std::string octets
+**/
+
+void PduWriter::writeOctets(const std::string& octets) {
+  writeUint32(static_cast<uint32_t>(octets.length()));
+  buffer += octets;
+  buffer.append((4 - octets.length() % 4) % 4, '\0');
+}
+
+/**
+ * @function writeVarbind
+ * @description append a variable binding
+ * @param varbind
+**/
+
+void PduWriter::writeVarbind(const varbind& binding) {
+  writeUint16(static_cast<uint16_t>(binding.type));
+  writeUint16(0);
+  writeOid(binding.oid);
+  switch (binding.type) {
+  case VarbindType::INTEGER:
+  case VarbindType::COUNTER32:
+  case VarbindType::GAUGE32:
+  case VarbindType::TIMETICKS:
+    writeUint32(static_cast<uint32_t>(binding.number));
+    break;
+  case VarbindType::COUNTER64:
+    writeUint64(binding.number);
+    break;
+  case VarbindType::OCTETSTRING:
+  case VarbindType::IPADDRESS:
+  case VarbindType::OPAQUE:
+    writeOctets(binding.data);
+    break;
+  case VarbindType::OBJECTIDENTIFIER:
+    writeOid(binding.data);
+    break;
+  default:
+    break;
+  }
+}
+
+} // namespace agentx
+}
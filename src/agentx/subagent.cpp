@@ -0,0 +1,577 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <agentx/subagent.hpp>
+#include <utils/logger.hpp>
+#include <utils/unixsocket.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <poll.h>
+#include <thread>
+#include <unistd.h>
+
+#define COMPONENT "AgentX"
+
+namespace murmure {
+namespace agentx {
+
+volatile sig_atomic_t Subagent::stopRequested = 0;
+
+/**
+ * @function Subagent
+ * @description Subagent class constructor
+ * @param Mibtable* mibtable served to master agent
+ * @param Scheduler* scheduler which executes GET/SET events
+ * @param std::string master agent socket path
+**/
+
+Subagent::Subagent(Mibtable* mibtable, Scheduler* scheduler, const std::string& masterPath) : transaction(mibtable, scheduler) {
+  this->mibtable = mibtable;
+  this->scheduler = scheduler;
+  this->masterPath = masterPath;
+  this->sockFd = -1;
+  this->sessionId = 0;
+  this->packetId = 0;
+}
+
+/**
+ * @function ~Subagent
+ * @description Subagent class destructor
+**/
+
+Subagent::~Subagent() {
+  if (sockFd >= 0) {
+    close(sockFd);
+  }
+}
+
+/**
+ * @function requestStop
+ * @description make run return; async-signal-safe
+**/
+
+void Subagent::requestStop() {
+  stopRequested = 1;
+}
+
+/**
+ * @function run
+ * @description connect to master agent, register MIB root and serve requests until a stop is requested;
+ * connection is retried every AGENTX_RECONNECT_INTERVAL seconds when master agent is not available
+ * @param std::string& error
+ * @returns bool: false if subagent can't be started
+**/
+
+bool Subagent::run(std::string& error) {
+
+  rootOid = findRoot();
+  if (rootOid.empty()) {
+    error = "MIB table is empty";
+    return false;
+  }
+  bool warned = false;
+  while (!stopRequested) {
+    std::string sessionError;
+    if (!openSession(sessionError)) {
+      //Log once per outage
+      if (!warned) {
+        logger::log(COMPONENT, LOG_WARN, sessionError + "; retrying every " + std::to_string(AGENTX_RECONNECT_INTERVAL) + " seconds");
+        warned = true;
+      }
+      if (sockFd >= 0) {
+        close(sockFd);
+        sockFd = -1;
+      }
+      for (int i = 0; i < AGENTX_RECONNECT_INTERVAL && !stopRequested; i++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+      }
+      continue;
+    }
+    warned = false;
+    logger::log(COMPONENT, LOG_INFO, "Registered " + rootOid + " with master agent " + masterPath + " (session " + std::to_string(sessionId) + ")");
+    serve();
+    if (stopRequested) {
+      closeSession(AGENTX_CLOSE_SHUTDOWN);
+    } else {
+      logger::log(COMPONENT, LOG_WARN, "Session with master agent terminated");
+    }
+    close(sockFd);
+    sockFd = -1;
+    input.clear();
+    transaction.clear();
+    cursor = walkCursor();
+  }
+  return true;
+}
+
+/**
+ * @function openSession
+ * @description connect to master agent, open a session and register MIB root
+ * @param std::string& error
+ * @returns bool
+**/
+
+bool Subagent::openSession(std::string& error) {
+
+  sockFd = unixsocket::connect(masterPath, error);
+  if (sockFd < 0) {
+    return false;
+  }
+  //Open
+  writer.begin(PduType::OPEN, 0, 0, 0, ++packetId);
+  writer.writeUint8(0); //Master agent default timeout
+  writer.writeUint8(0);
+  writer.writeUint16(0);
+  writer.writeOid("");
+  writer.writeOctets("Murmure");
+  if (!request(error)) {
+    error = "Could not open session: " + error;
+    return false;
+  }
+  //Register MIB root
+  writer.begin(PduType::REGISTER, 0, sessionId, 0, ++packetId);
+  writer.writeUint8(0); //Session timeout
+  writer.writeUint8(AGENTX_PRIORITY);
+  writer.writeUint8(0); //No range
+  writer.writeUint8(0);
+  writer.writeOid(rootOid);
+  if (!request(error)) {
+    error = "Could not register " + rootOid + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function request
+ * @description send the PDU in writer and wait for its response; session id is taken from the response
+ * @param std::string& error
+ * @returns bool: true if master agent answered with no error
+**/
+
+bool Subagent::request(std::string& error) {
+
+  if (!sendPdu(writer.finish())) {
+    error = "Could not send PDU";
+    return false;
+  }
+  pduHeader header;
+  std::string payload;
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(AGENTX_RESPONSE_TIMEOUT);
+  while (std::chrono::steady_clock::now() < deadline) {
+    int result = readPdu(header, payload, AGENTX_POLL_INTERVAL);
+    if (result < 0) {
+      error = "Connection closed by master agent";
+      return false;
+    } else if (result == 0 || header.type != PduType::RESPONSE || header.packetId != packetId) {
+      continue;
+    }
+    PduReader reader(payload.data(), payload.length(), (header.flags & AGENTX_FLAG_NETWORK_BYTE_ORDER) != 0);
+    uint32_t sysUpTime;
+    uint16_t responseError;
+    uint16_t index;
+    if (!reader.readUint32(sysUpTime) || !reader.readUint16(responseError) || !reader.readUint16(index)) {
+      error = "Malformed response";
+      return false;
+    }
+    if (responseError != AGENTX_ERR_NOERROR) {
+      error = "master agent error " + std::to_string(responseError);
+      return false;
+    }
+    sessionId = header.sessionId;
+    return true;
+  }
+  error = "No response from master agent";
+  return false;
+}
+
+/**
+ * @function sendPdu
+ * @description write a PDU to master agent
+ * @param std::string encoded PDU
+ * @returns bool
+**/
+
+bool Subagent::sendPdu(const std::string& pdu) {
+  size_t written = 0;
+  while (written < pdu.length()) {
+    ssize_t writtenBytes = write(sockFd, pdu.data() + written, pdu.length() - written);
+    if (writtenBytes < 0 && errno == EINTR) {
+      continue;
+    } else if (writtenBytes <= 0) {
+      return false;
+    }
+    written += writtenBytes;
+  }
+  return true;
+}
+
+/**
+ * @function readPdu
+ * @description read next PDU from master agent
+ * @param pduHeader& header
+ * @param std::string& payload
+ * @param int max time to wait for data (ms)
+ * @returns int: 1 if a PDU has been read; 0 on timeout; -1 if connection is closed or broken
+**/
+
+int Subagent::readPdu(pduHeader& header, std::string& payload, int timeout) {
+
+  while (true) {
+    if (input.length() >= AGENTX_HEADER_SIZE) {
+      if (!readHeader(input.data(), header) || header.payloadLength > AGENTX_MAX_PDU) {
+        logger::log(COMPONENT, LOG_ERROR, "Invalid PDU header from master agent");
+        return -1;
+      }
+      if (input.length() >= AGENTX_HEADER_SIZE + header.payloadLength) {
+        payload.assign(input, AGENTX_HEADER_SIZE, header.payloadLength);
+        input.erase(0, AGENTX_HEADER_SIZE + header.payloadLength);
+        return 1;
+      }
+    }
+    pollfd pollSock;
+    pollSock.fd = sockFd;
+    pollSock.events = POLLIN;
+    int ready = poll(&pollSock, 1, timeout);
+    if (ready == 0 || (ready < 0 && errno == EINTR)) {
+      return 0;
+    } else if (ready < 0) {
+      return -1;
+    }
+    char buffer[65536];
+    ssize_t readBytes = read(sockFd, buffer, sizeof(buffer));
+    if (readBytes < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    } else if (readBytes <= 0) {
+      return -1;
+    }
+    input.append(buffer, readBytes);
+  }
+}
+
+/**
+ * @function serve
+ * @description serve master agent requests until session is closed or a stop is requested
+**/
+
+void Subagent::serve() {
+  pduHeader header;
+  std::string payload;
+  while (!stopRequested) {
+    int result = readPdu(header, payload, AGENTX_POLL_INTERVAL);
+    if (result < 0) {
+      return;
+    } else if (result > 0 && !handlePdu(header, payload)) {
+      return;
+    }
+  }
+}
+
+/**
+ * @function closeSession
+ * @description send Close PDU to master agent
+ * @param uint8_t reason
+**/
+
+void Subagent::closeSession(uint8_t reason) {
+  writer.begin(PduType::CLOSE, 0, sessionId, 0, ++packetId);
+  writer.writeUint8(reason);
+  writer.writeUint8(0);
+  writer.writeUint16(0);
+  sendPdu(writer.finish());
+}
+
+/**
+ * @function handlePdu
+ * @description execute a master agent request and send its response
+ * @param pduHeader
+ * @param std::string payload
+ * @returns bool: false if session has been closed
+**/
+
+bool Subagent::handlePdu(const pduHeader& header, const std::string& payload) {
+
+  PduReader reader(payload.data(), payload.length(), (header.flags & AGENTX_FLAG_NETWORK_BYTE_ORDER) != 0);
+  //Only the default context is registered; a context is ignored
+  std::string context;
+  if ((header.flags & AGENTX_FLAG_NON_DEFAULT_CONTEXT) != 0 && !reader.readOctets(context)) {
+    respond(header, AGENTX_ERR_PARSEERROR, 0, std::vector<varbind>());
+    return true;
+  }
+  std::vector<varbind> varbinds;
+  uint16_t error = AGENTX_ERR_NOERROR;
+  uint16_t index = 0;
+  bool parsed = true;
+  switch (header.type) {
+  case PduType::GET:
+    parsed = get(reader, varbinds);
+    break;
+  case PduType::GETNEXT:
+    parsed = getNext(reader, varbinds);
+    break;
+  case PduType::GETBULK:
+    parsed = getBulk(reader, varbinds);
+    break;
+  case PduType::TESTSET:
+    error = testSet(reader, index);
+    break;
+  case PduType::COMMITSET:
+    error = transaction.commit(index);
+    break;
+  case PduType::UNDOSET:
+    error = transaction.undo(index);
+    break;
+  case PduType::CLEANUPSET:
+    //No response; SET events of committed values are executed
+    transaction.cleanup();
+    return true;
+  case PduType::CLOSE:
+    logger::log(COMPONENT, LOG_INFO, "Session closed by master agent");
+    return false;
+  case PduType::RESPONSE:
+    return true;
+  default:
+    logger::log(COMPONENT, LOG_DEBUG, "Ignoring PDU type " + std::to_string(static_cast<int>(header.type)));
+    return true;
+  }
+  if (!parsed) {
+    varbinds.clear();
+    error = AGENTX_ERR_PARSEERROR;
+  }
+  respond(header, error, index, varbinds);
+  return true;
+}
+
+/**
+ * @function respond
+ * @description send Response PDU
+ * @param pduHeader request header
+ * @param uint16_t error
+ * @param uint16_t index of varbind which caused the error (1 based)
+ * @param std::vector<varbind> varbinds
+**/
+
+void Subagent::respond(const pduHeader& header, uint16_t error, uint16_t index, const std::vector<varbind>& varbinds) {
+  writer.begin(PduType::RESPONSE, 0, header.sessionId, header.transactionId, header.packetId);
+  writer.writeUint32(0); //sysUpTime; set by master agent
+  writer.writeUint16(error);
+  writer.writeUint16(index);
+  for (auto& binding : varbinds) {
+    writer.writeVarbind(binding);
+  }
+  sendPdu(writer.finish());
+}
+
+/**
+ * @function encodeValue
+ * @description refresh oid (GET events) and encode its value
+ * @param Oid*
+ * @param varbind& binding to fill
+ * @returns bool: false if value can't be encoded
+**/
+
+bool Subagent::encodeValue(Oid* oid, varbind& binding) {
+  scheduler->refresh(oid);
+  return murmure::encodeValue(oid, binding);
+}
+
+/**
+ * @function get
+ * @description Get PDU: encode requested OIDs
+ * @param PduReader&
+ * @param std::vector<varbind>& response varbinds
+ * @returns bool: false if PDU is malformed
+**/
+
+bool Subagent::get(PduReader& reader, std::vector<varbind>& varbinds) {
+  searchRange range;
+  while (!reader.atEnd()) {
+    if (!reader.readSearchRange(range)) {
+      return false;
+    }
+    varbind binding;
+    Oid* oid = mibtable->getOidByOid(range.start);
+    if (oid == nullptr || !isLeaf(oid) || !encodeValue(oid, binding)) {
+      binding.type = VarbindType::NOSUCHOBJECT;
+      binding.oid = range.start;
+    }
+    varbinds.push_back(binding);
+  }
+  return true;
+}
+
+/**
+ * @function getNext
+ * @description GetNext PDU: encode the first leaf of each search range
+ * @param PduReader&
+ * @param std::vector<varbind>& response varbinds
+ * @returns bool: false if PDU is malformed
+**/
+
+bool Subagent::getNext(PduReader& reader, std::vector<varbind>& varbinds) {
+  searchRange range;
+  while (!reader.atEnd()) {
+    if (!reader.readSearchRange(range)) {
+      return false;
+    }
+    varbind binding;
+    Oid* oid = nextLeaf(mibtable, range.start, range.include, range.end, &cursor);
+    if (oid == nullptr || !encodeValue(oid, binding)) {
+      binding.type = VarbindType::ENDOFMIBVIEW;
+      binding.oid = range.start;
+    }
+    varbinds.push_back(binding);
+  }
+  return true;
+}
+
+/**
+ * @function getBulk
+ * @description GetBulk PDU: non repeaters ranges are served as GetNext; the others are repeated
+ * up to max repetitions times, row by row
+ * @param PduReader&
+ * @param std::vector<varbind>& response varbinds
+ * @returns bool: false if PDU is malformed
+**/
+
+bool Subagent::getBulk(PduReader& reader, std::vector<varbind>& varbinds) {
+  uint16_t nonRepeaters;
+  uint16_t maxRepetitions;
+  if (!reader.readUint16(nonRepeaters) || !reader.readUint16(maxRepetitions)) {
+    return false;
+  }
+  std::vector<searchRange> ranges;
+  searchRange range;
+  while (!reader.atEnd()) {
+    if (!reader.readSearchRange(range)) {
+      return false;
+    }
+    ranges.push_back(range);
+  }
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (i == nonRepeaters) {
+      break;
+    }
+    varbind binding;
+    Oid* oid = nextLeaf(mibtable, ranges.at(i).start, ranges.at(i).include, ranges.at(i).end);
+    if (oid == nullptr || !encodeValue(oid, binding)) {
+      binding.type = VarbindType::ENDOFMIBVIEW;
+      binding.oid = ranges.at(i).start;
+    }
+    varbinds.push_back(binding);
+  }
+  //Each repeater collects its successors in a single table scan; they're returned row by row
+  size_t repeaters = ranges.size() > nonRepeaters ? ranges.size() - nonRepeaters : 0;
+  std::vector<std::vector<Oid*>> successors(repeaters);
+  for (size_t i = 0; i < repeaters && maxRepetitions > 0; i++) {
+    const searchRange& repeater = ranges.at(nonRepeaters + i);
+    Oid* start = repeater.include ? mibtable->getOidByOid(repeater.start) : nullptr;
+    if (start != nullptr && isLeaf(start)) {
+      successors.at(i).push_back(start);
+    }
+    std::vector<Oid*> following;
+    mibtable->getSuccessors(repeater.start, maxRepetitions - successors.at(i).size(), following, isLeaf);
+    for (auto& oid : following) {
+      if (!repeater.end.empty() && compareOids(oid->getOid(), repeater.end) >= 0) {
+        break;
+      }
+      successors.at(i).push_back(oid);
+    }
+  }
+  std::vector<bool> ended(repeaters, false);
+  for (uint16_t repetition = 0; repetition < maxRepetitions; repetition++) {
+    bool allEnded = true;
+    for (size_t i = 0; i < repeaters; i++) {
+      searchRange& repeater = ranges.at(nonRepeaters + i);
+      varbind binding;
+      if (ended.at(i) || repetition >= successors.at(i).size() || !encodeValue(successors.at(i).at(repetition), binding)) {
+        binding.type = VarbindType::ENDOFMIBVIEW;
+        binding.oid = repeater.start;
+        ended.at(i) = true;
+      } else {
+        //End of MIB view is reported on the last returned OID
+        repeater.start = binding.oid;
+        allEnded = false;
+      }
+      varbinds.push_back(binding);
+    }
+    if (allEnded) {
+      break;
+    }
+  }
+  return true;
+}
+
+/**
+ * @function testSet
+ * @description TestSet PDU: check that all varbinds can be set; they're kept until cleanup
+ * @param PduReader&
+ * @param uint16_t& index of the failed varbind (1 based)
+ * @returns uint16_t: error
+**/
+
+uint16_t Subagent::testSet(PduReader& reader, uint16_t& index) {
+
+  transaction.clear();
+  varbind binding;
+  while (!reader.atEnd()) {
+    if (!reader.readVarbind(binding)) {
+      return AGENTX_ERR_PARSEERROR;
+    }
+    index++;
+    uint16_t error = transaction.test(binding);
+    if (error != AGENTX_ERR_NOERROR) {
+      return error;
+    }
+  }
+  index = 0;
+  return AGENTX_ERR_NOERROR;
+}
+
+/**
+ * @function findRoot
+ * @description find the subtree containing all table OIDs
+ * @returns std::string: root OID; empty if table is empty
+**/
+
+std::string Subagent::findRoot() {
+
+  Oid* oid = mibtable->getSuccessor("");
+  if (oid == nullptr) {
+    return "";
+  }
+  std::string root = oid->getOid();
+  while ((oid = mibtable->getSuccessor(oid->getOid())) != nullptr) {
+    //Shorten root until it's a prefix of oid
+    const std::string current = oid->getOid();
+    while (!root.empty() && !(current.compare(0, root.length(), root) == 0 && (current.length() == root.length() || current[root.length()] == '.'))) {
+      size_t lastDotPos = root.find_last_of('.');
+      root = root.substr(0, lastDotPos != std::string::npos ? lastDotPos : 0);
+    }
+  }
+  return root;
+}
+
+} // namespace agentx
+}
@@ -0,0 +1,298 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * Ingestion ring benchmark: spawns a Murmure daemon with --ingest and pushes integer values
+ * from concurrent producers through the client library, to measure push throughput and the
+ * rate at which the daemon applies them.
+ * Build with 'make murmure-ingestbench'
+**/
+
+#include <core/passpersist.hpp>
+#include <ingest/murmureingest.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define INGESTBENCH_USAGE \
+  "\
+Usage: murmure-ingestbench [options] -- <murmure path> [murmure options]\n\
+\t-r <records>\t\tRecords to push (default 1000000)\n\
+\t-p <producers>\t\tConcurrent producers (default 1)\n\
+\t-o <OID>\t\tOID values are pushed to; can be repeated (default .1.3.6.1.2.1.1.3.0)\n\
+The daemon is started adding -D and --ingest <ring file> to the provided murmure options;\n\
+producers retry records dropped because the ring was full\n\
+"
+
+#define INGESTBENCH_TIMEOUT 60 //Time the daemon is given to apply all the records (s)
+
+using namespace murmure;
+
+/**
+ * @function spawnDaemon
+ * @description start murmure daemon with stdin/stdout connected to pipes
+ * @param std::vector<std::string>& daemon command line
+ * @param int& pipe to daemon stdin
+ * @param int& pipe from daemon stdout
+ * @returns pid_t: daemon pid; -1 on error
+**/
+
+static pid_t spawnDaemon(const std::vector<std::string>& argv, int& toDaemon, int& fromDaemon) {
+
+  int inPipe[2];
+  int outPipe[2];
+  if (pipe(inPipe) != 0) {
+    return -1;
+  }
+  if (pipe(outPipe) != 0) {
+    close(inPipe[0]);
+    close(inPipe[1]);
+    return -1;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(inPipe[0], STDIN_FILENO);
+    dup2(outPipe[1], STDOUT_FILENO);
+    close(inPipe[0]);
+    close(inPipe[1]);
+    close(outPipe[0]);
+    close(outPipe[1]);
+    std::vector<char*> args;
+    for (auto& arg : argv) {
+      args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    execv(args.at(0), args.data());
+    _exit(127);
+  }
+  close(inPipe[0]);
+  close(outPipe[1]);
+  if (pid < 0) {
+    close(inPipe[1]);
+    close(outPipe[0]);
+    return -1;
+  }
+  toDaemon = inPipe[1];
+  fromDaemon = outPipe[0];
+  return pid;
+}
+
+/**
+ * @function parseArg
+ * @description parse a not negative integer argument
+ * @returns bool: true if valid
+**/
+
+static bool parseArg(const char* arg, int& value) {
+  try {
+    value = std::stoi(arg);
+    return value >= 0;
+  } catch (std::exception& ex) {
+    return false;
+  }
+}
+
+/**
+ * @function readStats
+ * @description issue 'stats' to the daemon and read its counters
+ * @param PassPersist& daemon channel
+ * @param std::map<std::string, uint64_t>& counters
+ * @returns bool: false if daemon has terminated
+**/
+
+static bool readStats(PassPersist& daemon, std::map<std::string, uint64_t>& stats) {
+  daemon.getResponse() = "stats\n";
+  if (!daemon.flush()) {
+    return false;
+  }
+  LineView line;
+  while (daemon.readLine(line)) {
+    if (line.equals("END")) {
+      return true;
+    }
+    size_t sepPos = line.find(' ');
+    if (sepPos != std::string::npos) {
+      stats[std::string(line.data, sepPos)] = std::stoull(std::string(line.data + sepPos + 1, line.length - sepPos - 1));
+    }
+  }
+  return false;
+}
+
+/**
+ * @function runProducer
+ * @description push records, retrying while the ring is full
+ * @param murmure_ingest* ring
+ * @param std::vector<uint64_t>* OID keys, used in turn
+ * @param int amount of records
+ * @param uint64_t* times the ring was full
+ * @param bool* false if a record was refused
+**/
+
+static void runProducer(murmure_ingest* ring, const std::vector<uint64_t>* keys, int records, uint64_t* full, bool* succeeded) {
+  for (int i = 0; i < records; i++) {
+    int rc;
+    while ((rc = murmure_ingest_integer(ring, keys->at(i % keys->size()), i)) == MURMURE_INGEST_FULL) {
+      (*full)++;
+      std::this_thread::yield();
+    }
+    if (rc != MURMURE_INGEST_OK) {
+      *succeeded = false;
+      return;
+    }
+  }
+  *succeeded = true;
+}
+
+int main(int argc, char* argv[]) {
+
+  int records = 1000000;
+  int producers = 1;
+  std::vector<std::string> oids;
+  std::vector<std::string> daemonArgs;
+  bool valid = true;
+  for (int i = 1; i < argc && valid; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--") {
+      for (i++; i < argc; i++) {
+        daemonArgs.push_back(argv[i]);
+      }
+    } else if (arg == "-r" && i + 1 < argc) {
+      valid = parseArg(argv[++i], records) && records > 0;
+    } else if (arg == "-p" && i + 1 < argc) {
+      valid = parseArg(argv[++i], producers) && producers > 0;
+    } else if (arg == "-o" && i + 1 < argc) {
+      oids.push_back(argv[++i]);
+    } else {
+      valid = false;
+    }
+  }
+  if (!valid || daemonArgs.empty()) {
+    std::cout << INGESTBENCH_USAGE;
+    return 255;
+  }
+  if (oids.empty()) {
+    oids.push_back(".1.3.6.1.2.1.1.3.0");
+  }
+  std::vector<uint64_t> keys;
+  for (auto& oid : oids) {
+    keys.push_back(murmure_ingest_key(oid.c_str()));
+  }
+  const std::string ringPath = "/tmp/murmure-ingestbench-" + std::to_string(getpid()) + ".ring";
+  daemonArgs.push_back("-D");
+  daemonArgs.push_back("--ingest");
+  daemonArgs.push_back(ringPath);
+  signal(SIGPIPE, SIG_IGN);
+
+  int toDaemon;
+  int fromDaemon;
+  pid_t daemonPid = spawnDaemon(daemonArgs, toDaemon, fromDaemon);
+  if (daemonPid < 0) {
+    std::cout << "Could not start " << daemonArgs.at(0) << std::endl;
+    return 1;
+  }
+  PassPersist daemon(fromDaemon, toDaemon);
+  //Handshake; waits for daemon startup (ring is initialized by then)
+  daemon.getResponse() = "PING\n";
+  LineView line;
+  murmure_ingest* ring = nullptr;
+  if (!daemon.flush() || !daemon.readLine(line) || !line.equals("PONG") || (ring = murmure_ingest_open(ringPath.c_str())) == nullptr) {
+    std::cout << "Daemon did not start ingestion on " << ringPath << std::endl;
+    close(toDaemon);
+    waitpid(daemonPid, nullptr, 0);
+    unlink(ringPath.c_str());
+    return 1;
+  }
+
+  std::vector<uint64_t> producerFull(producers, 0);
+  std::unique_ptr<bool[]> producerSucceeded(new bool[producers]);
+  std::vector<std::thread> producerThreads;
+  std::chrono::steady_clock::time_point benchStart = std::chrono::steady_clock::now();
+  for (int i = 0; i < producers; i++) {
+    int producerRecords = records / producers + (i < records % producers ? 1 : 0);
+    producerThreads.push_back(std::thread(runProducer, ring, &keys, producerRecords, &producerFull.at(i), &producerSucceeded[i]));
+  }
+  uint64_t full = 0;
+  bool succeeded = true;
+  for (int i = 0; i < producers; i++) {
+    producerThreads.at(i).join();
+    full += producerFull.at(i);
+    succeeded = succeeded && producerSucceeded[i];
+  }
+  double pushSeconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - benchStart).count() / 1000000.0;
+  //Wait for the daemon to apply all the records
+  std::map<std::string, uint64_t> stats;
+  bool completed = false;
+  while (succeeded && readStats(daemon, stats)) {
+    if (stats["ingest-records"] >= static_cast<uint64_t>(records)) {
+      completed = true;
+      break;
+    }
+    if (std::chrono::steady_clock::now() - benchStart > std::chrono::seconds(INGESTBENCH_TIMEOUT)) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double realSeconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - benchStart).count() / 1000000.0;
+  murmure_ingest_close(ring);
+
+  //Terminate daemon with an empty line
+  daemon.getResponse() = "\n";
+  daemon.flush();
+  close(toDaemon);
+  waitpid(daemonPid, nullptr, 0);
+  close(fromDaemon);
+  unlink(ringPath.c_str());
+
+  if (!succeeded) {
+    std::cout << "Ring refused records" << std::endl;
+    return 1;
+  }
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "records:          " << records << " (" << oids.size() << " OIDs)" << std::endl;
+  std::cout << "producers:        " << producers << std::endl;
+  std::cout << "ring full:        " << full << " times" << std::endl;
+  std::cout << "push time:        " << pushSeconds << " s" << std::endl;
+  std::cout << "push throughput:  " << (pushSeconds > 0 ? records / pushSeconds : 0) << " records/s" << std::endl;
+  if (!completed) {
+    std::cout << "Daemon applied " << stats["ingest-records"] << " records" << std::endl;
+    return 1;
+  }
+  std::cout << "real time:        " << realSeconds << " s" << std::endl;
+  std::cout << "throughput:       " << records / realSeconds << " records/s" << std::endl;
+  std::cout << "values applied:   " << stats["ingest-applied"] << std::endl;
+  std::cout << "unknown OIDs:     " << stats["ingest-unknown"] << std::endl;
+  std::cout << "invalid values:   " << stats["ingest-invalid"] << std::endl;
+  return 0;
+}
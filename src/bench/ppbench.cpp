@@ -0,0 +1,311 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * pass_persist load benchmark: spawns a Murmure daemon and issues sequential requests
+ * through its stdin/stdout, as snmpd does, or from concurrent clients through the daemon
+ * socket, to measure request throughput and latency.
+ * Build with 'make murmure-ppbench'
+**/
+
+#include <core/passpersist.hpp>
+#include <utils/logger.hpp>
+#include <utils/unixsocket.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PPBENCH_USAGE \
+  "\
+Usage: murmure-ppbench [options] -- <murmure path> [murmure options]\n\
+\t-r <requests>\t\tRequests to issue (default 100000)\n\
+\t-o <OID>\t\tRequested OID (default .1.3.6.1.2.1.1.1.0)\n\
+\t-m <get|getnext>\tRequest type (default get)\n\
+\t-c <clients>\t\tConcurrent clients on the daemon socket; 0 for stdin (default 0)\n\
+The daemon is started adding -D (and -U, with clients) to the provided murmure options\n\
+"
+
+using namespace murmure;
+
+/**
+ * @function spawnDaemon
+ * @description start murmure daemon with stdin/stdout connected to pipes
+ * @param std::vector<std::string>& daemon command line
+ * @param int& pipe to daemon stdin
+ * @param int& pipe from daemon stdout
+ * @returns pid_t: daemon pid; -1 on error
+**/
+
+static pid_t spawnDaemon(const std::vector<std::string>& argv, int& toDaemon, int& fromDaemon) {
+
+  int inPipe[2];
+  int outPipe[2];
+  if (pipe(inPipe) != 0) {
+    return -1;
+  }
+  if (pipe(outPipe) != 0) {
+    close(inPipe[0]);
+    close(inPipe[1]);
+    return -1;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(inPipe[0], STDIN_FILENO);
+    dup2(outPipe[1], STDOUT_FILENO);
+    close(inPipe[0]);
+    close(inPipe[1]);
+    close(outPipe[0]);
+    close(outPipe[1]);
+    std::vector<char*> args;
+    for (auto& arg : argv) {
+      args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    execv(args.at(0), args.data());
+    _exit(127);
+  }
+  close(inPipe[0]);
+  close(outPipe[1]);
+  if (pid < 0) {
+    close(inPipe[1]);
+    close(outPipe[0]);
+    return -1;
+  }
+  toDaemon = inPipe[1];
+  fromDaemon = outPipe[0];
+  return pid;
+}
+
+/**
+ * @function readResponse
+ * @description read a response: an error line or OID, type and value lines
+ * @param PassPersist& daemon channel
+ * @param bool& true if response is an error
+ * @returns bool: false if daemon has terminated
+**/
+
+static bool readResponse(PassPersist& daemon, bool& failed) {
+  LineView line;
+  if (!daemon.readLine(line)) {
+    return false;
+  }
+  failed = line.empty() || line.data[0] != '.';
+  if (failed) {
+    return true;
+  }
+  return daemon.readLine(line) && daemon.readLine(line);
+}
+
+/**
+ * @function parseArg
+ * @description parse a not negative integer argument
+ * @returns bool: true if valid
+**/
+
+static bool parseArg(const char* arg, int& value) {
+  try {
+    value = std::stoi(arg);
+    return value >= 0;
+  } catch (std::exception& ex) {
+    return false;
+  }
+}
+
+/**
+ * @function runClient
+ * @description issue sequential requests, one outstanding at a time (as snmpd does)
+ * @param PassPersist& daemon channel
+ * @param std::string request lines
+ * @param int amount of requests
+ * @param std::vector<double>& latencies (us)
+ * @param int& error responses
+ * @returns bool: false if daemon has terminated
+**/
+
+static bool runClient(PassPersist& daemon, const std::string& request, int requests, std::vector<double>& latencies, int& errors) {
+  bool failed;
+  latencies.reserve(requests);
+  for (int i = 0; i < requests; i++) {
+    std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+    daemon.getResponse() = request;
+    if (!daemon.flush() || !readResponse(daemon, failed)) {
+      return false;
+    }
+    if (failed) {
+      errors++;
+    }
+    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sent).count() / 1000.0);
+  }
+  return true;
+}
+
+/**
+ * @function runSocketClient
+ * @description connect to the daemon socket and issue sequential requests
+ * @param std::string socket path
+ * @param std::string request lines
+ * @param int amount of requests
+ * @param std::vector<double>* latencies (us)
+ * @param int* error responses
+ * @param bool* false if client failed
+**/
+
+static void runSocketClient(const std::string& socketPath, const std::string& request, int requests, std::vector<double>* latencies, int* errors, bool* succeeded) {
+  std::string error;
+  int sockFd = unixsocket::connect(socketPath, error);
+  if (sockFd < 0) {
+    *succeeded = false;
+    return;
+  }
+  PassPersist daemon(sockFd, sockFd);
+  *succeeded = runClient(daemon, request, requests, *latencies, *errors);
+  close(sockFd);
+}
+
+int main(int argc, char* argv[]) {
+
+  int requests = 100000;
+  int clients = 0;
+  std::string oid = ".1.3.6.1.2.1.1.1.0";
+  std::string method = "get";
+  std::vector<std::string> daemonArgs;
+  bool valid = true;
+  for (int i = 1; i < argc && valid; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--") {
+      for (i++; i < argc; i++) {
+        daemonArgs.push_back(argv[i]);
+      }
+    } else if (arg == "-r" && i + 1 < argc) {
+      valid = parseArg(argv[++i], requests) && requests > 0;
+    } else if (arg == "-c" && i + 1 < argc) {
+      valid = parseArg(argv[++i], clients);
+    } else if (arg == "-o" && i + 1 < argc) {
+      oid = argv[++i];
+    } else if (arg == "-m" && i + 1 < argc) {
+      method = argv[++i];
+      valid = method == "get" || method == "getnext";
+    } else {
+      valid = false;
+    }
+  }
+  if (!valid || daemonArgs.empty()) {
+    std::cout << PPBENCH_USAGE;
+    return 255;
+  }
+  daemonArgs.push_back("-D");
+  const std::string socketPath = "/tmp/murmure-ppbench-" + std::to_string(getpid()) + ".sock";
+  if (clients > 0) {
+    daemonArgs.push_back("-U");
+    daemonArgs.push_back(socketPath);
+  }
+
+  logger::logfile = "/dev/null";
+  logger::logLevel = LOG_ERROR;
+  logger::toStdout = false;
+  signal(SIGPIPE, SIG_IGN);
+
+  int toDaemon;
+  int fromDaemon;
+  pid_t daemonPid = spawnDaemon(daemonArgs, toDaemon, fromDaemon);
+  if (daemonPid < 0) {
+    std::cout << "Could not start " << daemonArgs.at(0) << std::endl;
+    return 1;
+  }
+  PassPersist daemon(fromDaemon, toDaemon);
+  //Handshake; waits for daemon startup (socket is open by then)
+  daemon.getResponse() = "PING\n";
+  LineView line;
+  if (!daemon.flush() || !daemon.readLine(line) || !line.equals("PONG")) {
+    std::cout << "Daemon did not answer PING" << std::endl;
+    close(toDaemon);
+    waitpid(daemonPid, nullptr, 0);
+    return 1;
+  }
+
+  const std::string request = method + "\n" + oid + "\n";
+  std::vector<double> latencies; //us
+  int errors = 0;
+  bool succeeded = true;
+  std::chrono::steady_clock::time_point benchStart = std::chrono::steady_clock::now();
+  if (clients == 0) {
+    succeeded = runClient(daemon, request, requests, latencies, errors);
+  } else {
+    //Requests are split among clients
+    std::vector<std::vector<double>> clientLatencies(clients);
+    std::vector<int> clientErrors(clients, 0);
+    std::unique_ptr<bool[]> clientSucceeded(new bool[clients]);
+    std::vector<std::thread> clientThreads;
+    for (int i = 0; i < clients; i++) {
+      int clientRequests = requests / clients + (i < requests % clients ? 1 : 0);
+      clientThreads.push_back(std::thread(runSocketClient, socketPath, request, clientRequests, &clientLatencies.at(i), &clientErrors.at(i), &clientSucceeded[i]));
+    }
+    for (int i = 0; i < clients; i++) {
+      clientThreads.at(i).join();
+      latencies.insert(latencies.end(), clientLatencies.at(i).begin(), clientLatencies.at(i).end());
+      errors += clientErrors.at(i);
+      succeeded = succeeded && clientSucceeded[i];
+    }
+  }
+  double realSeconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - benchStart).count() / 1000000.0;
+  if (!succeeded) {
+    std::cout << "Daemon terminated after " << latencies.size() << " requests" << std::endl;
+  }
+
+  //Terminate daemon with an empty line
+  daemon.getResponse() = "\n";
+  daemon.flush();
+  close(toDaemon);
+  waitpid(daemonPid, nullptr, 0);
+  close(fromDaemon);
+
+  if (latencies.empty()) {
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies.at(std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size())));
+  };
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "requests:         " << latencies.size() << " (" << method << " " << oid << ")" << std::endl;
+  std::cout << "clients:          " << (clients > 0 ? std::to_string(clients) + " (socket)" : "1 (stdin)") << std::endl;
+  std::cout << "error responses:  " << errors << std::endl;
+  std::cout << "real time:        " << realSeconds << " s" << std::endl;
+  std::cout << "throughput:       " << (realSeconds > 0 ? latencies.size() / realSeconds : 0) << " requests/s" << std::endl;
+  std::cout << "latency p50:      " << percentile(0.50) << " us" << std::endl;
+  std::cout << "latency p99:      " << percentile(0.99) << " us" << std::endl;
+  std::cout << "latency p99.9:    " << percentile(0.999) << " us" << std::endl;
+  std::cout << "latency max:      " << latencies.back() << " us" << std::endl;
+  return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * Scheduler benchmark: fast-forwards the scheduler through simulated time, with no-op
+ * commands, to measure dispatch throughput and timers drift.
+ * Build with 'make murmure-bench'
+**/
+
+#include <mibscheduler/clock.hpp>
+#include <mibscheduler/scheduledevent.hpp>
+#include <mibscheduler/scheduler.hpp>
+#include <utils/logger.hpp>
+#include <utils/process.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_USAGE \
+  "\
+Usage: murmure-bench [options]\n\
+\t-e <events>\t\tScheduled events (default 10000)\n\
+\t-p <seconds>\t\tMax event period; periods are spread in range 1-max (default 300)\n\
+\t-d <seconds>\t\tSimulated time (default 86400)\n\
+\t-c <milliseconds>\tSimulated duration of each execution (default 0)\n\
+"
+
+using namespace murmure;
+
+//Benchmark state, shared with the run hook
+static VirtualClock virtualClock;
+static std::chrono::steady_clock::time_point benchStart;
+static std::chrono::seconds simulatedTime(86400);
+static std::chrono::milliseconds executionCost(0);
+static std::vector<int> periods;
+static std::vector<std::chrono::steady_clock::time_point> lastFires;
+static std::mutex statsMutex;
+static uint64_t firings = 0;
+static uint64_t lateFirings = 0;
+static int64_t totalDrift = 0; //ms
+static int64_t maxDrift = 0;   //ms
+
+/**
+ * @function runNoop
+ * @description run hook: records the firing instead of executing the command ('bench <event index>')
+ * @returns bool: true
+**/
+
+static bool runNoop(const std::string& command, const std::vector<std::string>& environment, process::execResult& result, std::string& error) {
+
+  size_t eventIndex = std::strtoul(command.c_str() + command.find(' ') + 1, nullptr, 10);
+  std::chrono::steady_clock::time_point now = virtualClock.now();
+  if (now - benchStart <= simulatedTime && eventIndex < periods.size()) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    //Periodic runs are expected every period since the previous run
+    std::chrono::steady_clock::time_point expected = lastFires.at(eventIndex) + std::chrono::seconds(periods.at(eventIndex));
+    int64_t drift = std::chrono::duration_cast<std::chrono::milliseconds>(now - expected).count();
+    firings++;
+    if (drift > 0) {
+      lateFirings++;
+    }
+    totalDrift += std::abs(drift);
+    maxDrift = std::max(maxDrift, std::abs(drift));
+    lastFires.at(eventIndex) = now;
+  }
+  if (executionCost.count() > 0) {
+    virtualClock.advance(executionCost);
+  }
+  result.exitCode = 0;
+  result.signaled = false;
+  result.timedOut = false;
+  result.duration = executionCost;
+  return true;
+}
+
+/**
+ * @function parseArg
+ * @description parse a not negative integer argument
+ * @returns bool: true if valid
+**/
+
+static bool parseArg(const char* arg, int& value) {
+  try {
+    value = std::stoi(arg);
+    return value >= 0;
+  } catch (std::exception& ex) {
+    return false;
+  }
+}
+
+int main(int argc, char* argv[]) {
+
+  int eventAmount = 10000;
+  int maxPeriod = 300;
+  int duration = static_cast<int>(simulatedTime.count());
+  int cost = 0;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    bool valid = i + 1 < argc;
+    if (valid && arg == "-e") {
+      valid = parseArg(argv[++i], eventAmount);
+    } else if (valid && arg == "-p") {
+      valid = parseArg(argv[++i], maxPeriod) && maxPeriod > 0;
+    } else if (valid && arg == "-d") {
+      valid = parseArg(argv[++i], duration);
+    } else if (valid && arg == "-c") {
+      valid = parseArg(argv[++i], cost);
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      std::cout << BENCH_USAGE;
+      return 255;
+    }
+  }
+  simulatedTime = std::chrono::seconds(duration);
+  executionCost = std::chrono::milliseconds(cost);
+
+  logger::logfile = "/dev/null";
+  logger::logLevel = LOG_ERROR;
+  logger::toStdout = false;
+
+  //No-op commands, simulated time
+  process::setRunHook(runNoop);
+  Scheduler::setClock(&virtualClock);
+  Scheduler* scheduler = new Scheduler(nullptr);
+  benchStart = virtualClock.now();
+  for (int i = 0; i < eventAmount; i++) {
+    int period = 1 + (i % maxPeriod);
+    std::vector<std::string> commandList;
+    commandList.push_back("bench " + std::to_string(i));
+    scheduler->adoptEvent(new ScheduledEvent(".1.3.6.1.4.1.9999.0." + std::to_string(i), EventMode::AUTO, commandList, period));
+    periods.push_back(period);
+    lastFires.push_back(benchStart);
+  }
+
+  std::chrono::steady_clock::time_point realStart = std::chrono::steady_clock::now();
+  if (!scheduler->startScheduler()) {
+    std::cout << "Could not start scheduler" << std::endl;
+    delete scheduler;
+    return 1;
+  }
+  while (virtualClock.now() - benchStart < simulatedTime) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double realSeconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - realStart).count() / 1000000.0;
+  delete scheduler;
+
+  //Expected firings: one every period, for each event
+  uint64_t expectedFirings = 0;
+  for (auto& period : periods) {
+    expectedFirings += duration / period;
+  }
+  std::lock_guard<std::mutex> lock(statsMutex);
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "events:           " << eventAmount << std::endl;
+  std::cout << "simulated time:   " << duration << " s" << std::endl;
+  std::cout << "real time:        " << realSeconds << " s" << std::endl;
+  std::cout << "firings:          " << firings << " (expected " << expectedFirings << ")" << std::endl;
+  std::cout << "throughput:       " << (realSeconds > 0 ? firings / realSeconds : 0) << " firings/s" << std::endl;
+  std::cout << "late firings:     " << lateFirings << std::endl;
+  std::cout << "avg drift:        " << (firings > 0 ? static_cast<double>(totalDrift) / firings : 0) << " ms" << std::endl;
+  std::cout << "max drift:        " << maxDrift << " ms" << std::endl;
+  return 0;
+}
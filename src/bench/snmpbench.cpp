@@ -0,0 +1,361 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * SNMPv2c agent load benchmark: issues requests over loopback UDP from concurrent clients,
+ * each keeping a window of outstanding requests, to measure throughput and latency of
+ * the standalone agent (-P). The agent is spawned when a murmure command line is provided.
+ * Build with 'make murmure-snmpbench'
+**/
+
+#include <snmp/ber.hpp>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define SNMPBENCH_USAGE \
+  "\
+Usage: murmure-snmpbench [options] [-- <murmure path> [murmure options]]\n\
+\t-r <requests>\t\tRequests to issue (default 100000)\n\
+\t-o <OID>\t\tRequested OID (default .1.3.6.1.2.1.1.1.0)\n\
+\t-m <get|getnext|getbulk>\tRequest type (default get)\n\
+\t-R <repetitions>\tGetBulk max repetitions (default 10)\n\
+\t-c <clients>\t\tConcurrent clients (default 1)\n\
+\t-w <window>\t\tOutstanding requests per client (default 1)\n\
+\t-p <port>\t\tAgent port on 127.0.0.1 (default 16161)\n\
+\t-C <community>\t\tCommunity (default public)\n\
+With a murmure command line, the agent is started adding -P 127.0.0.1:<port>;\n\
+otherwise it must be already listening\n\
+"
+
+#define SNMPBENCH_TIMEOUT 1000 //Outstanding requests are lost after this time (ms)
+
+using namespace murmure;
+using namespace murmure::snmp;
+
+typedef struct {
+  int requests;
+  int window;
+  std::vector<double> latencies; //us
+  int errors;
+  int lost;
+} clientStats;
+
+/**
+ * @function parseArg
+ * @description parse a not negative integer argument
+ * @returns bool: true if valid
+**/
+
+static bool parseArg(const char* arg, int& value) {
+  try {
+    value = std::stoi(arg);
+    return value >= 0;
+  } catch (std::exception& ex) {
+    return false;
+  }
+}
+
+/**
+ * @function openClientSocket
+ * @description create a UDP socket connected to the agent on loopback
+ * @param int port
+ * @returns int: socket; -1 on error
+**/
+
+static int openClientSocket(int port) {
+  int sockFd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sockFd < 0) {
+    return -1;
+  }
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  timeval timeout;
+  timeout.tv_sec = SNMPBENCH_TIMEOUT / 1000;
+  timeout.tv_usec = (SNMPBENCH_TIMEOUT % 1000) * 1000;
+  if (setsockopt(sockFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 || connect(sockFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    close(sockFd);
+    return -1;
+  }
+  return sockFd;
+}
+
+/**
+ * @function isError
+ * @description returns whether a response reports an error or an exception value;
+ * end of MIB view is expected after the first GetBulk varbind
+ * @param message response
+ * @returns bool
+**/
+
+static bool isError(const message& response) {
+  if (response.errorStatus != SNMP_ERR_NOERROR || response.varbinds.empty()) {
+    return true;
+  }
+  for (size_t i = 0; i < response.varbinds.size(); i++) {
+    VarbindType type = response.varbinds.at(i).type;
+    if (type == VarbindType::NOSUCHOBJECT || type == VarbindType::NOSUCHINSTANCE || (type == VarbindType::ENDOFMIBVIEW && i == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @function runClient
+ * @description issue requests keeping up to window requests outstanding; request id is the request index
+ * @param int port
+ * @param message request template
+ * @param clientStats* stats
+**/
+
+static void runClient(int port, message request, clientStats* stats) {
+
+  int sockFd = openClientSocket(port);
+  if (sockFd < 0) {
+    stats->lost = stats->requests;
+    return;
+  }
+  BerWriter writer;
+  message response;
+  std::vector<char> buffer(SNMP_MAX_MESSAGE);
+  std::vector<std::chrono::steady_clock::time_point> sendTimes(stats->requests);
+  std::vector<bool> outstanding(stats->requests, false);
+  int next = 0;
+  int pending = 0;
+  int oldest = 0; //Requests before are answered or lost
+  stats->latencies.reserve(stats->requests);
+  while (true) {
+    while (pending < stats->window && next < stats->requests) {
+      request.requestId = next;
+      encodeMessage(writer, request);
+      sendTimes.at(next) = std::chrono::steady_clock::now();
+      if (send(sockFd, writer.getBuffer().data(), writer.getBuffer().length(), 0) < 0) {
+        stats->lost++;
+      } else {
+        outstanding.at(next) = true;
+        pending++;
+      }
+      next++;
+    }
+    if (pending == 0) {
+      break;
+    }
+    ssize_t readBytes = recv(sockFd, buffer.data(), buffer.size(), 0);
+    if (readBytes < 0) {
+      //Timeout: outstanding requests are lost
+      for (; oldest < next; oldest++) {
+        if (outstanding.at(oldest)) {
+          outstanding.at(oldest) = false;
+          stats->lost++;
+        }
+      }
+      pending = 0;
+      continue;
+    }
+    if (!decodeMessage(buffer.data(), readBytes, response) || response.type != PduType::RESPONSE || response.requestId < oldest || response.requestId >= next || !outstanding.at(response.requestId)) {
+      continue;
+    }
+    outstanding.at(response.requestId) = false;
+    pending--;
+    stats->latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sendTimes.at(response.requestId)).count() / 1000.0);
+    if (isError(response)) {
+      stats->errors++;
+    }
+  }
+  close(sockFd);
+}
+
+/**
+ * @function spawnAgent
+ * @description start murmure agent and wait until it answers
+ * @param std::vector<std::string>& agent command line
+ * @param message request template
+ * @param int port
+ * @returns pid_t: agent pid; -1 on error
+**/
+
+static pid_t spawnAgent(const std::vector<std::string>& argv, message request, int port) {
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    std::vector<char*> args;
+    for (auto& arg : argv) {
+      args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    execv(args.at(0), args.data());
+    _exit(127);
+  } else if (pid < 0) {
+    return -1;
+  }
+  //Wait for startup; requests fail immediately while the port is closed
+  clientStats probe;
+  probe.requests = 1;
+  probe.window = 1;
+  for (int attempt = 0; attempt < 100; attempt++) {
+    probe.errors = 0;
+    probe.lost = 0;
+    runClient(port, request, &probe);
+    if (!probe.latencies.empty()) {
+      return pid;
+    } else if (waitpid(pid, nullptr, WNOHANG) == pid) {
+      return -1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  kill(pid, SIGTERM);
+  waitpid(pid, nullptr, 0);
+  return -1;
+}
+
+int main(int argc, char* argv[]) {
+
+  int requests = 100000;
+  int clients = 1;
+  int window = 1;
+  int port = 16161;
+  int repetitions = 10;
+  std::string oid = ".1.3.6.1.2.1.1.1.0";
+  std::string method = "get";
+  message request;
+  request.version = SNMP_VERSION_2C;
+  request.community = "public";
+  std::vector<std::string> agentArgs;
+  bool valid = true;
+  for (int i = 1; i < argc && valid; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--") {
+      for (i++; i < argc; i++) {
+        agentArgs.push_back(argv[i]);
+      }
+    } else if (arg == "-r" && i + 1 < argc) {
+      valid = parseArg(argv[++i], requests) && requests > 0;
+    } else if (arg == "-c" && i + 1 < argc) {
+      valid = parseArg(argv[++i], clients) && clients > 0;
+    } else if (arg == "-w" && i + 1 < argc) {
+      valid = parseArg(argv[++i], window) && window > 0;
+    } else if (arg == "-p" && i + 1 < argc) {
+      valid = parseArg(argv[++i], port) && port > 0 && port <= 65535;
+    } else if (arg == "-R" && i + 1 < argc) {
+      valid = parseArg(argv[++i], repetitions);
+    } else if (arg == "-C" && i + 1 < argc) {
+      request.community = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      oid = argv[++i];
+    } else if (arg == "-m" && i + 1 < argc) {
+      method = argv[++i];
+      valid = method == "get" || method == "getnext" || method == "getbulk";
+    } else {
+      valid = false;
+    }
+  }
+  if (!valid) {
+    std::cout << SNMPBENCH_USAGE;
+    return 255;
+  }
+  request.type = method == "get" ? PduType::GET : method == "getnext" ? PduType::GETNEXT : PduType::GETBULK;
+  //GetBulk carries non repeaters and max repetitions in error fields
+  request.errorStatus = 0;
+  request.errorIndex = request.type == PduType::GETBULK ? repetitions : 0;
+  varbind binding;
+  binding.type = VarbindType::NULLVALUE;
+  binding.oid = oid;
+  binding.number = 0;
+  request.varbinds.push_back(binding);
+
+  pid_t agentPid = -1;
+  if (!agentArgs.empty()) {
+    agentArgs.push_back("-P");
+    agentArgs.push_back("127.0.0.1:" + std::to_string(port));
+    agentPid = spawnAgent(agentArgs, request, port);
+    if (agentPid < 0) {
+      std::cout << "Agent " << agentArgs.at(0) << " did not answer on port " << port << std::endl;
+      return 1;
+    }
+  }
+
+  //Requests are split among clients
+  std::vector<clientStats> stats(clients);
+  std::vector<std::thread> clientThreads;
+  std::chrono::steady_clock::time_point benchStart = std::chrono::steady_clock::now();
+  for (int i = 0; i < clients; i++) {
+    stats.at(i).requests = requests / clients + (i < requests % clients ? 1 : 0);
+    stats.at(i).window = window;
+    stats.at(i).errors = 0;
+    stats.at(i).lost = 0;
+    clientThreads.push_back(std::thread(runClient, port, request, &stats.at(i)));
+  }
+  std::vector<double> latencies;
+  int errors = 0;
+  int lost = 0;
+  for (int i = 0; i < clients; i++) {
+    clientThreads.at(i).join();
+    latencies.insert(latencies.end(), stats.at(i).latencies.begin(), stats.at(i).latencies.end());
+    errors += stats.at(i).errors;
+    lost += stats.at(i).lost;
+  }
+  double realSeconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - benchStart).count() / 1000000.0;
+
+  if (agentPid > 0) {
+    kill(agentPid, SIGTERM);
+    waitpid(agentPid, nullptr, 0);
+  }
+
+  if (latencies.empty()) {
+    std::cout << "No responses from agent on port " << port << std::endl;
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies.at(std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size())));
+  };
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "requests:         " << latencies.size() << " (" << method << " " << oid << ")" << std::endl;
+  std::cout << "clients:          " << clients << " (window " << window << ")" << std::endl;
+  std::cout << "error responses:  " << errors << std::endl;
+  std::cout << "lost requests:    " << lost << std::endl;
+  std::cout << "real time:        " << realSeconds << " s" << std::endl;
+  std::cout << "throughput:       " << (realSeconds > 0 ? latencies.size() / realSeconds : 0) << " requests/s" << std::endl;
+  std::cout << "latency p50:      " << percentile(0.50) << " us" << std::endl;
+  std::cout << "latency p99:      " << percentile(0.99) << " us" << std::endl;
+  std::cout << "latency p99.9:    " << percentile(0.999) << " us" << std::endl;
+  std::cout << "latency max:      " << latencies.back() << " us" << std::endl;
+  return 0;
+}
@@ -32,12 +32,37 @@
 
 namespace murmure {
 
+/**
+ * @function mixKey
+ * @description scramble an OID key, so that its low bits select the filter word and its high bits the filter bits
+ * @param uint64_t OID key
+ * @returns uint64_t
+**/
+
+static inline uint64_t mixKey(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return key;
+}
+
+/**
+ * @function filterBits
+ * @description get the three bits of a mixed OID key within its filter word
+ * @param uint64_t mixed OID key
+ * @returns uint64_t
+**/
+
+static inline uint64_t filterBits(uint64_t hash) {
+  return (1ULL << ((hash >> 40) & 63)) | (1ULL << ((hash >> 46) & 63)) | (1ULL << ((hash >> 52) & 63));
+}
+
 /**
  * @function Mibtable
  * @description class constructor
 **/
 
-Mibtable::Mibtable() {
+Mibtable::Mibtable() : generation(1), cursorHits(0), cursorMisses(0) {
 }
 
 /**
@@ -74,6 +99,7 @@ bool Mibtable::loadMibTable() {
     return false;
   }
 
+  WriteGuard guard(tableLock);
   size_t mibTableSize = 0;
   //Fetch rows
   for (auto& row : tableEntries) {
@@ -102,10 +128,11 @@ bool Mibtable::loadMibTable() {
     }
     //Push new oid in oids vector
     oids.push_back(thisOid);
+    indexOid(thisOid);
   }
 
   //Sort table
-  sortMibTable();
+  sortOids();
 
   //Mib loaded successfully
   return true;
@@ -138,10 +165,11 @@ bool Mibtable::addOid(Oid* newOid) {
   }
 
   //Finally add new OID object to mibtable vector
-  oids.push_back(newOid);
-
-  //Sort mib table
-  this->sortMibTable();
+  //Insert in order, so that the table doesn't need to be sorted again while readers wait
+  WriteGuard guard(tableLock);
+  oids.insert(std::upper_bound(oids.begin(), oids.end(), newOid, sortByOid), newOid);
+  indexOid(newOid);
+  generation++;
   return true;
 }
 
@@ -161,11 +189,15 @@ bool Mibtable::clearMibtable() {
     return false;
   }
   //Delete oids
+  WriteGuard guard(tableLock);
   for (auto& oid : oids) {
     delete oid;
   }
   //Finally clear OIDs vector
   oids.clear();
+  oidIndex.clear();
+  filter.clear();
+  generation++;
   return true;
 }
 
@@ -175,6 +207,16 @@ bool Mibtable::clearMibtable() {
 **/
 
 void Mibtable::sortMibTable() {
+  WriteGuard guard(tableLock);
+  sortOids();
+}
+
+/**
+ * @function sortOids
+ * @description sort oids vector; table lock must be held exclusively
+**/
+
+void Mibtable::sortOids() {
 
   /*
   Sort oids, sorting is made from "least" to "greatest"
@@ -188,6 +230,7 @@ void Mibtable::sortMibTable() {
   7) .1.3.6.1.4.1.1994.102.3.1
   */
   std::sort(oids.begin(), oids.end(), sortByOid);
+  generation++;
 }
 
 /**
@@ -199,7 +242,51 @@ void Mibtable::sortMibTable() {
 **/
 
 Oid* Mibtable::getOidByOid(const std::string& oidString) {
+  ReadGuard guard(tableLock);
+  return findOid(oidString);
+}
+
+/**
+ * @function getOidByKey
+ * @description Given an OID key (see oidKey), this function returns the OID object associated
+ * @param uint64_t OID key
+ * @returns Oid*: pointer to Oid object; nullptr if not found
+ * NOTE: on key collision the OID which was indexed first is returned
+**/
+
+Oid* Mibtable::getOidByKey(uint64_t key) {
+  ReadGuard guard(tableLock);
+  if (!filterMayContain(key)) {
+    return nullptr;
+  }
+  std::unordered_map<uint64_t, Oid*>::iterator indexIt = oidIndex.find(key);
+  return indexIt != oidIndex.end() ? indexIt->second : nullptr;
+}
 
+/**
+ * @function findOid
+ * @description look up OID object; table lock must be held
+ * @param std::string: OID string to find
+ * @returns Oid*: pointer to Oid object; nullptr if not found
+**/
+
+Oid* Mibtable::findOid(const std::string& oidString) {
+
+  //Nonexistent OIDs are mostly rejected by the filter, without probing the index
+  uint64_t key = oidKey(oidString);
+  if (!filterMayContain(key)) {
+    return nullptr;
+  }
+  //Look up index first
+  std::unordered_map<uint64_t, Oid*>::iterator indexIt = oidIndex.find(key);
+  if (indexIt == oidIndex.end()) {
+    return nullptr;
+  }
+  if (indexIt->second->getOid() == oidString) {
+    return indexIt->second;
+  }
+
+  //Key collision, fallback to table scan
   for (auto& oid : oids) {
     //Check if the oid is the same
     if (oid->getOid() == oidString) {
@@ -210,6 +297,65 @@ Oid* Mibtable::getOidByOid(const std::string& oidString) {
   return nullptr;
 }
 
+/**
+ * @function indexOid
+ * @description add OID to key index and lookup filter; table lock must be held exclusively
+ * @param Oid* oid to index
+ * NOTE: on key collision the first OID is kept in the index; getOidByOid falls back to scan
+**/
+
+void Mibtable::indexOid(Oid* oid) {
+
+  if (!oidIndex.insert(std::make_pair(oid->getKey(), oid)).second) {
+    std::stringstream logStream;
+    logStream << "Key collision for OID " << oid->getOid();
+    logger::log(COMPONENT, LOG_DEBUG, logStream.str());
+    //Colliding OIDs share the key, which is already in the filter
+    return;
+  }
+  if (oidIndex.size() > filter.size() * MIBTABLE_FILTER_OIDS_PER_WORD) {
+    buildFilter();
+    return;
+  }
+  uint64_t hash = mixKey(oid->getKey());
+  filter[hash & (filter.size() - 1)] |= filterBits(hash);
+}
+
+/**
+ * @function buildFilter
+ * @description size the lookup filter for twice the indexed keys and fill it; table lock must be held exclusively
+**/
+
+void Mibtable::buildFilter() {
+
+  size_t words = 64;
+  while (words * MIBTABLE_FILTER_OIDS_PER_WORD < oidIndex.size() * 2) {
+    words *= 2;
+  }
+  filter.assign(words, 0);
+  for (auto& entry : oidIndex) {
+    uint64_t hash = mixKey(entry.first);
+    filter[hash & (words - 1)] |= filterBits(hash);
+  }
+}
+
+/**
+ * @function filterMayContain
+ * @description check whether an OID key may be in the table; table lock must be held
+ * @param uint64_t OID key
+ * @returns bool: false if the key is surely not in the table
+**/
+
+bool Mibtable::filterMayContain(uint64_t key) {
+
+  if (filter.empty()) {
+    return false;
+  }
+  uint64_t hash = mixKey(key);
+  uint64_t bits = filterBits(hash);
+  return (filter[hash & (filter.size() - 1)] & bits) == bits;
+}
+
 /**
  * @function getOidByName
  * @description Given a OID name, this function returns the OID object associated
@@ -219,6 +365,7 @@ Oid* Mibtable::getOidByOid(const std::string& oidString) {
 **/
 
 Oid* Mibtable::getOidByName(const std::string& oidName) {
+  ReadGuard guard(tableLock);
   for (auto& oid : oids) {
     //Check if the oid is the same
     if (oid->getName() == oidName) {
@@ -238,6 +385,7 @@ Oid* Mibtable::getOidByName(const std::string& oidName) {
 
 std::string Mibtable::getNextOid(const std::string& oidString) {
 
+  ReadGuard guard(tableLock);
   bool oidFound = false;
   for (auto& oid : oids) {
     //If oid has been found in the previous cycle, return oid (which is the 'next')
@@ -254,6 +402,93 @@ std::string Mibtable::getNextOid(const std::string& oidString) {
   return "";
 }
 
+/**
+ * @function getSuccessor
+ * @description find the first OID which follows provided one in the table; provided OID doesn't need to exist
+ * @param std::string oid string
+ * @param bool inclusive: if true, provided OID itself is returned if it exists
+ * @returns Oid*: following OID; nullptr if provided OID is past the end of the table
+**/
+
+Oid* Mibtable::getSuccessor(const std::string& oidString, bool inclusive /* = false */) {
+
+  ReadGuard guard(tableLock);
+  std::vector<Oid*>::iterator oidIt;
+  if (inclusive) {
+    oidIt = std::lower_bound(oids.begin(), oids.end(), oidString, [](Oid* oid, const std::string& value) { return compareOids(oid->getOid(), value) < 0; });
+  } else {
+    oidIt = std::upper_bound(oids.begin(), oids.end(), oidString, [](const std::string& value, Oid* oid) { return compareOids(value, oid->getOid()) < 0; });
+  }
+  return oidIt != oids.end() ? *oidIt : nullptr;
+}
+
+/**
+ * @function getSuccessors
+ * @description collect the OIDs which follow provided one, locating it once and scanning the table from there
+ * @param std::string oid string; it doesn't need to exist
+ * @param size_t max amount of OIDs to collect
+ * @param std::vector<Oid*>& successors, in table order
+ * @param bool (*)(Oid*) accept: OIDs it returns false for are skipped; all are collected if nullptr
+ * @returns size_t: amount of OIDs collected
+**/
+
+size_t Mibtable::getSuccessors(const std::string& oidString, size_t amount, std::vector<Oid*>& successors, bool (*accept)(Oid*) /* = nullptr */) {
+
+  successors.clear();
+  ReadGuard guard(tableLock);
+  std::vector<Oid*>::iterator oidIt = std::upper_bound(oids.begin(), oids.end(), oidString, [](const std::string& value, Oid* oid) { return compareOids(value, oid->getOid()) < 0; });
+  for (; oidIt != oids.end() && successors.size() < amount; ++oidIt) {
+    if (accept == nullptr || accept(*oidIt)) {
+      successors.push_back(*oidIt);
+    }
+  }
+  return successors.size();
+}
+
+/**
+ * @function getNext
+ * @description find the first OID which follows provided one; when provided OID is the one last returned
+ * to the same cursor, the scan continues from its position, otherwise the table is searched
+ * @param std::string oid string; it doesn't need to exist
+ * @param walkCursor& cursor of the client; updated with the returned OID
+ * @param bool (*)(Oid*) accept: OIDs it returns false for are skipped; all are accepted if nullptr
+ * @returns Oid*: following OID; nullptr if there are no accepted OIDs after provided one
+**/
+
+Oid* Mibtable::getNext(const std::string& oidString, walkCursor& cursor, bool (*accept)(Oid*) /* = nullptr */) {
+
+  ReadGuard guard(tableLock);
+  size_t position;
+  if (cursor.generation == generation && cursor.position < oids.size() && oids[cursor.position]->getOid() == oidString) {
+    cursorHits++;
+    position = cursor.position + 1;
+  } else {
+    cursorMisses++;
+    position = std::upper_bound(oids.begin(), oids.end(), oidString, [](const std::string& value, Oid* oid) { return compareOids(value, oid->getOid()) < 0; }) - oids.begin();
+  }
+  for (; position < oids.size(); position++) {
+    if (accept == nullptr || accept(oids[position])) {
+      cursor.position = position;
+      cursor.generation = generation;
+      return oids[position];
+    }
+  }
+  cursor.generation = 0;
+  return nullptr;
+}
+
+/**
+ * @function getCursorStats
+ * @description get walk cursor counters: GETNEXT lookups which continued from the cursor and those which searched the table
+ * @param uint64_t& hits
+ * @param uint64_t& misses
+**/
+
+void Mibtable::getCursorStats(uint64_t& hits, uint64_t& misses) {
+  hits = cursorHits;
+  misses = cursorMisses;
+}
+
 /**
  * @function getPreviousOid
  * @description given an oid, find the immediate previous oid
@@ -262,16 +497,28 @@ std::string Mibtable::getNextOid(const std::string& oidString) {
 **/
 
 std::string Mibtable::getPreviousOid(const std::string& oidString) {
+  ReadGuard guard(tableLock);
+  return findPreviousOid(oidString);
+}
 
-  Oid* previousOid = nullptr;
-  for (auto& oid : oids) {
-    //Check if previousOid is not nullptr and current oid is equal to provided one
-    if (oid->getOid() == oidString && previousOid != nullptr) {
-      return previousOid->getOid();
-    }
-    previousOid = oid;
+/**
+ * @function findPreviousOid
+ * @description given an oid, find the immediate previous oid; table lock must be held
+ * @param std::string oid string
+ * @returns std::string previous oid string
+**/
+
+std::string Mibtable::findPreviousOid(const std::string& oidString) {
+
+  //Nonexistent OIDs have no previous OID; don't search the table for them
+  if (findOid(oidString) == nullptr) {
+    return "";
   }
-  return "";
+  std::vector<Oid*>::iterator oidIt = std::lower_bound(oids.begin(), oids.end(), oidString, [](Oid* oid, const std::string& value) { return compareOids(oid->getOid(), value) < 0; });
+  if (oidIt == oids.begin() || oidIt == oids.end() || (*oidIt)->getOid() != oidString) {
+    return "";
+  }
+  return (*(oidIt - 1))->getOid();
 }
 
 /**
@@ -293,7 +540,8 @@ bool Mibtable::isTableChild(const std::string& oidString) {
     return false;
   }
   //Get grandParent OID
-  Oid* grandParentOid = this->getOidByOid(this->getPreviousOid(parentOidStr));
+  ReadGuard guard(tableLock);
+  Oid* grandParentOid = findOid(findPreviousOid(parentOidStr));
   if (grandParentOid != nullptr) {
     //Check if it is table
     if (grandParentOid->getPrimitiveType() == PRIMITIVE_SEQUENCE) {
@@ -32,10 +32,16 @@
 #include <core/primitives/sequence.hpp>
 #include <core/primitives/string.hpp>
 #include <core/primitives/timeticks.hpp>
+#include <mibscheduler/event.hpp>
+#include <utils/databasefacade.hpp>
+#include <utils/logger.hpp>
 
 #include <algorithm>
+#include <stdexcept>
 #include <vector>
 
+#define COMPONENT "OID"
+
 namespace murmure {
 
 /**
@@ -51,6 +57,7 @@ Oid::Oid(const std::string& oid, const std::string& type, const std::string& val
 
   //Set OID string
   this->oid = oid;
+  this->key = oidKey(oid);
 
   //Init data to nullptr
   data = nullptr;
@@ -61,6 +68,52 @@ Oid::Oid(const std::string& oid, const std::string& type, const std::string& val
   this->dataType = type;
   this->primitiveType = type;
   //Based on type instance new Primitive type
+  data = newData(value);
+
+  //Set access mode
+  switch (access) {
+  case ACCESSMODE_NOTACCESSIBLE:
+    this->accessMode = AccessMode::NOT_ACCESSIBLE;
+    break;
+  case ACCESSMODE_READONLY:
+    this->accessMode = AccessMode::READONLY;
+    break;
+  case ACCESSMODE_READCREATE:
+    this->accessMode = AccessMode::READCREATE;
+    break;
+  case ACCESSMODE_READWRITE:
+    this->accessMode = AccessMode::READWRITE;
+    break;
+  }
+  //Set name
+  this->name = name;
+  //Value has never been refreshed nor read
+  this->lastUpdate = std::chrono::steady_clock::time_point::min();
+  this->lastRead = std::chrono::steady_clock::time_point::min();
+}
+
+/**
+ * @function ~Oid
+ * @description Oid class destructor
+**/
+
+Oid::~Oid() {
+  //Delete data if exists
+  freeData(data);
+}
+
+/**
+ * @function newData
+ * @description instance new Primitive (or module) for OID data type
+ * @param std::string value to initialize primitive with
+ * @returns void*: pointer to Primitive extension class; nullptr if type could not be resolved
+ * NOTE: primitive type is updated if data type is a module
+**/
+
+void* Oid::newData(const std::string& value) {
+
+  void* data = nullptr;
+  const std::string& type = this->dataType;
   if (type == PRIMITIVE_COUNTER) {
     data = new Counter<unsigned int>(value);
   } else if (type == PRIMITIVE_GAUGE) {
@@ -81,8 +134,7 @@ Oid::Oid(const std::string& oid, const std::string& type, const std::string& val
     data = new Timeticks<unsigned int>(value);
   } else {
     //Could be a module, in case instance data as moduleFacade
-    data = new ModuleFacade();
-    ModuleFacade* module = reinterpret_cast<ModuleFacade*>(this->data);
+    ModuleFacade* module = new ModuleFacade();
     //Try to instance module
     if (module->findModule(this->dataType)) {
       //Module has been found!
@@ -90,71 +142,55 @@ Oid::Oid(const std::string& oid, const std::string& type, const std::string& val
       this->primitiveType = module->getPrimitiveType();
       //Set value
       module->setValue(value);
+      data = module;
     } else {
       //Module hasn't been found, delete data and reset to nullptr
       delete module;
-      data = nullptr;
     }
   }
-
-  //Set access mode
-  switch (access) {
-  case ACCESSMODE_NOTACCESSIBLE:
-    this->accessMode = AccessMode::NOT_ACCESSIBLE;
-    break;
-  case ACCESSMODE_READONLY:
-    this->accessMode = AccessMode::READONLY;
-    break;
-  case ACCESSMODE_READCREATE:
-    this->accessMode = AccessMode::READCREATE;
-    break;
-  case ACCESSMODE_READWRITE:
-    this->accessMode = AccessMode::READWRITE;
-    break;
-  }
-  //Set name
-  this->name = name;
+  return data;
 }
 
 /**
- * @function ~Oid
- * @description Oid class destructor
+ * @function freeData
+ * @description delete Primitive (or module) instance
+ * @param void* data to delete
 **/
 
-Oid::~Oid() {
-  //Delete data if exists
-  if (data != nullptr) {
-    if (this->dataType == PRIMITIVE_COUNTER) {
-      Counter<unsigned int>* realData = reinterpret_cast<Counter<unsigned int>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_GAUGE) {
-      Gauge<unsigned int>* realData = reinterpret_cast<Gauge<unsigned int>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_INTEGER) {
-      Integer<int>* realData = reinterpret_cast<Integer<int>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_IPADRRESS) {
-      IPAddress<std::string>* realData = reinterpret_cast<IPAddress<std::string>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_OBJECTID) {
-      Objectid<std::string>* realData = reinterpret_cast<Objectid<std::string>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_OCTET) {
-      Octet<uint8_t*>* realData = reinterpret_cast<Octet<uint8_t*>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_SEQUENCE) {
-      Sequence<std::string>* realData = reinterpret_cast<Sequence<std::string>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_STRING) {
-      String<std::string>* realData = reinterpret_cast<String<std::string>*>(this->data);
-      delete realData;
-    } else if (this->dataType == PRIMITIVE_TIMETICKS) {
-      Timeticks<unsigned int>* realData = reinterpret_cast<Timeticks<unsigned int>*>(this->data);
-      delete realData;
-    } else {
-      ModuleFacade* module = reinterpret_cast<ModuleFacade*>(this->data);
-      delete module;
-    }
+void Oid::freeData(void* data) {
+  if (data == nullptr) {
+    return;
+  }
+  if (this->dataType == PRIMITIVE_COUNTER) {
+    Counter<unsigned int>* realData = reinterpret_cast<Counter<unsigned int>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_GAUGE) {
+    Gauge<unsigned int>* realData = reinterpret_cast<Gauge<unsigned int>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_INTEGER) {
+    Integer<int>* realData = reinterpret_cast<Integer<int>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_IPADRRESS) {
+    IPAddress<std::string>* realData = reinterpret_cast<IPAddress<std::string>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_OBJECTID) {
+    Objectid<std::string>* realData = reinterpret_cast<Objectid<std::string>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_OCTET) {
+    Octet<uint8_t*>* realData = reinterpret_cast<Octet<uint8_t*>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_SEQUENCE) {
+    Sequence<std::string>* realData = reinterpret_cast<Sequence<std::string>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_STRING) {
+    String<std::string>* realData = reinterpret_cast<String<std::string>*>(data);
+    delete realData;
+  } else if (this->dataType == PRIMITIVE_TIMETICKS) {
+    Timeticks<unsigned int>* realData = reinterpret_cast<Timeticks<unsigned int>*>(data);
+    delete realData;
+  } else {
+    ModuleFacade* module = reinterpret_cast<ModuleFacade*>(data);
+    delete module;
   }
 }
 
@@ -168,6 +204,16 @@ std::string Oid::getOid() {
   return this->oid;
 }
 
+/**
+ * @function getKey
+ * @description returns numeric key of the OID string
+ * @returns uint64_t
+**/
+
+uint64_t Oid::getKey() {
+  return this->key;
+}
+
 /**
  * @function getType
  * @description returns type string
@@ -205,6 +251,7 @@ std::string Oid::getName() {
 **/
 
 std::string Oid::getPrintableValue() {
+  std::lock_guard<std::mutex> lock(valueMutex);
   if (this->dataType == PRIMITIVE_COUNTER) {
     Counter<unsigned int>* realData = reinterpret_cast<Counter<unsigned int>*>(this->data);
     return realData->getPrintableValue();
@@ -277,38 +324,127 @@ int Oid::getAccessModeInteger() {
 
 bool Oid::setValue(std::string printableValue) {
 
+  std::lock_guard<std::mutex> lock(valueMutex);
+  bool result;
   //Value set operation is managed by Primitive extended class
   if (this->dataType == PRIMITIVE_COUNTER) {
     Counter<unsigned int>* realData = reinterpret_cast<Counter<unsigned int>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_GAUGE) {
     Gauge<unsigned int>* realData = reinterpret_cast<Gauge<unsigned int>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_INTEGER) {
     Integer<int>* realData = reinterpret_cast<Integer<int>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_IPADRRESS) {
     IPAddress<std::string>* realData = reinterpret_cast<IPAddress<std::string>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_OBJECTID) {
     Objectid<std::string>* realData = reinterpret_cast<Objectid<std::string>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_OCTET) {
     Octet<uint8_t*>* realData = reinterpret_cast<Octet<uint8_t*>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_SEQUENCE) {
     Sequence<std::string>* realData = reinterpret_cast<Sequence<std::string>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_STRING) {
     String<std::string>* realData = reinterpret_cast<String<std::string>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else if (this->dataType == PRIMITIVE_TIMETICKS) {
     Timeticks<unsigned int>* realData = reinterpret_cast<Timeticks<unsigned int>*>(this->data);
-    return realData->setValue(this->oid, printableValue);
+    result = realData->setValue(this->oid, printableValue);
   } else {
     ModuleFacade* module = reinterpret_cast<ModuleFacade*>(this->data);
-    return module->setValue(this->oid, printableValue);
+    result = module->setValue(this->oid, printableValue);
   }
+  if (result) {
+    lastUpdate = std::chrono::steady_clock::now();
+  }
+  return result;
+}
+
+/**
+ * @function reloadValue
+ * @description read the OID value from database again, e.g. after an external process has changed it
+ * @returns bool: true if value has been reloaded
+**/
+
+bool Oid::reloadValue() {
+
+  std::string errorString;
+  std::vector<std::vector<std::string>> result;
+  std::string query = "SELECT value FROM oids WHERE oid = \"" + this->oid + "\";";
+  if (!database::select(&result, query, errorString)) {
+    logger::log(COMPONENT, LOG_ERROR, errorString);
+    return false;
+  }
+  if (result.size() == 0 || result.at(0).size() == 0) {
+    return false;
+  }
+  if (!loadValue(result.at(0).at(0))) {
+    logger::log(COMPONENT, LOG_ERROR, "Invalid value in database for OID " + this->oid);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function loadValue
+ * @description replace the value with a printable one, without writing it to database
+ * @param std::string printable value
+ * @returns bool: true if value is valid for the OID type
+**/
+
+bool Oid::loadValue(const std::string& printableValue) {
+
+  //Instance new data with the value and replace the current one
+  void* newValue;
+  try {
+    newValue = newData(printableValue);
+  } catch (std::exception& ex) {
+    return false;
+  }
+  if (newValue == nullptr) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(valueMutex);
+  freeData(data);
+  data = newValue;
+  lastUpdate = std::chrono::steady_clock::now();
+  return true;
+}
+
+/**
+ * @function getLastUpdate
+ * @description returns the time the value was last set or reloaded
+ * @returns time_point: time_point::min() if value has never been refreshed since loading
+**/
+
+std::chrono::steady_clock::time_point Oid::getLastUpdate() {
+  std::lock_guard<std::mutex> lock(valueMutex);
+  return this->lastUpdate;
+}
+
+/**
+ * @function markRead
+ * @description record that the value has been requested now
+**/
+
+void Oid::markRead() {
+  std::lock_guard<std::mutex> lock(valueMutex);
+  lastRead = std::chrono::steady_clock::now();
+}
+
+/**
+ * @function getLastRead
+ * @description returns the time the value was last requested
+ * @returns time_point: time_point::min() if value has never been requested since loading
+**/
+
+std::chrono::steady_clock::time_point Oid::getLastRead() {
+  std::lock_guard<std::mutex> lock(valueMutex);
+  return this->lastRead;
 }
 
 /**
@@ -321,6 +457,60 @@ bool Oid::isTypeValid() {
   return (data != nullptr);
 }
 
+/**
+ * @function attachEvent
+ * @description bind an event to this OID, so that it can be fetched by mode without searching
+ * @param Event* event to attach; only GET and SET events are kept
+**/
+
+void Oid::attachEvent(Event* event) {
+  if (event->getMode() == EventMode::GET) {
+    getEventList.push_back(event);
+  } else if (event->getMode() == EventMode::SET) {
+    setEventList.push_back(event);
+  }
+}
+
+/**
+ * @function detachEvent
+ * @description unbind an event from this OID
+ * @param Event* event to detach
+ * NOTE: event is not freed, since it's owned by the scheduler
+**/
+
+void Oid::detachEvent(Event* event) {
+  std::vector<Event*>& eventList = event->getMode() == EventMode::GET ? getEventList : setEventList;
+  eventList.erase(std::remove(eventList.begin(), eventList.end(), event), eventList.end());
+}
+
+/**
+ * @function detachEvents
+ * @description unbind all events from this OID
+ * NOTE: events are not freed, since they're owned by the scheduler
+**/
+
+void Oid::detachEvents() {
+  getEventList.clear();
+  setEventList.clear();
+}
+
+/**
+ * @function getEvents
+ * @description returns events bound to this OID for the provided mode
+ * @param EventMode
+ * @returns const std::vector<Event*>&: empty for modes which are not dispatched by OID
+**/
+
+const std::vector<Event*>& Oid::getEvents(EventMode mode) {
+  static const std::vector<Event*> noEvents;
+  if (mode == EventMode::GET) {
+    return getEventList;
+  } else if (mode == EventMode::SET) {
+    return setEventList;
+  }
+  return noEvents;
+}
+
 /**
  * @function sortByOid
  * @description sort oid instance by their oid (to use with sort)
@@ -330,7 +520,77 @@ bool Oid::isTypeValid() {
 **/
 
 bool sortByOid(Oid* firstOid, Oid* secondOid) {
-  return firstOid->getOid().compare(secondOid->getOid()) < 0;
+  return compareOids(firstOid->getOid(), secondOid->getOid()) < 0;
+}
+
+/**
+ * @function nextSubid
+ * @description parse next sub-identifier of an OID string
+ * @param std::string oid
+ * @param size_t& position; moved past the sub-identifier
+ * @param uint64_t& sub-identifier
+ * @returns bool: false if there are no more sub-identifiers
+**/
+
+static bool nextSubid(const std::string& oid, size_t& position, uint64_t& subid) {
+  while (position < oid.length() && oid[position] == '.') {
+    position++;
+  }
+  if (position >= oid.length()) {
+    return false;
+  }
+  subid = 0;
+  while (position < oid.length() && oid[position] >= '0' && oid[position] <= '9') {
+    subid = subid * 10 + (oid[position++] - '0');
+  }
+  //Skip invalid characters
+  while (position < oid.length() && oid[position] != '.') {
+    position++;
+  }
+  return true;
+}
+
+/**
+ * @function compareOids
+ * @description compare OID strings by their sub-identifiers (SNMP lexicographic order)
+ * @param std::string first oid
+ * @param std::string second oid
+ * @returns int: < 0 if first oid precedes second oid; 0 if equal; > 0 otherwise
+ * NOTE: e.g. .1.3.6.1.2 < .1.3.6.1.10 and .1.3.6.1 < .1.3.6.1.0
+**/
+
+int compareOids(const std::string& firstOid, const std::string& secondOid) {
+  size_t firstPosition = 0;
+  size_t secondPosition = 0;
+  uint64_t firstSubid = 0;
+  uint64_t secondSubid = 0;
+  while (true) {
+    bool firstHasNext = nextSubid(firstOid, firstPosition, firstSubid);
+    bool secondHasNext = nextSubid(secondOid, secondPosition, secondSubid);
+    if (!firstHasNext || !secondHasNext) {
+      return static_cast<int>(firstHasNext) - static_cast<int>(secondHasNext);
+    }
+    if (firstSubid != secondSubid) {
+      return firstSubid < secondSubid ? -1 : 1;
+    }
+  }
+}
+
+/**
+ * @function oidKey
+ * @description calculate numeric key for an OID string (64 bit FNV-1a)
+ * @param std::string oid
+ * @returns uint64_t
+ * NOTE: keys are used for indexing only; collisions are possible and must be checked comparing OID strings
+**/
+
+uint64_t oidKey(const std::string& oid) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char& c : oid) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
 }
 
 }
@@ -0,0 +1,234 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <core/passpersist.hpp>
+#include <utils/logger.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#define COMPONENT "PassPersist"
+
+namespace murmure {
+
+/**
+ * @function LineView
+ * @description LineView class constructor (empty line)
+**/
+
+LineView::LineView() : data(nullptr), length(0) {
+}
+
+/**
+ * @function LineView
+ * @description LineView class constructor
+ * @param const char* line start
+ * @param size_t line length
+**/
+
+LineView::LineView(const char* data, size_t length) : data(data), length(length) {
+}
+
+/**
+ * @function equals
+ * @description compare line with a string
+ * @param const char* text
+ * @returns bool: true if line equals text
+**/
+
+bool LineView::equals(const char* text) const {
+  size_t textLength = strlen(text);
+  return textLength == length && memcmp(data, text, length) == 0;
+}
+
+/**
+ * @function empty
+ * @description returns whether line is empty
+ * @returns bool
+**/
+
+bool LineView::empty() const {
+  return length == 0;
+}
+
+/**
+ * @function find
+ * @description find first occurrence of character
+ * @param char character
+ * @returns size_t: position; std::string::npos if not found
+**/
+
+size_t LineView::find(char character) const {
+  const void* found = memchr(data, character, length);
+  return found != nullptr ? static_cast<const char*>(found) - data : std::string::npos;
+}
+
+/**
+ * @function copyTo
+ * @description copy line into target string, reusing its capacity
+ * @param std::string& target
+**/
+
+void LineView::copyTo(std::string& target) const {
+  target.assign(data, length);
+}
+
+/**
+ * @function PassPersist
+ * @description PassPersist class constructor
+ * @param int file descriptor requests are read from
+ * @param int file descriptor responses are written to
+**/
+
+PassPersist::PassPersist(int inputFd, int outputFd) {
+  this->inputFd = inputFd;
+  this->outputFd = outputFd;
+  this->buffer = new char[PASSPERSIST_BUFFER_SIZE];
+  this->begin = 0;
+  this->end = 0;
+  this->eof = false;
+  this->discarding = false;
+}
+
+/**
+ * @function ~PassPersist
+ * @description PassPersist class destructor
+**/
+
+PassPersist::~PassPersist() {
+  delete[] buffer;
+}
+
+/**
+ * @function readLine
+ * @description read next request line; lines longer than the buffer are truncated, and the rest is discarded up to their newline
+ * @param LineView& line, valid until next call
+ * @returns bool: false if input has terminated
+**/
+
+bool PassPersist::readLine(LineView& line) {
+
+  size_t searchFrom = begin;
+  while (true) {
+    char* newline = static_cast<char*>(memchr(buffer + searchFrom, '\n', end - searchFrom));
+    if (newline != nullptr) {
+      if (discarding) {
+        //End of the line too long; requests start after it
+        discarding = false;
+        begin = newline - buffer + 1;
+        searchFrom = begin;
+        continue;
+      }
+      line = LineView(buffer + begin, newline - (buffer + begin));
+      begin = newline - buffer + 1;
+      return true;
+    }
+    if (eof) {
+      //Last line without newline
+      if (begin < end && !discarding) {
+        line = LineView(buffer + begin, end - begin);
+        begin = end;
+        return true;
+      }
+      return false;
+    }
+    //Make room: move pending data to buffer start
+    if (discarding) {
+      begin = 0;
+      end = 0;
+    } else if (begin > 0) {
+      memmove(buffer, buffer + begin, end - begin);
+      end -= begin;
+      begin = 0;
+    }
+    if (end == PASSPERSIST_BUFFER_SIZE) {
+      //Line is still served, so that requests and responses stay paired
+      logger::log(COMPONENT, LOG_ERROR, "Request line too long; truncated");
+      line = LineView(buffer, end);
+      begin = end;
+      discarding = true;
+      return true;
+    }
+    searchFrom = end;
+    if (!fill()) {
+      eof = true;
+    }
+  }
+}
+
+/**
+ * @function fill
+ * @description read available input into buffer
+ * @returns bool: false if input has terminated
+**/
+
+bool PassPersist::fill() {
+
+  while (true) {
+    ssize_t readBytes = read(inputFd, buffer + end, PASSPERSIST_BUFFER_SIZE - end);
+    if (readBytes > 0) {
+      end += readBytes;
+      return true;
+    } else if (readBytes < 0 && errno == EINTR) {
+      continue;
+    }
+    return false;
+  }
+}
+
+/**
+ * @function getResponse
+ * @description returns the response being prepared
+ * @returns std::string&
+**/
+
+std::string& PassPersist::getResponse() {
+  return response;
+}
+
+/**
+ * @function flush
+ * @description write the prepared response (usually with a single write) and clear it
+ * @returns bool: true if response has been written
+**/
+
+bool PassPersist::flush() {
+
+  size_t written = 0;
+  while (written < response.length()) {
+    ssize_t writtenBytes = write(outputFd, response.data() + written, response.length() - written);
+    if (writtenBytes < 0 && errno == EINTR) {
+      continue;
+    } else if (writtenBytes < 0) {
+      logger::log(COMPONENT, LOG_ERROR, "Could not write response: " + std::string(strerror(errno)));
+      response.clear();
+      return false;
+    }
+    written += writtenBytes;
+  }
+  response.clear();
+  return true;
+}
+
+}
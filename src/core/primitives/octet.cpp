@@ -43,7 +43,8 @@ void Octet<uint8_t*>::valueToHex(const std::string& ascii) {
 
   size_t asciiLength = ascii.length();
   const char* asciiBuf = ascii.c_str();
-  for (size_t i = 0; i < asciiLength; i++) {
+  //Two hex digits per byte
+  for (size_t i = 0; i < asciiLength / 2; i++) {
     char digit[4];
     digit[0] = *(asciiBuf++);
     digit[1] = *(asciiBuf++);
@@ -0,0 +1,179 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <core/settransaction.hpp>
+#include <utils/logger.hpp>
+
+#include <sstream>
+
+#define COMPONENT "SetTransaction"
+
+namespace murmure {
+
+/**
+ * @function SetTransaction
+ * @description SetTransaction class constructor
+ * @param Mibtable* mibtable to change
+ * @param Scheduler* scheduler which executes SET events
+**/
+
+SetTransaction::SetTransaction(Mibtable* mibtable, Scheduler* scheduler) {
+  this->mibtable = mibtable;
+  this->scheduler = scheduler;
+  this->committed = false;
+}
+
+/**
+ * @function test
+ * @description check that a varbind can be set; it's kept until cleanup
+ * @param varbind
+ * @returns uint16_t: SNMP error status
+**/
+
+uint16_t SetTransaction::test(const varbind& binding) {
+
+  pendingSet pending;
+  pending.oid = binding.oid;
+  pending.target = mibtable->getOidByOid(binding.oid);
+  pending.parent = nullptr;
+  pending.applied = false;
+  std::string primitiveType;
+  if (pending.target != nullptr) {
+    if (pending.target->getAccessMode() != AccessMode::READWRITE) {
+      return SNMP_ERR_NOTWRITABLE;
+    }
+    primitiveType = pending.target->getPrimitiveType();
+  } else {
+    //Table entries can be created if table is READCREATE
+    size_t lastDotPos = binding.oid.find_last_of('.');
+    std::string parentOid = lastDotPos != std::string::npos ? binding.oid.substr(0, lastDotPos) : "";
+    pending.parent = mibtable->isTableChild(parentOid) ? mibtable->getOidByOid(parentOid) : nullptr;
+    if (pending.parent == nullptr || (pending.parent->getAccessMode() != AccessMode::READCREATE && pending.parent->getAccessMode() != AccessMode::READWRITE)) {
+      return SNMP_ERR_NOCREATION;
+    }
+    primitiveType = pending.parent->getPrimitiveType();
+  }
+  if (!decodeValue(binding, primitiveType, pending.value)) {
+    return SNMP_ERR_WRONGTYPE;
+  }
+  pendingSets.push_back(pending);
+  return SNMP_ERR_NOERROR;
+}
+
+/**
+ * @function commit
+ * @description set tested values
+ * @param uint16_t& index of the failed varbind (1 based)
+ * @returns uint16_t: SNMP error status
+**/
+
+uint16_t SetTransaction::commit(uint16_t& index) {
+
+  index = 0;
+  for (auto& pending : pendingSets) {
+    index++;
+    if (pending.target == nullptr) {
+      Oid* childOid = new Oid(pending.oid, pending.parent->getType(), pending.value, ACCESSMODE_READWRITE, pending.parent->getName());
+      if (!mibtable->addOid(childOid)) {
+        delete childOid;
+        logger::log(COMPONENT, LOG_ERROR, "Unable to create OID " + pending.oid);
+        return SNMP_ERR_COMMITFAILED;
+      }
+      pending.target = childOid;
+    } else {
+      pending.previous = pending.target->getPrintableValue();
+      if (!pending.target->setValue(pending.value)) {
+        logger::log(COMPONENT, LOG_ERROR, "Unable to set value for OID " + pending.oid);
+        return SNMP_ERR_COMMITFAILED;
+      }
+    }
+    pending.applied = true;
+  }
+  committed = true;
+  index = 0;
+  return SNMP_ERR_NOERROR;
+}
+
+/**
+ * @function undo
+ * @description restore values changed by commit
+ * @param uint16_t& index of the failed varbind (1 based)
+ * @returns uint16_t: SNMP error status
+ * NOTE: created table entries can't be removed
+**/
+
+uint16_t SetTransaction::undo(uint16_t& index) {
+
+  uint16_t error = SNMP_ERR_NOERROR;
+  index = 0;
+  for (size_t i = 0; i < pendingSets.size(); i++) {
+    pendingSet& pending = pendingSets.at(i);
+    if (!pending.applied) {
+      continue;
+    }
+    if (pending.parent != nullptr || !pending.target->setValue(pending.previous)) {
+      logger::log(COMPONENT, LOG_ERROR, "Unable to undo SET on OID " + pending.oid);
+      error = SNMP_ERR_UNDOFAILED;
+      index = static_cast<uint16_t>(i + 1);
+      continue;
+    }
+    pending.applied = false;
+  }
+  committed = false;
+  return error;
+}
+
+/**
+ * @function cleanup
+ * @description the transaction is over; SET events of committed values are executed
+**/
+
+void SetTransaction::cleanup() {
+
+  if (committed) {
+    for (auto& pending : pendingSets) {
+      std::stringstream setStream;
+      setStream << "Received SET for OID " << pending.oid << "; Value: " << pending.value;
+      logger::log(COMPONENT, LOG_INFO, setStream.str());
+      if (pending.parent != nullptr) {
+        //Exec SET commands for table OID; new OID is exported as SNMP_OID
+        scheduler->fetchAndExec(pending.parent, EventMode::SET, pending.value, pending.oid);
+      } else {
+        scheduler->fetchAndExec(pending.target, EventMode::SET, pending.value);
+      }
+    }
+  }
+  clear();
+}
+
+/**
+ * @function clear
+ * @description drop pending sets without executing their events
+**/
+
+void SetTransaction::clear() {
+  pendingSets.clear();
+  committed = false;
+}
+
+}
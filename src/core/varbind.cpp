@@ -0,0 +1,153 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <core/varbind.hpp>
+
+#include <arpa/inet.h>
+#include <stdexcept>
+
+namespace murmure {
+
+/**
+ * @function isLeaf
+ * @description returns whether oid has a value which can be served to SNMP managers
+ * @param Oid*
+ * @returns bool
+**/
+
+bool isLeaf(Oid* oid) {
+  if (oid->getAccessMode() == AccessMode::NOT_ACCESSIBLE) {
+    return false;
+  }
+  std::string primitiveType = oid->getPrimitiveType();
+  return primitiveType != PRIMITIVE_SEQUENCE && primitiveType != PRIMITIVE_OBJECTID;
+}
+
+/**
+ * @function nextLeaf
+ * @description find the first leaf in a search range
+ * @param Mibtable*
+ * @param std::string start oid
+ * @param bool start oid is included
+ * @param std::string end oid (excluded); empty if unbounded
+ * @param walkCursor* client walk cursor; used when start oid is excluded
+ * @returns Oid*: nullptr if there are no leaves in range
+**/
+
+Oid* nextLeaf(Mibtable* mibtable, const std::string& start, bool include, const std::string& end /* = "" */, walkCursor* cursor /* = nullptr */) {
+  Oid* oid;
+  if (cursor != nullptr && !include) {
+    oid = mibtable->getNext(start, *cursor, isLeaf);
+  } else {
+    oid = mibtable->getSuccessor(start, include);
+    while (oid != nullptr && !isLeaf(oid)) {
+      oid = mibtable->getSuccessor(oid->getOid());
+    }
+  }
+  if (oid != nullptr && !end.empty() && compareOids(oid->getOid(), end) >= 0) {
+    return nullptr;
+  }
+  return oid;
+}
+
+/**
+ * @function encodeValue
+ * @description convert oid value into a varbind
+ * @param Oid*
+ * @param varbind& binding to fill
+ * @returns bool: false if value can't be encoded
+**/
+
+bool encodeValue(Oid* oid, varbind& binding) {
+
+  binding.oid = oid->getOid();
+  binding.number = 0;
+  binding.data.clear();
+  std::string primitiveType = oid->getPrimitiveType();
+  std::string value = oid->getPrintableValue();
+  try {
+    if (primitiveType == PRIMITIVE_INTEGER) {
+      binding.type = VarbindType::INTEGER;
+      binding.number = static_cast<uint32_t>(static_cast<int32_t>(std::stol(value)));
+    } else if (primitiveType == PRIMITIVE_COUNTER || primitiveType == PRIMITIVE_GAUGE || primitiveType == PRIMITIVE_TIMETICKS) {
+      binding.type = primitiveType == PRIMITIVE_COUNTER ? VarbindType::COUNTER32 : primitiveType == PRIMITIVE_GAUGE ? VarbindType::GAUGE32 : VarbindType::TIMETICKS;
+      binding.number = static_cast<uint32_t>(std::stoul(value));
+    } else if (primitiveType == PRIMITIVE_IPADRRESS) {
+      binding.type = VarbindType::IPADDRESS;
+      in_addr address;
+      if (inet_pton(AF_INET, value.c_str(), &address) != 1) {
+        return false;
+      }
+      binding.data.assign(reinterpret_cast<const char*>(&address), 4);
+    } else if (primitiveType == PRIMITIVE_STRING) {
+      binding.type = VarbindType::OCTETSTRING;
+      binding.data = value;
+    } else if (primitiveType == PRIMITIVE_OCTET) {
+      //Printable value is hex
+      binding.type = VarbindType::OCTETSTRING;
+      for (size_t i = 0; i + 1 < value.length(); i += 2) {
+        binding.data += static_cast<char>(std::stoul(value.substr(i, 2), nullptr, 16));
+      }
+    } else {
+      return false;
+    }
+  } catch (std::exception& ex) {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function decodeValue
+ * @description convert a varbind into the printable value of provided primitive type
+ * @param varbind
+ * @param std::string primitive type of target OID
+ * @param std::string& printable value
+ * @returns bool: false if varbind type doesn't match primitive type
+**/
+
+bool decodeValue(const varbind& binding, const std::string& primitiveType, std::string& value) {
+  if (primitiveType == PRIMITIVE_INTEGER && binding.type == VarbindType::INTEGER) {
+    value = std::to_string(static_cast<int32_t>(binding.number));
+  } else if ((primitiveType == PRIMITIVE_COUNTER && binding.type == VarbindType::COUNTER32) || (primitiveType == PRIMITIVE_GAUGE && binding.type == VarbindType::GAUGE32) || (primitiveType == PRIMITIVE_TIMETICKS && binding.type == VarbindType::TIMETICKS)) {
+    value = std::to_string(binding.number);
+  } else if (primitiveType == PRIMITIVE_IPADRRESS && binding.type == VarbindType::IPADDRESS && binding.data.length() == 4) {
+    char address[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, binding.data.data(), address, sizeof(address));
+    value = address;
+  } else if (primitiveType == PRIMITIVE_STRING && binding.type == VarbindType::OCTETSTRING) {
+    value = binding.data;
+  } else if (primitiveType == PRIMITIVE_OCTET && binding.type == VarbindType::OCTETSTRING) {
+    static const char hexmap[] = "0123456789ABCDEF";
+    value.clear();
+    for (auto& byte : binding.data) {
+      value += hexmap[(static_cast<uint8_t>(byte) & 0xF0) >> 4];
+      value += hexmap[static_cast<uint8_t>(byte) & 0x0F];
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,289 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <ingest/consumer.hpp>
+#include <utils/databasefacade.hpp>
+#include <utils/logger.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define COMPONENT "Ingest"
+
+namespace murmure {
+namespace ingest {
+
+std::atomic<uint64_t> Consumer::recordsRead(0);
+std::atomic<uint64_t> Consumer::applied(0);
+std::atomic<uint64_t> Consumer::unknown(0);
+std::atomic<uint64_t> Consumer::invalid(0);
+std::atomic<uint64_t> Consumer::dropped(0);
+
+//Collectors pushing unknown keys do it for each record; don't log all of them
+static logger::RateLimit unknownKeyLog(COMPONENT, LOG_WARN, 10, 60);
+
+/**
+ * @function quote
+ * @description escape double quotes of a value written in a query, since ingested strings are arbitrary
+ * @param std::string value
+ * @returns std::string
+**/
+
+static std::string quote(const std::string& value) {
+
+  std::string quoted;
+  quoted.reserve(value.length());
+  for (auto& c : value) {
+    quoted += c;
+    if (c == '"') {
+      quoted += c;
+    }
+  }
+  return quoted;
+}
+
+/**
+ * @function Consumer
+ * @description class constructor
+ * @param Mibtable* mibtable records are applied to
+**/
+
+Consumer::Consumer(Mibtable* mibtable) : mibtable(mibtable), header(nullptr), records(nullptr), mappedSize(0), consumerThread(nullptr), stopping(false) {
+}
+
+/**
+ * @function ~Consumer
+ * @description class destructor; stops consumer if running
+**/
+
+Consumer::~Consumer() {
+  stop();
+}
+
+/**
+ * @function start
+ * @description create (or reinitialize) the ring file, map it and start applying records in a thread.
+ * Producers which mapped the file before keep working on the reinitialized ring
+ * @param std::string ring file path
+ * @param std::string& error
+ * @returns bool: true if started
+**/
+
+bool Consumer::start(const std::string& path, std::string& error) {
+
+  size_t size = sizeof(murmure_ingest_header) + DEFAULT_INGEST_CAPACITY * sizeof(murmure_ingest_record);
+  //File is created with the daemon umask: producers need write permission on it
+  int fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd < 0) {
+    error = "Could not open " + path + ": " + strerror(errno);
+    return false;
+  }
+  if (ftruncate(fd, size) != 0) {
+    error = "Could not size " + path + ": " + strerror(errno);
+    close(fd);
+    return false;
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error = "Could not map " + path + ": " + strerror(errno);
+    return false;
+  }
+  header = reinterpret_cast<murmure_ingest_header*>(mapping);
+  records = reinterpret_cast<murmure_ingest_record*>(header + 1);
+  mappedSize = size;
+  //Producers don't push while the ring is initialized
+  __atomic_store_n(&header->magic, 0, __ATOMIC_RELEASE);
+  header->abi_version = MURMURE_INGEST_ABI_VERSION;
+  header->capacity = DEFAULT_INGEST_CAPACITY;
+  header->dropped = 0;
+  header->tail = 0;
+  header->head = 0;
+  for (uint64_t position = 0; position < DEFAULT_INGEST_CAPACITY; position++) {
+    records[position].sequence = position;
+  }
+  __atomic_store_n(&header->magic, MURMURE_INGEST_MAGIC, __ATOMIC_RELEASE);
+  stopping = false;
+  consumerThread = new std::thread(&Consumer::run, this);
+  return true;
+}
+
+/**
+ * @function stop
+ * @description apply the records left in the ring and stop the consumer; producers get MURMURE_INGEST_ERROR
+ * until the ring is started again
+**/
+
+void Consumer::stop() {
+
+  if (consumerThread == nullptr) {
+    return;
+  }
+  stopping = true;
+  consumerThread->join();
+  delete consumerThread;
+  consumerThread = nullptr;
+  __atomic_store_n(&header->magic, 0, __ATOMIC_RELEASE);
+  munmap(header, mappedSize);
+  header = nullptr;
+  records = nullptr;
+}
+
+/**
+ * @function getStats
+ * @description get ingestion counters
+ * @param uint64_t& records read from the ring
+ * @param uint64_t& values written
+ * @param uint64_t& records for unknown OID keys
+ * @param uint64_t& records with invalid values
+ * @param uint64_t& records dropped by producers because the ring was full
+**/
+
+void Consumer::getStats(uint64_t& records, uint64_t& applied, uint64_t& unknown, uint64_t& invalid, uint64_t& dropped) {
+  records = Consumer::recordsRead;
+  applied = Consumer::applied;
+  unknown = Consumer::unknown;
+  invalid = Consumer::invalid;
+  dropped = Consumer::dropped;
+}
+
+/**
+ * @function run
+ * @description consumer thread: apply records in batches until stopped, then apply the remaining ones
+**/
+
+void Consumer::run() {
+
+  std::vector<murmure_ingest_record> batch;
+  batch.reserve(INGEST_BATCH_SIZE);
+  while (!stopping) {
+    if (drain(batch) == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(INGEST_IDLE_SLEEP));
+      continue;
+    }
+    apply(batch);
+  }
+  while (drain(batch) > 0) {
+    apply(batch);
+  }
+}
+
+/**
+ * @function drain
+ * @description move up to INGEST_BATCH_SIZE published records from the ring to batch, releasing their slots
+ * @param std::vector<murmure_ingest_record>& batch; cleared first
+ * @returns size_t: amount of records moved
+**/
+
+size_t Consumer::drain(std::vector<murmure_ingest_record>& batch) {
+
+  batch.clear();
+  uint64_t head = __atomic_load_n(&header->head, __ATOMIC_RELAXED);
+  while (batch.size() < INGEST_BATCH_SIZE) {
+    murmure_ingest_record* record = &records[head & (DEFAULT_INGEST_CAPACITY - 1)];
+    if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != head + 1) {
+      //Not published yet
+      break;
+    }
+    batch.push_back(*record);
+    //Slot is free for the next lap
+    __atomic_store_n(&record->sequence, head + DEFAULT_INGEST_CAPACITY, __ATOMIC_RELEASE);
+    head++;
+  }
+  __atomic_store_n(&header->head, head, __ATOMIC_RELEASE);
+  dropped = __atomic_load_n(&header->dropped, __ATOMIC_RELAXED);
+  recordsRead += batch.size();
+  return batch.size();
+}
+
+/**
+ * @function apply
+ * @description set the values of a batch of records; only the last record of each OID is applied,
+ * and values are written to database in a single write
+ * @param std::vector<murmure_ingest_record>& batch
+**/
+
+void Consumer::apply(std::vector<murmure_ingest_record>& batch) {
+
+  //Key => index of its last record
+  std::unordered_map<uint64_t, size_t> latest;
+  latest.reserve(batch.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    latest[batch[i].key] = i;
+  }
+  std::vector<Oid*> loaded;
+  std::vector<std::string> queries;
+  std::string value;
+  for (size_t i = 0; i < batch.size(); i++) {
+    murmure_ingest_record& record = batch[i];
+    if (latest[record.key] != i) {
+      continue;
+    }
+    Oid* oid = mibtable->getOidByKey(record.key);
+    if (oid == nullptr) {
+      unknown++;
+      if (unknownKeyLog.admit()) {
+        logger::log(COMPONENT, LOG_WARN, "No OID has key " + std::to_string(record.key));
+      }
+      continue;
+    }
+    if (record.type == MURMURE_INGEST_INTEGER) {
+      value = std::to_string(record.value.integer);
+    } else if (record.type == MURMURE_INGEST_STRING && record.length <= MURMURE_INGEST_STRING_MAX) {
+      value.assign(record.value.string, record.length);
+    } else {
+      invalid++;
+      continue;
+    }
+    //Value is validated by loading it; database is written once for the whole batch
+    if (!oid->loadValue(value)) {
+      invalid++;
+      logger::log(COMPONENT, LOG_DEBUG, "Could not set value '" + value + "' for OID " + oid->getOid());
+      continue;
+    }
+    loaded.push_back(oid);
+    queries.push_back("UPDATE oids SET value = \"" + quote(oid->getPrintableValue()) + "\" WHERE oid = \"" + oid->getOid() + "\";");
+  }
+  if (queries.empty()) {
+    return;
+  }
+  std::string dbError;
+  if (database::execBatch(queries, dbError)) {
+    applied += loaded.size();
+    return;
+  }
+  logger::log(COMPONENT, LOG_ERROR, "Could not write ingested values: " + dbError);
+  //Restore the values of the database
+  for (auto& oid : loaded) {
+    oid->reloadValue();
+  }
+}
+
+} // namespace ingest
+}
@@ -0,0 +1,209 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+//mmap/ftruncate are POSIX, not C99
+#define _POSIX_C_SOURCE 200809L
+
+#include <ingest/murmureingest.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct murmure_ingest {
+  murmure_ingest_header* header;
+  murmure_ingest_record* records;
+  uint64_t mask; //capacity - 1
+  size_t size;   //Mapped size
+};
+
+/**
+ * @function murmure_ingest_open
+ * @description map the ring created by the daemon
+ * @param const char* ring path (murmure --ingest)
+ * @returns murmure_ingest*: ring handle; NULL on error (errno is set; EINVAL if the file is not a ring)
+**/
+
+murmure_ingest* murmure_ingest_open(const char* path) {
+
+  int fd = open(path, O_RDWR);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat ringStat;
+  if (fstat(fd, &ringStat) != 0) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = (size_t) ringStat.st_size;
+  if (size < sizeof(murmure_ingest_header)) {
+    close(fd);
+    errno = EINVAL;
+    return NULL;
+  }
+  void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return NULL;
+  }
+  murmure_ingest_header* header = (murmure_ingest_header*) mapping;
+  uint64_t capacity = header->capacity;
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != MURMURE_INGEST_MAGIC || header->abi_version != MURMURE_INGEST_ABI_VERSION || capacity == 0 || (capacity & (capacity - 1)) != 0 || size < sizeof(murmure_ingest_header) + capacity * sizeof(murmure_ingest_record)) {
+    munmap(mapping, size);
+    errno = EINVAL;
+    return NULL;
+  }
+  murmure_ingest* ring = (murmure_ingest*) malloc(sizeof(murmure_ingest));
+  if (ring == NULL) {
+    munmap(mapping, size);
+    return NULL;
+  }
+  ring->header = header;
+  ring->records = (murmure_ingest_record*) (header + 1);
+  ring->mask = capacity - 1;
+  ring->size = size;
+  return ring;
+}
+
+/**
+ * @function murmure_ingest_close
+ * @description unmap the ring; records already pushed are still applied
+ * @param murmure_ingest* ring handle
+**/
+
+void murmure_ingest_close(murmure_ingest* ring) {
+  if (ring != NULL) {
+    munmap(ring->header, ring->size);
+    free(ring);
+  }
+}
+
+/**
+ * @function murmure_ingest_key
+ * @description calculate the key of an OID (64 bit FNV-1a of the OID string, as in the MIB table)
+ * @param const char* OID, with leading dot (e.g. .1.3.6.1.4.1.9999.1)
+ * @returns uint64_t: OID key; compute it once per OID
+**/
+
+uint64_t murmure_ingest_key(const char* oid) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (; *oid != '\0'; oid++) {
+    hash ^= (uint8_t) *oid;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @function reserve
+ * @description reserve a slot for a record
+ * @param murmure_ingest* ring handle
+ * @param uint64_t* reserved position
+ * @returns murmure_ingest_record*: reserved slot; NULL if ring is full or not initialized
+**/
+
+static murmure_ingest_record* reserve(murmure_ingest* ring, uint64_t* position) {
+
+  murmure_ingest_header* header = ring->header;
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != MURMURE_INGEST_MAGIC) {
+    return NULL;
+  }
+  uint64_t tail = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+  for (;;) {
+    murmure_ingest_record* record = &ring->records[tail & ring->mask];
+    int64_t state = (int64_t) (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) - tail);
+    if (state == 0) {
+      //Slot is free for this position; claim it
+      if (__atomic_compare_exchange_n(&header->tail, &tail, tail + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        *position = tail;
+        return record;
+      }
+      //tail has been reloaded by the failed exchange
+    } else if (state < 0) {
+      //Slot still holds the record of the previous lap: ring is full
+      __atomic_fetch_add(&header->dropped, 1, __ATOMIC_RELAXED);
+      return NULL;
+    } else {
+      tail = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/**
+ * @function murmure_ingest_integer
+ * @description push an integer value
+ * @param murmure_ingest* ring handle
+ * @param uint64_t OID key
+ * @param int64_t value
+ * @returns int: MURMURE_INGEST_OK, MURMURE_INGEST_FULL or MURMURE_INGEST_ERROR
+**/
+
+int murmure_ingest_integer(murmure_ingest* ring, uint64_t key, int64_t value) {
+
+  uint64_t position;
+  murmure_ingest_record* record = reserve(ring, &position);
+  if (record == NULL) {
+    return __atomic_load_n(&ring->header->magic, __ATOMIC_ACQUIRE) == MURMURE_INGEST_MAGIC ? MURMURE_INGEST_FULL : MURMURE_INGEST_ERROR;
+  }
+  record->key = key;
+  record->type = MURMURE_INGEST_INTEGER;
+  record->length = 0;
+  record->value.integer = value;
+  //Publish record
+  __atomic_store_n(&record->sequence, position + 1, __ATOMIC_RELEASE);
+  return MURMURE_INGEST_OK;
+}
+
+/**
+ * @function murmure_ingest_string
+ * @description push a string value
+ * @param murmure_ingest* ring handle
+ * @param uint64_t OID key
+ * @param const char* value; at most MURMURE_INGEST_STRING_MAX characters
+ * @returns int: MURMURE_INGEST_OK, MURMURE_INGEST_FULL or MURMURE_INGEST_ERROR
+**/
+
+int murmure_ingest_string(murmure_ingest* ring, uint64_t key, const char* value) {
+
+  size_t length = strlen(value);
+  if (length > MURMURE_INGEST_STRING_MAX) {
+    return MURMURE_INGEST_ERROR;
+  }
+  uint64_t position;
+  murmure_ingest_record* record = reserve(ring, &position);
+  if (record == NULL) {
+    return __atomic_load_n(&ring->header->magic, __ATOMIC_ACQUIRE) == MURMURE_INGEST_MAGIC ? MURMURE_INGEST_FULL : MURMURE_INGEST_ERROR;
+  }
+  record->key = key;
+  record->type = MURMURE_INGEST_STRING;
+  record->length = (uint32_t) length;
+  memcpy(record->value.string, value, length);
+  //Publish record
+  __atomic_store_n(&record->sequence, position + 1, __ATOMIC_RELEASE);
+  return MURMURE_INGEST_OK;
+}
@@ -0,0 +1,300 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <mibscheduler/builtins.hpp>
+#include <mibscheduler/plugins.hpp>
+#include <utils/strutils.hpp>
+
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace murmure {
+namespace builtins {
+
+//Parsed builtin command
+typedef struct {
+  std::string action;
+  std::string oid;      //Target OID; empty for plugins (event OID)
+  std::string argument; //Rest of the command line
+} builtinCommand;
+
+/**
+ * @function replaceVariable
+ * @description replace all the occurrences of a variable in a string
+ * @param std::string& string where to replace
+ * @param std::string variable name
+ * @param std::string variable value
+**/
+
+static void replaceVariable(std::string& str, const std::string& variable, const std::string& value) {
+  size_t varPos = 0;
+  while ((varPos = str.find(variable, varPos)) != std::string::npos) {
+    str.replace(varPos, variable.length(), value);
+    varPos += value.length();
+  }
+}
+
+/**
+ * @function parseCommand
+ * @description split builtin command into action, target oid and argument
+ * @param std::string command
+ * @param builtinCommand& parsed command
+ * @param std::string& error string pointer
+ * @returns bool: true if action is known and has its arguments
+**/
+
+static bool parseCommand(const std::string& command, builtinCommand& parsed, std::string& error) {
+
+  std::string line = strutils::trim(command);
+  size_t actionEnd = line.find(' ');
+  parsed.action = line.substr(0, actionEnd);
+  std::string arguments = actionEnd != std::string::npos ? strutils::trim(line.substr(actionEnd + 1)) : "";
+  //Plugins have the hook reference as only argument
+  if (parsed.action == BUILTIN_PLUGIN) {
+    parsed.argument = arguments;
+    if (parsed.argument.length() == 0) {
+      error = "Missing hook for builtin action " + parsed.action;
+      return false;
+    }
+    return true;
+  }
+  size_t oidEnd = arguments.find(' ');
+  parsed.oid = arguments.substr(0, oidEnd);
+  parsed.argument = oidEnd != std::string::npos ? strutils::trim(arguments.substr(oidEnd + 1)) : "";
+
+  if (parsed.action != BUILTIN_SET && parsed.action != BUILTIN_INCREMENT && parsed.action != BUILTIN_COPYFILE &&
+      parsed.action != BUILTIN_COPYOID && parsed.action != BUILTIN_TIMESTAMP && parsed.action != BUILTIN_PLUGIN) {
+    error = "Unknown builtin action " + parsed.action;
+    return false;
+  }
+  if (parsed.oid.length() == 0) {
+    error = "Missing OID for builtin action " + parsed.action;
+    return false;
+  }
+  bool needsArgument = parsed.action == BUILTIN_SET || parsed.action == BUILTIN_COPYFILE || parsed.action == BUILTIN_COPYOID;
+  if (needsArgument && parsed.argument.length() == 0) {
+    error = "Missing argument for builtin action " + parsed.action;
+    return false;
+  }
+  if (parsed.action == BUILTIN_INCREMENT && parsed.argument.length() > 0) {
+    try {
+      std::stoll(parsed.argument);
+    } catch (std::exception& ex) {
+      error = "Invalid increment amount " + parsed.argument;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @function runPlugin
+ * @description call a plugin hook; if the hook returns a new value it's set to the event OID
+ * @param Mibtable* mibtable
+ * @param std::string hook reference
+ * @param std::string OID which triggered the event
+ * @param EventMode mode of the event
+ * @param std::string value which triggered the event
+ * @param std::string& error string pointer
+ * @returns bool: true if the hook succeeded
+**/
+
+static bool runPlugin(Mibtable* mibtable, const std::string& reference, const std::string& eventOid, EventMode mode, const std::string& value, std::string& error) {
+
+  murmure_hook hook;
+  if (!plugins::getHook(reference, hook, error)) {
+    return false;
+  }
+  char newValue[MURMURE_VALUE_MAX_LENGTH] = {0};
+  murmure_event event;
+  event.abi_version = MURMURE_PLUGIN_ABI_VERSION;
+  event.oid = eventOid.c_str();
+  if (mode == EventMode::GET) {
+    event.mode = MURMURE_EVENT_GET;
+  } else if (mode == EventMode::SET) {
+    event.mode = MURMURE_EVENT_SET;
+  } else if (mode == EventMode::AUTO) {
+    event.mode = MURMURE_EVENT_AUTO;
+  } else {
+    event.mode = MURMURE_EVENT_INIT;
+  }
+  event.value = value.c_str();
+  event.new_value = newValue;
+  event.new_value_size = sizeof(newValue);
+  int result = hook(&event);
+  if (result == MURMURE_HOOK_OK) {
+    return true;
+  } else if (result != MURMURE_HOOK_SETVALUE) {
+    error = "Hook " + reference + " returned " + std::to_string(result);
+    return false;
+  }
+  //Set value returned by hook
+  newValue[sizeof(newValue) - 1] = 0x00;
+  Oid* target = mibtable->getOidByOid(eventOid);
+  if (target == nullptr) {
+    error = "Could not find OID " + eventOid;
+    return false;
+  }
+  try {
+    if (!target->setValue(newValue)) {
+      error = "Could not set value for OID " + eventOid;
+      return false;
+    }
+  } catch (std::exception& ex) {
+    error = "Invalid value '" + std::string(newValue) + "' for OID " + eventOid;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function isBuiltin
+ * @description returns whether the command is a builtin action
+ * @param std::string command
+ * @returns bool
+**/
+
+bool isBuiltin(const std::string& command) {
+  return command.length() > 0 && command.at(0) == BUILTIN_PREFIX;
+}
+
+/**
+ * @function check
+ * @description check builtin command syntax and OIDs
+ * @param Mibtable* mibtable
+ * @param std::string command
+ * @param std::string& error string pointer
+ * @returns bool: true if command is valid
+**/
+
+bool check(Mibtable* mibtable, const std::string& command, std::string& error) {
+
+  builtinCommand parsed;
+  if (!parseCommand(command, parsed, error)) {
+    return false;
+  }
+  if (parsed.action == BUILTIN_PLUGIN) {
+    murmure_hook hook;
+    return plugins::getHook(parsed.argument, hook, error);
+  }
+  //OID variable is resolved at execution
+  if (parsed.oid != BUILTIN_OID_VARIABLE && mibtable->getOidByOid(parsed.oid) == nullptr) {
+    error = "Could not find OID " + parsed.oid;
+    return false;
+  }
+  if (parsed.action == BUILTIN_COPYOID && parsed.argument != BUILTIN_OID_VARIABLE && mibtable->getOidByOid(parsed.argument) == nullptr) {
+    error = "Could not find OID " + parsed.argument;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function run
+ * @description execute builtin command
+ * @param Mibtable* mibtable
+ * @param std::string command
+ * @param std::string OID which triggered the event; replaces $SNMP_OID
+ * @param EventMode mode of the event
+ * @param std::string value which triggered the event; replaces $SNMP_VALUE in @set value
+ * @param std::string& error string pointer
+ * @returns bool: true if the action succeeded
+**/
+
+bool run(Mibtable* mibtable, const std::string& command, const std::string& eventOid, EventMode mode, const std::string& value, std::string& error) {
+
+  builtinCommand parsed;
+  std::string resolvedCommand = command;
+  replaceVariable(resolvedCommand, BUILTIN_OID_VARIABLE, eventOid);
+  if (!parseCommand(resolvedCommand, parsed, error)) {
+    return false;
+  }
+  if (parsed.action == BUILTIN_PLUGIN) {
+    return runPlugin(mibtable, parsed.argument, eventOid, mode, value, error);
+  }
+  Oid* target = mibtable->getOidByOid(parsed.oid);
+  if (target == nullptr) {
+    error = "Could not find OID " + parsed.oid;
+    return false;
+  }
+
+  //Get new value
+  std::string newValue;
+  if (parsed.action == BUILTIN_SET) {
+    newValue = parsed.argument;
+    replaceVariable(newValue, BUILTIN_VALUE_VARIABLE, value);
+  } else if (parsed.action == BUILTIN_INCREMENT) {
+    try {
+      long long amount = parsed.argument.length() > 0 ? std::stoll(parsed.argument) : 1;
+      long long current = std::stoll(target->getPrintableValue());
+      //Counters wrap around
+      if (target->getPrimitiveType() == PRIMITIVE_COUNTER) {
+        newValue = std::to_string(static_cast<unsigned int>(current + amount));
+      } else {
+        newValue = std::to_string(current + amount);
+      }
+    } catch (std::exception& ex) {
+      error = "Value of OID " + parsed.oid + " is not a number";
+      return false;
+    }
+  } else if (parsed.action == BUILTIN_COPYFILE) {
+    std::ifstream fileStream(parsed.argument);
+    if (!fileStream.is_open()) {
+      error = "Could not open file " + parsed.argument;
+      return false;
+    }
+    std::stringstream contentStream;
+    contentStream << fileStream.rdbuf();
+    newValue = contentStream.str();
+    //Strip trailing newlines
+    while (newValue.length() > 0 && (newValue.back() == '\n' || newValue.back() == '\r')) {
+      newValue.pop_back();
+    }
+  } else if (parsed.action == BUILTIN_COPYOID) {
+    Oid* source = mibtable->getOidByOid(parsed.argument);
+    if (source == nullptr) {
+      error = "Could not find OID " + parsed.argument;
+      return false;
+    }
+    newValue = source->getPrintableValue();
+  } else if (parsed.action == BUILTIN_TIMESTAMP) {
+    newValue = std::to_string(time(nullptr));
+  }
+
+  //Set value (in memory and in database)
+  try {
+    if (!target->setValue(newValue)) {
+      error = "Could not set value for OID " + parsed.oid;
+      return false;
+    }
+  } catch (std::exception& ex) {
+    error = "Invalid value '" + newValue + "' for OID " + parsed.oid;
+    return false;
+  }
+  return true;
+}
+
+} // namespace builtins
+}
@@ -0,0 +1,137 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <mibscheduler/clock.hpp>
+
+namespace murmure {
+
+/**
+ * @function SystemClock
+ * @description SystemClock class constructor
+**/
+
+SystemClock::SystemClock() : interrupted(false) {
+}
+
+/**
+ * @function now
+ * @description returns current monotonic time
+ * @returns time_point
+**/
+
+std::chrono::steady_clock::time_point SystemClock::now() {
+  return std::chrono::steady_clock::now();
+}
+
+/**
+ * @function wallTime
+ * @description returns current calendar time (used by cron schedules)
+ * @returns time_t
+**/
+
+time_t SystemClock::wallTime() {
+  return time(nullptr);
+}
+
+/**
+ * @function sleepUntil
+ * @description block the calling thread until the provided time, or until the clock is interrupted
+ * @param time_point when
+**/
+
+void SystemClock::sleepUntil(std::chrono::steady_clock::time_point when) {
+  std::unique_lock<std::mutex> lock(sleepMutex);
+  sleepCondition.wait_until(lock, when, [this]() { return interrupted; });
+}
+
+/**
+ * @function interrupt
+ * @description wake up sleeping threads and make further sleeps return immediately, so that a stopping
+ * scheduler thread can be joined at once; clear to sleep again
+ * @param bool interrupted
+**/
+
+void SystemClock::interrupt(bool interrupted) {
+  std::lock_guard<std::mutex> lock(sleepMutex);
+  this->interrupted = interrupted;
+  sleepCondition.notify_all();
+}
+
+/**
+ * @function VirtualClock
+ * @description VirtualClock class constructor; the clock starts at current time
+**/
+
+VirtualClock::VirtualClock() {
+  origin = std::chrono::steady_clock::now();
+  wallOrigin = time(nullptr);
+  current = origin;
+}
+
+/**
+ * @function now
+ * @description returns simulated monotonic time
+ * @returns time_point
+**/
+
+std::chrono::steady_clock::time_point VirtualClock::now() {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  return current;
+}
+
+/**
+ * @function wallTime
+ * @description returns simulated calendar time
+ * @returns time_t
+**/
+
+time_t VirtualClock::wallTime() {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  return wallOrigin + std::chrono::duration_cast<std::chrono::seconds>(current - origin).count();
+}
+
+/**
+ * @function sleepUntil
+ * @description fast-forward the clock to the provided time; returns immediately
+ * @param time_point when
+**/
+
+void VirtualClock::sleepUntil(std::chrono::steady_clock::time_point when) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  if (when > current) {
+    current = when;
+  }
+}
+
+/**
+ * @function advance
+ * @description move the clock forward (e.g. to simulate the duration of an execution)
+ * @param duration amount
+**/
+
+void VirtualClock::advance(std::chrono::steady_clock::duration amount) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  current += amount;
+}
+
+}
@@ -0,0 +1,225 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <mibscheduler/cronschedule.hpp>
+#include <utils/strutils.hpp>
+
+#include <stdexcept>
+
+//Upper bound of date fields to visit looking for next match (covers impossible dates, e.g. 30 feb)
+#define CRON_MAX_ITERATIONS 100000
+
+namespace murmure {
+
+/**
+ * @function parseNumber
+ * @description parse a cron field number
+ * @param std::string value
+ * @param int& parsed value
+ * @returns bool: true if value is a number
+**/
+
+static bool parseNumber(const std::string& value, int& number) {
+  try {
+    size_t parsedChars = 0;
+    number = std::stoi(value, &parsedChars);
+    return parsedChars == value.length();
+  } catch (std::exception& ex) {
+    return false;
+  }
+}
+
+/**
+ * @function CronSchedule
+ * @description CronSchedule class constructor; the schedule is unset until parsed
+**/
+
+CronSchedule::CronSchedule() {
+  this->domRestricted = false;
+  this->dowRestricted = false;
+  this->set = false;
+}
+
+/**
+ * @function parse
+ * @description parse a cron expression (minute hour day-of-month month day-of-week)
+ * @param std::string expression; fields support '*', numbers, ranges (a-b), lists (a,b) and steps (/n)
+ * @param std::string& error string pointer
+ * @returns bool: true if expression is valid
+ * NOTE: day of week 0 and 7 are both sunday
+**/
+
+bool CronSchedule::parse(const std::string& expression, std::string& error) {
+
+  std::vector<std::string> fields;
+  for (auto& field : strutils::split(expression, ' ')) {
+    if (field.length() > 0) {
+      fields.push_back(field);
+    }
+  }
+  if (fields.size() != 5) {
+    error = "Cron expression '" + expression + "' must have 5 fields";
+    return false;
+  }
+  bool restricted;
+  if (!parseField(fields.at(0), 0, 59, minutes, restricted) || !parseField(fields.at(1), 0, 23, hours, restricted) ||
+      !parseField(fields.at(2), 1, 31, daysOfMonth, domRestricted) || !parseField(fields.at(3), 1, 12, months, restricted) ||
+      !parseField(fields.at(4), 0, 7, daysOfWeek, dowRestricted)) {
+    error = "Invalid cron expression '" + expression + "'";
+    return false;
+  }
+  //Sunday is both 0 and 7
+  if (daysOfWeek.at(7)) {
+    daysOfWeek.at(0) = true;
+  }
+  set = true;
+  return true;
+}
+
+/**
+ * @function isSet
+ * @description returns whether a cron expression has been parsed
+ * @returns bool
+**/
+
+bool CronSchedule::isSet() {
+  return this->set;
+}
+
+/**
+ * @function next
+ * @description get the next time matching the schedule (local time)
+ * @param time_t time after which the next match is searched
+ * @returns time_t: next match (minute precision); -1 if the schedule never matches
+**/
+
+time_t CronSchedule::next(time_t after) {
+
+  if (!set) {
+    return -1;
+  }
+  struct tm date;
+  localtime_r(&after, &date);
+  //Start from next minute
+  date.tm_sec = 0;
+  date.tm_min++;
+  date.tm_isdst = -1;
+  mktime(&date);
+  for (int iteration = 0; iteration < CRON_MAX_ITERATIONS; iteration++) {
+    if (!months.at(date.tm_mon + 1)) {
+      date.tm_mon++;
+      date.tm_mday = 1;
+      date.tm_hour = 0;
+      date.tm_min = 0;
+    } else if (!matchesDay(date)) {
+      date.tm_mday++;
+      date.tm_hour = 0;
+      date.tm_min = 0;
+    } else if (!hours.at(date.tm_hour)) {
+      date.tm_hour++;
+      date.tm_min = 0;
+    } else if (!minutes.at(date.tm_min)) {
+      date.tm_min++;
+    } else {
+      return mktime(&date);
+    }
+    //Normalize date
+    date.tm_isdst = -1;
+    mktime(&date);
+  }
+  return -1;
+}
+
+/**
+ * @function matchesDay
+ * @description check day of month and day of week; if both are restricted either of them has to match, otherwise both
+ * (e.g. day of month '*' with step 2 and day of week 1 match mondays with an odd day of month)
+ * @param struct tm date
+ * @returns bool
+**/
+
+bool CronSchedule::matchesDay(const struct tm& date) {
+
+  bool domMatch = daysOfMonth.at(date.tm_mday);
+  bool dowMatch = daysOfWeek.at(date.tm_wday);
+  if (domRestricted && dowRestricted) {
+    return domMatch || dowMatch;
+  }
+  return domMatch && dowMatch;
+}
+
+/**
+ * @function parseField
+ * @description parse a cron field
+ * @param std::string field
+ * @param int minimum allowed value
+ * @param int maximum allowed value
+ * @param std::vector<bool>& values; values[n] is true if n matches
+ * @param bool& restricted; false if field starts with '*', steps included, as cron does for day of month and day of week
+ * @returns bool: true if field is valid
+ * NOTE: this function is @!static
+**/
+
+bool CronSchedule::parseField(const std::string& field, int minValue, int maxValue, std::vector<bool>& values, bool& restricted) {
+
+  values.assign(maxValue + 1, false);
+  restricted = field.at(0) != '*';
+  for (auto& item : strutils::split(field, ',')) {
+    //Get step
+    int step = 1;
+    std::string range = item;
+    size_t slashPos = item.find('/');
+    if (slashPos != std::string::npos) {
+      range = item.substr(0, slashPos);
+      if (!parseNumber(item.substr(slashPos + 1), step) || step <= 0) {
+        return false;
+      }
+    }
+    //Get range
+    int first, last;
+    size_t dashPos = range.find('-');
+    if (range == "*") {
+      first = minValue;
+      last = maxValue;
+    } else if (dashPos != std::string::npos) {
+      if (!parseNumber(range.substr(0, dashPos), first) || !parseNumber(range.substr(dashPos + 1), last)) {
+        return false;
+      }
+    } else {
+      if (!parseNumber(range, first)) {
+        return false;
+      }
+      //'n/step' means from n to max
+      last = slashPos != std::string::npos ? maxValue : first;
+    }
+    if (first < minValue || last > maxValue || first > last) {
+      return false;
+    }
+    for (int value = first; value <= last; value += step) {
+      values.at(value) = true;
+    }
+  }
+  return true;
+}
+
+}
@@ -21,10 +21,61 @@
  * SOFTWARE.
 **/
 
+#include <mibscheduler/builtins.hpp>
 #include <mibscheduler/event.hpp>
+#include <utils/logger.hpp>
+#include <utils/process.hpp>
+#include <utils/strutils.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#define COMPONENT "Event"
 
 namespace murmure {
 
+std::chrono::milliseconds Event::defaultExecTimeout(DEFAULT_EXEC_TIMEOUT);
+Mibtable* Event::mibtable = nullptr;
+std::atomic<uint64_t> Event::requestFailures(0);
+
+/**
+ * @function parseNumberOption
+ * @description parse a not negative integer option value
+ * @param std::string value
+ * @param int& parsed value
+ * @returns bool: true if value is valid
+**/
+
+static bool parseNumberOption(const std::string& value, int& number) {
+  try {
+    size_t parsedChars = 0;
+    number = std::stoi(value, &parsedChars);
+    return parsedChars == value.length() && number >= 0;
+  } catch (std::exception& ex) {
+    return false;
+  }
+}
+
+/**
+ * @function parseBoolOption
+ * @description parse a boolean option value (0/1)
+ * @param std::string value
+ * @param bool& parsed value
+ * @returns bool: true if value is valid
+**/
+
+static bool parseBoolOption(const std::string& value, bool& flag) {
+  if (value == "1") {
+    flag = true;
+  } else if (value == "0") {
+    flag = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 /**
  * @function Event
  * @description Event class constructor
@@ -35,29 +86,152 @@ namespace murmure {
 
 Event::Event(const std::string& oid, EventMode evMode, const std::vector<std::string>& commandList) {
 
+  this->eventId = 0;
   this->oid = oid;
   this->mode = evMode;
   this->commandList = commandList;
+  this->subtree = false;
+  //Debounce is disabled by default
+  this->minInterval = std::chrono::milliseconds(0);
+  this->trailing = true;
+  this->coalesce = false;
+  //Values are always refreshed by default
+  this->freshness = false;
+  this->maxAge = std::chrono::milliseconds(0);
+  this->grace = std::chrono::milliseconds(0);
+  this->deadline = std::chrono::milliseconds(DEFAULT_REFRESH_DEADLINE);
+  //Scheduled events run on timeout boundaries by default
+  this->phase = 0;
+  this->jitter = 0;
+  //Scheduled events run whether their OID is read or not by default
+  this->idle = 0;
+  this->idleMode = IdleMode::SUSPEND;
+  //Commands are executed for each event by default
+  this->share = false;
+  //Global timeout is used by default
+  this->execTimeout = std::chrono::milliseconds(0);
+  this->killGrace = std::chrono::milliseconds(DEFAULT_KILL_GRACE);
+  this->hasRun = false;
+  this->inFlight = 0;
+  this->rerunPending = false;
+  this->deferredPending = false;
+  this->pins = 0;
 }
 
 /**
  * @function executeCommands
- * @description execute commands associated to this event
+ * @description execute commands associated to this event, recording execution metrics
+ * @param std::string value which triggered the event; exported as SNMP_VALUE for SET events
+ * @param std::string OID which triggered the event (for subtree events); exported as SNMP_OID; event OID if empty
+ * @param CommandResults* results of commands already executed by other events, reused if the event shares results; nullptr to always execute
  * @returns int: amount of executed commands
+ * NOTE: when the execution timeout expires, the running command is killed and the remaining ones are skipped.
+ * Builtin actions (@action) are executed in-process and never shared, as commands using SNMP variables
 **/
 
-int Event::executeCommands() {
+int Event::executeCommands(const std::string& value /* = "" */, const std::string& triggerOid /* = "" */, CommandResults* sharedResults /* = nullptr */) {
 
   int commandAmount = 0;
+  bool failed = false;
+  bool timedOut = false;
+  bool coalesced = false;
+
+  const std::string& concreteOid = triggerOid.length() > 0 ? triggerOid : oid;
+  std::vector<std::string> environment;
+  environment.push_back("SNMP_OID=" + concreteOid);
+  if (mode == EventMode::SET) {
+    environment.push_back("SNMP_VALUE=" + value);
+  }
+  std::chrono::milliseconds timeout = execTimeout.count() > 0 ? execTimeout : defaultExecTimeout;
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  //Request path has priority over background work; requests are served earliest deadline first
+  process::ExecClass execClass = (mode == EventMode::GET || mode == EventMode::SET) ? process::ExecClass::REQUEST : process::ExecClass::BACKGROUND;
+  std::chrono::steady_clock::time_point deadline = timeout.count() > 0 ? startTime + timeout : std::chrono::steady_clock::time_point::max();
 
   for (auto& command : commandList) {
-    system(command.c_str());
+    //Commands share the event timeout
+    int remaining = 0;
+    if (timeout.count() > 0) {
+      remaining = std::chrono::duration_cast<std::chrono::milliseconds>(startTime + timeout - std::chrono::steady_clock::now()).count();
+      if (remaining <= 0) {
+        timedOut = true;
+        break;
+      }
+    }
+    std::string errorString;
+    if (builtins::isBuiltin(command)) {
+      if (mibtable == nullptr || !builtins::run(mibtable, command, concreteOid, mode, value, errorString)) {
+        logger::log(COMPONENT, LOG_ERROR, "Builtin '" + command + "' for OID " + oid + " failed: " + errorString);
+        failed = true;
+      }
+      commandAmount++;
+      continue;
+    }
+    process::execResult result;
+    //Commands get the OID in their environment, so only events declaring it can share results
+    bool shareable = sharedResults != nullptr && share;
+    CommandResults::iterator sharedResult;
+    if (shareable && (sharedResult = sharedResults->find(command)) != sharedResults->end()) {
+      //Same command has just been executed for another event
+      result = sharedResult->second;
+      coalesced = true;
+    } else if (!process::run(command, environment, remaining, killGrace.count(), result, errorString, execClass, deadline)) {
+      logger::log(COMPONENT, LOG_ERROR, errorString);
+      failed = true;
+      continue;
+    } else if (shareable) {
+      (*sharedResults)[command] = result;
+    }
     commandAmount++;
+    if (result.timedOut) {
+      logger::log(COMPONENT, LOG_WARN, "Execution timeout expired for event of OID " + oid + "; killed '" + command + "'");
+      timedOut = true;
+      break;
+    }
+    if (result.exitCode != 0) {
+      std::stringstream logS;
+      logS << "Command '" << command << "' for OID " << oid << " failed (exit code " << result.exitCode << ")";
+      std::string output = result.output;
+      while (output.length() > 0 && output.back() == '\n') {
+        output.pop_back();
+      }
+      if (output.length() > 0) {
+        logS << ": " << output;
+      }
+      logger::log(COMPONENT, LOG_DEBUG, logS.str());
+      failed = true;
+    }
   }
 
+  std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+  if ((failed || timedOut) && execClass == process::ExecClass::REQUEST) {
+    requestFailures++;
+  }
+  std::lock_guard<std::mutex> lock(metricsMutex);
+  metrics.record(duration, failed, timedOut, coalesced);
   return commandAmount;
 }
 
+/**
+ * @function getId
+ * @description get event id (as stored into database)
+ * @returns int: 0 if event hasn't been saved yet
+**/
+
+int Event::getId() {
+  return this->eventId;
+}
+
+/**
+ * @function setId
+ * @description set event id (as stored into database)
+ * @param int
+**/
+
+void Event::setId(int eventId) {
+  this->eventId = eventId;
+}
+
 /**
  * @function getOid
  * @description get oid private attribute
@@ -109,4 +283,363 @@ std::vector<std::string> Event::getCommandList() {
   return this->commandList;
 }
 
+/**
+ * @function getOptions
+ * @description get event options
+ * @returns EventOptions
+**/
+
+EventOptions Event::getOptions() {
+  return this->options;
+}
+
+/**
+ * @function setOption
+ * @description validate and apply an event option
+ * @param std::string option name
+ * @param std::string option value
+ * @param std::string& error string pointer
+ * @returns bool: true if option is valid
+**/
+
+bool Event::setOption(const std::string& name, const std::string& value, std::string& error) {
+
+  if (name == EVENTOPTION_DEBOUNCE) {
+    int interval;
+    if (!parseNumberOption(value, interval)) {
+      error = "Invalid debounce interval " + value;
+      return false;
+    }
+    minInterval = std::chrono::milliseconds(interval);
+  } else if (name == EVENTOPTION_TRAILING) {
+    if (!parseBoolOption(value, trailing)) {
+      error = "Invalid trailing value " + value;
+      return false;
+    }
+  } else if (name == EVENTOPTION_COALESCE) {
+    if (!parseBoolOption(value, coalesce)) {
+      error = "Invalid coalesce value " + value;
+      return false;
+    }
+  } else if (name == EVENTOPTION_SUBTREE) {
+    if (mode != EventMode::GET && mode != EventMode::SET) {
+      error = "Option " + name + " is allowed for GET and SET events only";
+      return false;
+    }
+    if (!parseBoolOption(value, subtree)) {
+      error = "Invalid subtree value " + value;
+      return false;
+    }
+  } else if (name == EVENTOPTION_AFTER) {
+    if (mode != EventMode::INIT) {
+      error = "Option " + name + " is allowed for INIT events only";
+      return false;
+    }
+    std::vector<std::string> afterOids = strutils::split(value, ',');
+    for (auto& afterOid : afterOids) {
+      if (afterOid.length() == 0 || afterOid == oid) {
+        error = "Invalid after value " + value;
+        return false;
+      }
+    }
+    after = afterOids;
+  } else if (name == EVENTOPTION_MAXAGE || name == EVENTOPTION_GRACE || name == EVENTOPTION_DEADLINE) {
+    int interval;
+    if (mode != EventMode::GET) {
+      error = "Option " + name + " is allowed for GET events only";
+      return false;
+    }
+    if (!parseNumberOption(value, interval)) {
+      error = "Invalid " + name + " value " + value;
+      return false;
+    }
+    if (name == EVENTOPTION_MAXAGE) {
+      freshness = true;
+      maxAge = std::chrono::milliseconds(interval);
+    } else if (name == EVENTOPTION_GRACE) {
+      grace = std::chrono::milliseconds(interval);
+    } else {
+      deadline = std::chrono::milliseconds(interval);
+    }
+  } else if (name == EVENTOPTION_PHASE || name == EVENTOPTION_JITTER || name == EVENTOPTION_CRON) {
+    if (mode != EventMode::AUTO) {
+      error = "Option " + name + " is allowed for AUTO events only";
+      return false;
+    }
+    if (name == EVENTOPTION_CRON) {
+      if (!cron.parse(value, error)) {
+        return false;
+      }
+    } else if (!parseNumberOption(value, name == EVENTOPTION_PHASE ? phase : jitter)) {
+      error = "Invalid " + name + " value " + value;
+      return false;
+    }
+  } else if (name == EVENTOPTION_IDLE || name == EVENTOPTION_IDLEMODE) {
+    if (mode != EventMode::AUTO) {
+      error = "Option " + name + " is allowed for AUTO events only";
+      return false;
+    }
+    if (name == EVENTOPTION_IDLE) {
+      if (!parseNumberOption(value, idle)) {
+        error = "Invalid idle value " + value;
+        return false;
+      }
+    } else if (value == IDLEMODE_SUSPEND) {
+      idleMode = IdleMode::SUSPEND;
+    } else if (value == IDLEMODE_STRETCH) {
+      idleMode = IdleMode::STRETCH;
+    } else {
+      error = "Invalid idlemode value " + value + " (expected " + IDLEMODE_SUSPEND + " or " + IDLEMODE_STRETCH + ")";
+      return false;
+    }
+  } else if (name == EVENTOPTION_SHARE) {
+    if (mode != EventMode::AUTO) {
+      error = "Option " + name + " is allowed for AUTO events only";
+      return false;
+    }
+    if (!parseBoolOption(value, share)) {
+      error = "Invalid share value " + value;
+      return false;
+    }
+  } else if (name == EVENTOPTION_EXECTIMEOUT || name == EVENTOPTION_KILLGRACE) {
+    int interval;
+    if (!parseNumberOption(value, interval)) {
+      error = "Invalid " + name + " value " + value;
+      return false;
+    }
+    if (name == EVENTOPTION_EXECTIMEOUT) {
+      execTimeout = std::chrono::milliseconds(interval);
+    } else {
+      killGrace = std::chrono::milliseconds(interval);
+    }
+  } else {
+    error = "Unknown option " + name;
+    return false;
+  }
+  options[name] = value;
+  return true;
+}
+
+/**
+ * @function trigger
+ * @description pass a trigger through the event debounce
+ * @param std::string value which triggered the event
+ * @param std::string OID which triggered the event
+ * @param time_point trigger time
+ * @param time_point& when to execute the event if DEFER is returned
+ * @returns TriggerResult
+ * NOTE: if RUN is returned, complete() must be called once the execution has terminated
+**/
+
+TriggerResult Event::trigger(const std::string& value, const std::string& triggerOid, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& deferUntil) {
+
+  std::lock_guard<std::mutex> lock(stateMutex);
+  //Already running: queue a single rerun with the latest value
+  if (coalesce && inFlight > 0) {
+    rerunPending = true;
+    pendingValue = value;
+    pendingOid = triggerOid;
+    return TriggerResult::SUPPRESS;
+  }
+  //Inside debounce interval
+  if (hasRun && now - lastRun < minInterval) {
+    if (!trailing) {
+      return TriggerResult::SUPPRESS;
+    }
+    pendingValue = value;
+    pendingOid = triggerOid;
+    if (deferredPending) {
+      return TriggerResult::SUPPRESS;
+    }
+    deferredPending = true;
+    deferUntil = lastRun + minInterval;
+    return TriggerResult::DEFER;
+  }
+  lastRun = now;
+  hasRun = true;
+  inFlight++;
+  return TriggerResult::RUN;
+}
+
+/**
+ * @function complete
+ * @description notify the end of an execution
+ * @param time_point completion time
+ * @param time_point& when to execute the queued rerun if true is returned
+ * @returns bool: true if a rerun has to be deferred
+**/
+
+bool Event::complete(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& deferUntil) {
+
+  std::lock_guard<std::mutex> lock(stateMutex);
+  inFlight--;
+  if (!rerunPending || inFlight > 0) {
+    return false;
+  }
+  rerunPending = false;
+  //A deferred execution is already queued; it'll take the pending value
+  if (deferredPending) {
+    return false;
+  }
+  deferredPending = true;
+  deferUntil = std::max(now, lastRun + minInterval);
+  return true;
+}
+
+/**
+ * @function takePendingValue
+ * @description take the value of the last suppressed trigger when the deferred execution is due
+ * @param std::string& OID of the last suppressed trigger
+ * @returns std::string
+**/
+
+std::string Event::takePendingValue(std::string& triggerOid) {
+
+  std::lock_guard<std::mutex> lock(stateMutex);
+  deferredPending = false;
+  triggerOid = pendingOid;
+  return pendingValue;
+}
+
+/**
+ * @function isSubtree
+ * @description returns whether the event is bound to its OID subtree
+ * @returns bool
+**/
+
+bool Event::isSubtree() {
+  return this->subtree;
+}
+
+/**
+ * @function getAfter
+ * @description returns the OIDs whose INIT events must complete before this event is executed
+ * @returns std::vector<std::string>
+**/
+
+std::vector<std::string> Event::getAfter() {
+  return this->after;
+}
+
+/**
+ * @function pin
+ * @description mark the event as used, so that it's not freed while retired by a reload
+**/
+
+void Event::pin() {
+
+  std::lock_guard<std::mutex> lock(stateMutex);
+  pins++;
+}
+
+/**
+ * @function unpin
+ * @description release an event previously pinned
+**/
+
+void Event::unpin() {
+
+  std::lock_guard<std::mutex> lock(stateMutex);
+  pins--;
+}
+
+/**
+ * @function isBusy
+ * @description returns whether the event is pinned, running or has a deferred execution queued
+ * @returns bool: false if the event can be freed
+**/
+
+bool Event::isBusy() {
+
+  std::lock_guard<std::mutex> lock(stateMutex);
+  return pins > 0 || inFlight > 0 || deferredPending;
+}
+
+/**
+ * @function hasFreshness
+ * @description returns whether a freshness policy (maxage) is set for this event
+ * @returns bool
+**/
+
+bool Event::hasFreshness() {
+  return this->freshness;
+}
+
+/**
+ * @function getMaxAge
+ * @description returns age under which the OID value is served without refresh
+ * @returns std::chrono::milliseconds
+**/
+
+std::chrono::milliseconds Event::getMaxAge() {
+  return this->maxAge;
+}
+
+/**
+ * @function getGrace
+ * @description returns time after maxage in which the stale value is served while refreshed
+ * @returns std::chrono::milliseconds
+**/
+
+std::chrono::milliseconds Event::getGrace() {
+  return this->grace;
+}
+
+/**
+ * @function getDeadline
+ * @description returns maximum time a request waits for refresh
+ * @returns std::chrono::milliseconds
+**/
+
+std::chrono::milliseconds Event::getDeadline() {
+  return this->deadline;
+}
+
+/**
+ * @function takeMetrics
+ * @description returns metrics recorded since last call and resets them
+ * @returns EventMetrics
+**/
+
+EventMetrics Event::takeMetrics() {
+
+  std::lock_guard<std::mutex> lock(metricsMutex);
+  EventMetrics recorded = metrics;
+  metrics.reset();
+  return recorded;
+}
+
+/**
+ * @function setDefaultExecTimeout
+ * @description set the execution timeout for events which don't set their own
+ * @param int timeout in milliseconds; 0 means no timeout
+ * NOTE: this function is @!static
+**/
+
+void Event::setDefaultExecTimeout(int timeout) {
+  defaultExecTimeout = std::chrono::milliseconds(timeout);
+}
+
+/**
+ * @function setMibtable
+ * @description set the MIB table builtin actions are executed against
+ * @param Mibtable*
+ * NOTE: this function is @!static
+**/
+
+void Event::setMibtable(Mibtable* mTable) {
+  mibtable = mTable;
+}
+
+/**
+ * @function getRequestFailures
+ * @description get the amount of failed (or timed out) executions of GET and SET events
+ * @returns uint64_t
+ * NOTE: this function is @!static
+**/
+
+uint64_t Event::getRequestFailures() {
+  return requestFailures;
+}
+
 }
@@ -0,0 +1,154 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <mibscheduler/eventmetrics.hpp>
+#include <utils/strutils.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace murmure {
+
+/**
+ * @function EventMetrics
+ * @description EventMetrics class constructor
+**/
+
+EventMetrics::EventMetrics() {
+  reset();
+}
+
+/**
+ * @function record
+ * @description record an event execution
+ * @param std::chrono::milliseconds execution duration
+ * @param bool true if a command failed
+ * @param bool true if execution has been killed because of timeout
+ * @param bool true if command results have been shared with other events
+**/
+
+void EventMetrics::record(std::chrono::milliseconds duration, bool failed, bool timedOut, bool coalesced /* = false */) {
+
+  static const uint64_t bounds[] = METRICS_HISTOGRAM_BOUNDS;
+  uint64_t durationMs = duration.count();
+  runs++;
+  if (failed) {
+    failures++;
+  }
+  if (timedOut) {
+    timeouts++;
+  }
+  if (coalesced) {
+    this->coalesced++;
+  }
+  lastDuration = durationMs;
+  totalDuration += durationMs;
+  maxDuration = std::max(maxDuration, durationMs);
+  size_t bucket = 0;
+  while (bucket < METRICS_HISTOGRAM_BUCKETS - 1 && durationMs >= bounds[bucket]) {
+    bucket++;
+  }
+  histogram[bucket]++;
+}
+
+/**
+ * @function merge
+ * @description add metrics recorded later to these
+ * @param EventMetrics metrics to add
+**/
+
+void EventMetrics::merge(const EventMetrics& metrics) {
+
+  runs += metrics.runs;
+  failures += metrics.failures;
+  timeouts += metrics.timeouts;
+  coalesced += metrics.coalesced;
+  if (metrics.runs > 0) {
+    lastDuration = metrics.lastDuration;
+  }
+  totalDuration += metrics.totalDuration;
+  maxDuration = std::max(maxDuration, metrics.maxDuration);
+  for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++) {
+    histogram[bucket] += metrics.histogram[bucket];
+  }
+}
+
+/**
+ * @function reset
+ * @description reset all counters
+**/
+
+void EventMetrics::reset() {
+  runs = 0;
+  failures = 0;
+  timeouts = 0;
+  coalesced = 0;
+  lastDuration = 0;
+  totalDuration = 0;
+  maxDuration = 0;
+  std::fill(histogram, histogram + METRICS_HISTOGRAM_BUCKETS, 0);
+}
+
+/**
+ * @function getHistogram
+ * @description returns histogram as string (bucket counters separated by '/')
+ * @returns std::string
+**/
+
+std::string EventMetrics::getHistogram() const {
+
+  std::stringstream histStream;
+  for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++) {
+    if (bucket > 0) {
+      histStream << "/";
+    }
+    histStream << histogram[bucket];
+  }
+  return histStream.str();
+}
+
+/**
+ * @function setHistogram
+ * @description parse histogram string, as returned by getHistogram
+ * @param std::string histogram
+ * @returns bool: true if histogram is valid
+**/
+
+bool EventMetrics::setHistogram(const std::string& histogram) {
+
+  std::vector<std::string> counters = strutils::split(histogram, '/');
+  if (counters.size() != METRICS_HISTOGRAM_BUCKETS) {
+    return false;
+  }
+  try {
+    for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++) {
+      this->histogram[bucket] = std::stoull(counters.at(bucket));
+    }
+  } catch (std::exception& ex) {
+    return false;
+  }
+  return true;
+}
+
+}
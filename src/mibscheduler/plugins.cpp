@@ -0,0 +1,106 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <mibscheduler/plugins.hpp>
+
+#include <dlfcn.h>
+#include <map>
+#include <mutex>
+
+namespace murmure {
+namespace plugins {
+
+//Loaded shared objects (path => handle) and resolved hooks (reference => hook)
+static std::map<std::string, void*> libraries;
+static std::map<std::string, murmure_hook> hooks;
+static std::mutex pluginsMutex;
+
+/**
+ * @function getHook
+ * @description resolve a hook reference, loading its shared object if not loaded yet
+ * @param std::string reference as '/path/to/plugin.so:hook_name'
+ * @param murmure_hook& resolved hook
+ * @param std::string& error string pointer
+ * @returns bool: true if hook has been resolved
+ * NOTE: libraries are kept loaded until unloadAll is called
+**/
+
+bool getHook(const std::string& reference, murmure_hook& hook, std::string& error) {
+
+  std::lock_guard<std::mutex> lock(pluginsMutex);
+  std::map<std::string, murmure_hook>::iterator cachedHook = hooks.find(reference);
+  if (cachedHook != hooks.end()) {
+    hook = cachedHook->second;
+    return true;
+  }
+  size_t sepPos = reference.rfind(':');
+  if (sepPos == std::string::npos || sepPos == 0 || sepPos == reference.length() - 1) {
+    error = "Invalid plugin reference '" + reference + "'; expected <library>:<function>";
+    return false;
+  }
+  std::string path = reference.substr(0, sepPos);
+  std::string symbol = reference.substr(sepPos + 1);
+  //Load library
+  void* library;
+  std::map<std::string, void*>::iterator loadedLibrary = libraries.find(path);
+  if (loadedLibrary != libraries.end()) {
+    library = loadedLibrary->second;
+  } else {
+    library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) {
+      error = "Could not load plugin " + path + ": " + dlerror();
+      return false;
+    }
+    libraries[path] = library;
+  }
+  //Resolve hook
+  dlerror();
+  void* address = dlsym(library, symbol.c_str());
+  if (address == nullptr) {
+    const char* dlError = dlerror();
+    error = "Could not find hook " + symbol + " in plugin " + path + (dlError != nullptr ? std::string(": ") + dlError : "");
+    return false;
+  }
+  hook = reinterpret_cast<murmure_hook>(address);
+  hooks[reference] = hook;
+  return true;
+}
+
+/**
+ * @function unloadAll
+ * @description unload all plugins
+ * NOTE: no hook must be running or called afterwards
+**/
+
+void unloadAll() {
+
+  std::lock_guard<std::mutex> lock(pluginsMutex);
+  hooks.clear();
+  for (auto& library : libraries) {
+    dlclose(library.second);
+  }
+  libraries.clear();
+}
+
+} // namespace plugins
+}
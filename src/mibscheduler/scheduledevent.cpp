@@ -21,8 +21,11 @@
  * SOFTWARE.
 **/
 
+#include <core/oid.hpp>
 #include <mibscheduler/scheduledevent.hpp>
 
+#include <algorithm>
+
 namespace murmure {
 
 /**
@@ -36,30 +39,104 @@ namespace murmure {
 
 ScheduledEvent::ScheduledEvent(const std::string& oid, EventMode evMode, const std::vector<std::string>& commandList, int timeout) : Event(oid, evMode, commandList) {
   this->timeout = timeout;
+  this->nextRun = -1;
+  this->lastExec = -1;
+  this->stretch = 0;
+  this->suspended = false;
 }
 
 /**
  * @function executeCommands
  * @description execute commands associated to this event
+ * @param CommandResults* results of commands executed by other events in the same tick; nullptr to always execute
  * @returns int amount of executed commands
 **/
 
-int ScheduledEvent::executeCommands() {
-  return Event::executeCommands();
+int ScheduledEvent::executeCommands(CommandResults* sharedResults /* = nullptr */) {
+  return Event::executeCommands("", "", sharedResults);
 }
 
 /**
- * @function calcRelativeTimeout
- * @description calc relative timeout based on elapsed time and timeout
- * @param time_t elapsedTime
- * @returns int calculated relative timeout
+ * @function schedule
+ * @description calc next run after elapsed time; runs missed meanwhile are skipped
+ * @param time_t elapsedTime seconds since scheduler start
+ * @param time_t current calendar time (for cron schedules)
+ * @returns time_t next run in seconds since scheduler start; -1 if the event is never going to run
+ * NOTE: periodic runs are at k * timeout + phase (k >= 1); cron runs follow local time.
+ * Each run is delayed by a deterministic jitter, derived from OID and run index
 **/
 
-int ScheduledEvent::calcRelativeTimeout(time_t elapsedTime) {
+time_t ScheduledEvent::schedule(time_t elapsedTime, time_t wallTime) {
+
+  if (cron.isSet()) {
+    time_t nextMatch = cron.next(wallTime);
+    if (nextMatch < 0) {
+      nextRun = -1;
+      return nextRun;
+    }
+    nextRun = elapsedTime + (nextMatch - wallTime) + jitterDelay(nextMatch / 60);
+    return nextRun;
+  }
+  if (timeout <= 0) {
+    nextRun = -1;
+    return nextRun;
+  }
+  int offset = phase % timeout;
+  time_t runIndex = elapsedTime > offset ? (elapsedTime - offset) / timeout : 1;
+  if (runIndex < 1) {
+    runIndex = 1;
+  }
+  while (runIndex * timeout + offset + jitterDelay(runIndex) <= elapsedTime) {
+    runIndex++;
+  }
+  nextRun = runIndex * timeout + offset + jitterDelay(runIndex);
+  return nextRun;
+}
+
+/**
+ * @function checkSchedule
+ * @description check whether timeout, phase and jitter are consistent
+ * @param std::string& error string pointer
+ * @returns bool: true if schedule is valid
+**/
+
+bool ScheduledEvent::checkSchedule(std::string& error) {
+
+  if (cron.isSet()) {
+    return true;
+  }
+  if (timeout <= 0) {
+    error = "Unset timeout for scheduled event";
+    return false;
+  }
+  if (phase >= timeout) {
+    error = "Phase must be less than timeout";
+    return false;
+  }
+  if (jitter >= timeout) {
+    error = "Jitter must be less than timeout";
+    return false;
+  }
+  if (idle > 0 && idle <= timeout) {
+    error = "Idle window must be greater than timeout";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function jitterDelay
+ * @description get the deterministic delay of a run
+ * @param uint64_t run index
+ * @returns int delay in seconds, in range [0, jitter]
+**/
 
-  this->relativeTimeout = this->timeout - (elapsedTime % this->timeout);
-  return this->relativeTimeout;
+int ScheduledEvent::jitterDelay(uint64_t runIndex) {
 
+  if (jitter <= 0) {
+    return 0;
+  }
+  return oidKey(oid + "#" + std::to_string(runIndex)) % (jitter + 1);
 }
 
 /**
@@ -73,13 +150,72 @@ int ScheduledEvent::getTimeout() {
 }
 
 /**
- * @function getRelativeTimeout
- * @description returns relative timeout class attribute
- * @returns int
+ * @function getNextRun
+ * @description returns next run, as calculated by schedule
+ * @returns time_t seconds since scheduler start; -1 if not scheduled
+**/
+
+time_t ScheduledEvent::getNextRun() {
+  return this->nextRun;
+}
+
+/**
+ * @function getIdle
+ * @description returns the idle window
+ * @returns int seconds; 0 if executions don't depend on reads
 **/
 
-int ScheduledEvent::getRelativeTimeout() {
-  return this->relativeTimeout;
+int ScheduledEvent::getIdle() {
+  return this->idle;
+}
+
+/**
+ * @function admit
+ * @description decide whether a due execution takes place, according to the idle mode
+ * @param time_t elapsedTime seconds since scheduler start
+ * @param bool true if event OID hasn't been read within the idle window
+ * @returns bool: true if the event must be executed
+ * NOTE: in suspend mode idle executions are skipped; in stretch mode the period is doubled
+ * at each idle execution, up to the idle window. Everything is reset as soon as OID is read
+**/
+
+bool ScheduledEvent::admit(time_t elapsedTime, bool idle) {
+
+  if (!idle) {
+    if (lastExec == elapsedTime && !suspended) {
+      //Already executed in this second, when resumed
+      return false;
+    }
+    suspended = false;
+    stretch = 0;
+    lastExec = elapsedTime;
+    return true;
+  }
+  if (idleMode == IdleMode::SUSPEND) {
+    suspended = true;
+    return false;
+  }
+  //Stretch; jitter may anticipate the run a little
+  if (stretch > 0 && lastExec >= 0 && elapsedTime - lastExec + jitter < stretch) {
+    return false;
+  }
+  int period = stretch;
+  if (period == 0) {
+    period = timeout > 0 ? timeout : (lastExec >= 0 ? static_cast<int>(elapsedTime - lastExec) : 0);
+  }
+  stretch = std::min(period * 2, this->idle);
+  lastExec = elapsedTime;
+  return true;
+}
+
+/**
+ * @function isSuspended
+ * @description returns whether executions are being skipped since OID is idle
+ * @returns bool
+**/
+
+bool ScheduledEvent::isSuspended() {
+  return this->suspended;
 }
 
 /**
@@ -134,16 +270,4 @@ bool sortByTimeout(ScheduledEvent* firstEv, ScheduledEvent* secondEv) {
   return firstEv->getTimeout() < secondEv->getTimeout();
 }
 
-/**
- * @function sortByRelativeTimeout
- * @description sort scheduled events by their relative timeout in seconds
- * @param ScheduledEvent* first ScheduledEvent to compare
- * @param ScheduledEvent* second ScheduledEvent to compare
- * @returns bool: true if this ScheduledEvent's relative timeout is < passed ScheduledEvent's timeout
-**/
-
-bool sortByRelativeTimeout(ScheduledEvent* firstEv, ScheduledEvent* secondEv) {
-  return firstEv->getRelativeTimeout() < secondEv->getRelativeTimeout();
-}
-
 }
@@ -21,6 +21,8 @@
  * SOFTWARE.
 **/
 
+#include <mibscheduler/builtins.hpp>
+#include <mibscheduler/plugins.hpp>
 #include <mibscheduler/scheduler.hpp>
 #include <utils/databasefacade.hpp>
 #include <utils/logger.hpp>
@@ -40,6 +42,101 @@ std::vector<Event*> murmure::Scheduler::events;
 std::vector<ScheduledEvent*> murmure::Scheduler::scheduledEvents;
 std::thread* murmure::Scheduler::schedulerThread;
 bool murmure::Scheduler::stopCalled;
+std::multimap<std::chrono::steady_clock::time_point, Event*> murmure::Scheduler::deferredEvents;
+std::mutex murmure::Scheduler::dispatchMutex;
+std::condition_variable murmure::Scheduler::dispatchCondition;
+std::thread* murmure::Scheduler::dispatcherThread;
+std::deque<Oid*> murmure::Scheduler::refreshQueue;
+std::set<Oid*> murmure::Scheduler::refreshingOids;
+std::condition_variable murmure::Scheduler::refreshCondition;
+volatile std::sig_atomic_t murmure::Scheduler::reloadRequested = 0;
+std::mutex murmure::Scheduler::eventsMutex;
+std::unordered_map<uint64_t, std::vector<Event*>> murmure::Scheduler::subtreeEvents;
+std::vector<Event*> murmure::Scheduler::retiredEvents;
+std::thread* murmure::Scheduler::initThread;
+std::multiset<std::string> murmure::Scheduler::pendingInits;
+std::mutex murmure::Scheduler::initMutex;
+static SystemClock systemClock;
+Clock* murmure::Scheduler::schedulerClock = &systemClock;
+Mibtable* murmure::Scheduler::mibtable;
+
+/**
+ * @function dumpOptions
+ * @description format event options as scheduling file tokens
+ * @param EventOptions
+ * @returns std::string ";name=value" for each option
+**/
+
+static std::string dumpOptions(const EventOptions& options) {
+  std::stringstream optStream;
+  for (auto& option : options) {
+    optStream << ";" << option.first << "=" << option.second;
+  }
+  return optStream.str();
+}
+
+/**
+ * @function applyOptions
+ * @description set options to event
+ * @param Event*
+ * @param EventOptions
+ * @param std::string& error string pointer
+ * @returns bool: true if all options are valid
+**/
+
+static bool applyOptions(Event* event, const EventOptions& options, std::string& error) {
+  for (auto& option : options) {
+    if (!event->setOption(option.first, option.second, error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @function checkOptions
+ * @description check options on a dummy event
+ * @param std::string oid
+ * @param EventMode mode
+ * @param std::vector<std::string> command list
+ * @param int timeout (for scheduled events)
+ * @param EventOptions
+ * @param std::string& error string pointer
+ * @returns bool: true if options are valid for the event
+**/
+
+static bool checkOptions(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, int timeout, const EventOptions& options, std::string& error) {
+  bool validOptions;
+  if (mode == EventMode::AUTO) {
+    ScheduledEvent* dummyEv = new ScheduledEvent(oid, mode, commandList, timeout);
+    validOptions = applyOptions(dummyEv, options, error) && dummyEv->checkSchedule(error);
+    delete dummyEv;
+  } else {
+    Event* dummyEv = new Event(oid, mode, commandList);
+    validOptions = applyOptions(dummyEv, options, error);
+    delete dummyEv;
+  }
+  return validOptions;
+}
+
+/**
+ * @function eventIdentity
+ * @description describe an event by everything which affects its execution (as a scheduling file line)
+ * @param Event*
+ * @param int timeout (for scheduled events)
+ * @returns std::string
+**/
+
+static std::string eventIdentity(Event* event, int timeout = 0) {
+  std::stringstream idStream;
+  idStream << event->getOid() << ";" << event->getModeName() << ";";
+  for (auto& cmd : event->getCommandList()) {
+    //Length prefixed, since commands may contain commas
+    idStream << cmd.length() << ":" << cmd;
+  }
+  idStream << ";" << timeout << dumpOptions(event->getOptions());
+  return idStream.str();
+}
 
 /**
  * @function Scheduler
@@ -47,7 +144,10 @@ bool murmure::Scheduler::stopCalled;
 **/
 
 Scheduler::Scheduler() {
+  mibtable = nullptr;
   schedulerThread = nullptr;
+  dispatcherThread = nullptr;
+  initThread = nullptr;
   stopCalled = false;
 }
 
@@ -59,7 +159,9 @@ Scheduler::Scheduler() {
 
 Scheduler::Scheduler(Mibtable* mTable) {
   mibtable = mTable;
+  Event::setMibtable(mTable);
   schedulerThread = nullptr;
+  dispatcherThread = nullptr;
   stopCalled = false;
 }
 
@@ -71,6 +173,15 @@ Scheduler::Scheduler(Mibtable* mTable) {
 Scheduler::~Scheduler() {
 
   stopCalled = true;
+  //Don't wait for the scheduler thread to complete its tick
+  schedulerClock->interrupt(true);
+
+  if (initThread != nullptr) {
+    //INIT events not started yet are skipped
+    initThread->join();
+    delete initThread;
+    initThread = nullptr;
+  }
 
   if (schedulerThread != nullptr) {
     //Join thread before deleting it
@@ -80,6 +191,23 @@ Scheduler::~Scheduler() {
     schedulerThread = nullptr;
   }
 
+  if (dispatcherThread != nullptr) {
+    //Wake up dispatcher, it will flush deferred executions before terminating
+    {
+      std::lock_guard<std::mutex> lock(dispatchMutex);
+      dispatchCondition.notify_all();
+    }
+    dispatcherThread->join();
+    delete dispatcherThread;
+    dispatcherThread = nullptr;
+  }
+
+  //Persist metrics of executions not flushed yet
+  flushMetrics();
+
+  //No hook can be running now
+  plugins::unloadAll();
+
   //Free event objects
   for (auto& event : events) {
     delete event;
@@ -89,6 +217,11 @@ Scheduler::~Scheduler() {
     delete event;
   }
 
+  for (auto& event : retiredEvents) {
+    delete event;
+  }
+  retiredEvents.clear();
+
   //Do not free mibtable, since it's freed in main
 }
 
@@ -100,6 +233,27 @@ Scheduler::~Scheduler() {
 
 bool Scheduler::loadEvents() {
 
+  if (!readEvents(events, scheduledEvents)) {
+    return false;
+  }
+  //Bind events to their OID
+  for (auto& event : events) {
+    bindEvent(event);
+  }
+  return true;
+}
+
+/**
+ * @function readEvents
+ * @description read events from database into the provided lists
+ * @param std::vector<Event*>& list where GET, SET and INIT events are pushed
+ * @param std::vector<ScheduledEvent*>& list where AUTO events are pushed
+ * @returns bool true if reading succeeded
+ * NOTE: events are not bound to their OID
+**/
+
+bool Scheduler::readEvents(std::vector<Event*>& eventList, std::vector<ScheduledEvent*>& scheduledEventList) {
+
   std::string errorString;
   //Select events from database
 
@@ -112,8 +266,8 @@ bool Scheduler::loadEvents() {
     return false;
   }
 
-  size_t eventListSize = 0;
-  size_t scheduledEventListSize = 0;
+  size_t eventListSize = eventList.size();
+  size_t scheduledEventListSize = scheduledEventList.size();
 
   //Fetch rows
   for (auto& row : tableEntries) {
@@ -153,9 +307,14 @@ bool Scheduler::loadEvents() {
       int timeout = std::stoi(row.at(3)); //Get timeout, which is 4th arg
       //Instance new scheduledEvent
       ScheduledEvent* newEv = new ScheduledEvent(oid, EventMode::AUTO, commandList, timeout);
+      newEv->setId(std::stoi(evId));
+      if (!loadEventOptions(newEv, evId)) {
+        delete newEv;
+        return false;
+      }
       //Push to array new scheduledEvent element
-      scheduledEvents.resize(scheduledEventListSize++);
-      scheduledEvents.push_back(newEv);
+      scheduledEventList.resize(scheduledEventListSize++);
+      scheduledEventList.push_back(newEv);
     } else {
       //Event vector
       //Get eventMode enum
@@ -174,9 +333,14 @@ bool Scheduler::loadEvents() {
       }
       //Instance new Event
       Event* newEv = new Event(oid, evMode, commandList);
+      newEv->setId(std::stoi(evId));
+      if (!loadEventOptions(newEv, evId)) {
+        delete newEv;
+        return false;
+      }
       //Push to array new event element
-      events.resize(eventListSize++);
-      events.push_back(newEv);
+      eventList.resize(eventListSize++);
+      eventList.push_back(newEv);
     }
   }
   return true;
@@ -184,7 +348,7 @@ bool Scheduler::loadEvents() {
 
 /**
  * @function fetchAndExec
- * @description search for event associated to provided oid and mode; if found execute associated commands
+ * @description search for events associated to provided oid and mode; if found execute associated commands
  * @param std::string oid to search
  * @param EventMode command mode
  * @returns int: amount of executed commands; 0 if no event is associated
@@ -192,35 +356,209 @@ bool Scheduler::loadEvents() {
 
 int Scheduler::fetchAndExec(const std::string& oid, EventMode mode) {
 
+  if (mibtable == nullptr) {
+    return 0;
+  }
+  Oid* assocOid = mibtable->getOidByOid(oid);
+  if (assocOid == nullptr) {
+    return 0;
+  }
+  return fetchAndExec(assocOid, mode);
+}
+
+/**
+ * @function fetchAndExec
+ * @description trigger all the events bound to provided oid (or to its subtree) for provided mode
+ * @param Oid* oid
+ * @param EventMode command mode
+ * @param std::string value which triggered the events (for SET)
+ * @param std::string OID which triggered the events, if different from oid (e.g. new table rows)
+ * @returns int: amount of executed commands; 0 if no event is associated or executions have been debounced
+**/
+
+int Scheduler::fetchAndExec(Oid* oid, EventMode mode, const std::string& value /* = "" */, const std::string& triggerOid /* = "" */) {
+
   //NOTE: Mode cannot be auto! Automatic event (scheduled events) can only be executed by the scheduler thread
 
-  for (auto& event : events) {
-    //If oid and mode mathces with event then execute associated events
-    if (oid == event->getOid() && mode == event->getMode()) {
-      logger::log(COMPONENT, LOG_INFO, "Executing events for OID " + event->getOid());
-      return event->executeCommands();
+  int commandAmount = 0;
+  std::vector<Event*> boundEvents = pinEvents(oid, mode);
+  for (auto& event : boundEvents) {
+    commandAmount += triggerEvent(event, value, triggerOid.length() > 0 ? triggerOid : oid->getOid());
+  }
+  unpinEvents(boundEvents);
+
+  return commandAmount;
+}
+
+/**
+ * @function refresh
+ * @description run GET events for provided oid according to its freshness policy, then reload its value
+ * @param Oid* oid which is going to be read
+ * @returns int: amount of commands executed synchronously
+ * NOTE: without a freshness policy GET events are executed synchronously. Otherwise the value is served
+ * as is if younger than maxage; if stale by less than grace it's served while refreshed asynchronously;
+ * beyond that the request waits for the refresh at most for the deadline
+**/
+
+int Scheduler::refresh(Oid* oid) {
+
+  //Keep track of reads, since AUTO events may depend on them
+  oid->markRead();
+  if (isInitPending(oid->getOid())) {
+    logger::log(COMPONENT, LOG_DEBUG, "Serving OID " + oid->getOid() + " while its INIT events are pending");
+  }
+  std::vector<Event*> getEvents = pinEvents(oid, EventMode::GET);
+  if (getEvents.empty()) {
+    return 0;
+  }
+  //Get freshness policy
+  bool freshness = false;
+  std::chrono::milliseconds maxAge(0);
+  std::chrono::milliseconds grace(0);
+  std::chrono::milliseconds deadline(0);
+  for (auto& event : getEvents) {
+    if (event->hasFreshness()) {
+      freshness = true;
+      maxAge = event->getMaxAge();
+      grace = event->getGrace();
+      deadline = event->getDeadline();
+      break;
+    }
+  }
+  unpinEvents(getEvents);
+  if (!freshness || dispatcherThread == nullptr) {
+    //Refresh synchronously
+    int commandAmount = fetchAndExec(oid, EventMode::GET);
+    if (commandAmount > 0) {
+      oid->reloadValue();
     }
+    return commandAmount;
   }
 
-  //No event associated to this oid
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point lastUpdate = oid->getLastUpdate();
+  bool refreshed = lastUpdate != std::chrono::steady_clock::time_point::min();
+  if (refreshed && now - lastUpdate < maxAge) {
+    //Fresh
+    return 0;
+  }
+  requestRefresh(oid);
+  if (refreshed && now - lastUpdate < maxAge + grace) {
+    //Stale, but in grace period
+    logger::log(COMPONENT, LOG_DEBUG, "Serving stale value for OID " + oid->getOid());
+    return 0;
+  }
+  //Wait for refresh
+  std::unique_lock<std::mutex> lock(dispatchMutex);
+  if (!refreshCondition.wait_until(lock, now + deadline, [oid]() { return refreshingOids.count(oid) == 0; })) {
+    logger::log(COMPONENT, LOG_WARN, "Refresh deadline exceeded for OID " + oid->getOid());
+  }
   return 0;
 }
 
+/**
+ * @function hasEvents
+ * @description returns whether any event is bound to oid (or to its subtree) for provided mode
+ * @param Oid* oid
+ * @param EventMode mode
+ * @returns bool
+**/
+
+bool Scheduler::hasEvents(Oid* oid, EventMode mode) {
+
+  std::vector<Event*> boundEvents = pinEvents(oid, mode);
+  bool found = !boundEvents.empty();
+  unpinEvents(boundEvents);
+  return found;
+}
+
+/**
+ * @function requestRefresh
+ * @description queue an asynchronous refresh of the oid to the dispatcher thread, unless already queued or running
+ * @param Oid* oid to refresh
+**/
+
+void Scheduler::requestRefresh(Oid* oid) {
+
+  std::lock_guard<std::mutex> lock(dispatchMutex);
+  if (!refreshingOids.insert(oid).second) {
+    return;
+  }
+  refreshQueue.push_back(oid);
+  dispatchCondition.notify_one();
+}
+
+/**
+ * @function refreshOid
+ * @description run GET events for oid and reload its value; waiting requests are notified
+ * @param Oid* oid to refresh
+**/
+
+void Scheduler::refreshOid(Oid* oid) {
+
+  std::vector<Event*> getEvents = pinEvents(oid, EventMode::GET);
+  for (auto& event : getEvents) {
+    triggerEvent(event, "", oid->getOid());
+  }
+  unpinEvents(getEvents);
+  oid->reloadValue();
+  std::lock_guard<std::mutex> lock(dispatchMutex);
+  refreshingOids.erase(oid);
+  refreshCondition.notify_all();
+}
+
+/**
+ * @function triggerEvent
+ * @description pass a trigger through the event debounce and execute the event if allowed
+ * @param Event* event to trigger
+ * @param std::string value which triggered the event
+ * @param std::string OID which triggered the event
+ * @returns int: amount of executed commands
+**/
+
+int Scheduler::triggerEvent(Event* event, const std::string& value, const std::string& triggerOid) {
+
+  std::chrono::steady_clock::time_point deferUntil;
+  TriggerResult result = event->trigger(value, triggerOid, std::chrono::steady_clock::now(), deferUntil);
+  if (result == TriggerResult::DEFER) {
+    logger::log(COMPONENT, LOG_DEBUG, "Deferred events for OID " + event->getOid());
+    deferEvent(event, deferUntil);
+    return 0;
+  } else if (result == TriggerResult::SUPPRESS) {
+    logger::log(COMPONENT, LOG_DEBUG, "Suppressed events for OID " + event->getOid());
+    return 0;
+  }
+  logger::log(COMPONENT, LOG_INFO, "Executing events for OID " + triggerOid);
+  int commandAmount = event->executeCommands(value, triggerOid);
+  //Triggers received meanwhile are executed once more
+  if (event->complete(std::chrono::steady_clock::now(), deferUntil)) {
+    deferEvent(event, deferUntil);
+  }
+  return commandAmount;
+}
+
+/**
+ * @function deferEvent
+ * @description queue an event execution to the dispatcher thread
+ * @param Event* event to execute
+ * @param time_point when to execute the event
+**/
+
+void Scheduler::deferEvent(Event* event, std::chrono::steady_clock::time_point when) {
+
+  std::lock_guard<std::mutex> lock(dispatchMutex);
+  deferredEvents.insert(std::make_pair(when, event));
+  dispatchCondition.notify_one();
+}
+
 /**
  * @function startScheduler
- * @description start new scheduler thread and execute all INIT events
+ * @description start new scheduler thread and start executing INIT events in background
  * @returns bool: true if thread started
 **/
 
 bool Scheduler::startScheduler() {
 
-  //Execute all INIT commands
-  for (auto& event : events) {
-    if (event->getMode() == EventMode::INIT) {
-      event->executeCommands();
-    }
-  }
-
   //Start scheduler thread
   if (schedulerThread != nullptr) {
     //It's already running
@@ -228,7 +566,25 @@ bool Scheduler::startScheduler() {
     return false;
   }
 
+  //INIT events run in background, so that requests are served meanwhile; they're pinned until executed
+  std::vector<Event*> initEvents;
+  {
+    std::lock_guard<std::mutex> lock(initMutex);
+    for (auto& event : events) {
+      if (event->getMode() == EventMode::INIT) {
+        event->pin();
+        initEvents.push_back(event);
+        pendingInits.insert(event->getOid());
+      }
+    }
+  }
+  if (!initEvents.empty()) {
+    initThread = new std::thread(runInitEvents, initEvents);
+  }
+
+  schedulerClock->interrupt(false);
   schedulerThread = new std::thread(runScheduler);
+  dispatcherThread = new std::thread(runDispatcher);
   return true;
 }
 
@@ -240,14 +596,16 @@ bool Scheduler::startScheduler() {
  * @param std::vector<std::string> list of commands
  * @param std::string& error string pointer
  * @param int optional timeout (for scheduled events)
+ * @param EventOptions optional event options
  * @returns bool: true if entry is valid
  * NOTE: an entry is valid if:
  * a) oid exists; 
  * b) if mode is 'AUTO' timeout is > 0;
  * c) command list has at least one element
+ * d) options are valid for the event
 **/
 
-bool Scheduler::parseScheduling(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, std::string& error, int timeout /*= 0*/) {
+bool Scheduler::parseScheduling(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, std::string& error, int timeout /*= 0*/, const EventOptions& options /* = EventOptions() */) {
 
   //Try to get oid
   if (mibtable->getOidByOid(oid) == nullptr) {
@@ -255,8 +613,8 @@ bool Scheduler::parseScheduling(const std::string& oid, EventMode mode, const st
     return false;
   }
 
-  //Check if timeout is set
-  if (mode == EventMode::AUTO && timeout <= 0) {
+  //Check if timeout is set (cron schedules don't need it)
+  if (mode == EventMode::AUTO && timeout <= 0 && options.count(EVENTOPTION_CRON) == 0) {
     error = "Unset timeout for scheduled event";
     return false;
   }
@@ -267,8 +625,20 @@ bool Scheduler::parseScheduling(const std::string& oid, EventMode mode, const st
     return false;
   }
 
+  //Check builtin actions
+  for (auto& command : commandList) {
+    if (builtins::isBuiltin(command) && !builtins::check(mibtable, command, error)) {
+      return false;
+    }
+  }
+
+  //Check options
+  if (!checkOptions(oid, mode, commandList, timeout, options, error)) {
+    return false;
+  }
+
   //Try to add new event to database
-  return addEvent(oid, mode, commandList, timeout);
+  return addEvent(oid, mode, commandList, error, timeout, options);
 }
 
 /**
@@ -327,17 +697,38 @@ bool Scheduler::parseScheduling(const std::string& filename, std::string& error)
       return false;
     }
 
-    //Check for timeout
-    if (modeStr == EVENTMODE_AUTO && eventTokens.size() > 3) {
-      timeout = std::stoi(eventTokens.at(3));
-      //Check if timeout is valid
-      if (timeout == 0) {
+    //Check for timeout and options (name=value)
+    bool timeoutSet = false;
+    EventOptions options;
+    for (size_t tokenIndex = 3; tokenIndex < eventTokens.size(); tokenIndex++) {
+      std::string token = eventTokens.at(tokenIndex);
+      size_t eqPos = token.find('=');
+      if (token.length() == 0) {
+        continue;
+      } else if (eqPos != std::string::npos) {
+        options[token.substr(0, eqPos)] = token.substr(eqPos + 1);
+      } else if (mode == EventMode::AUTO && !timeoutSet) {
+        try {
+          timeout = std::stoi(token);
+        } catch (std::exception& ex) {
+          timeout = 0;
+        }
+        timeoutSet = true;
+        //Check if timeout is valid
+        if (timeout <= 0) {
+          std::stringstream errSs;
+          errSs << "Error at line " << std::to_string(lineNumber) << ". Invalid timeout for event mode 'AUTO'";
+          error = errSs.str();
+          return false;
+        }
+      } else {
         std::stringstream errSs;
-        errSs << "Error at line " << std::to_string(lineNumber) << ". Timeout 0 for event mode 'AUTO'";
+        errSs << "Error at line " << std::to_string(lineNumber) << ". Unexpected argument " << token;
         error = errSs.str();
         return false;
       }
-    } else if (modeStr == EVENTMODE_AUTO && eventTokens.size() < 4) {
+    }
+    if (mode == EventMode::AUTO && !timeoutSet && options.count(EVENTOPTION_CRON) == 0) {
       std::stringstream errSs;
       errSs << "Error at line " << std::to_string(lineNumber) << ". Timeout not provided for event mode 'AUTO'";
       error = errSs.str();
@@ -348,7 +739,7 @@ bool Scheduler::parseScheduling(const std::string& filename, std::string& error)
     std::vector<std::string> commandList = strutils::split(cmdStr, ',');
 
     //Add new event
-    bool parseRes = parseScheduling(oid, mode, commandList, error, timeout);
+    bool parseRes = parseScheduling(oid, mode, commandList, error, timeout, options);
     if (!parseRes) {
       std::stringstream errSs;
       errSs << "Error at line " << std::to_string(lineNumber) << " " << error;
@@ -402,14 +793,37 @@ bool Scheduler::clearEvents() {
     logger::log(COMPONENT, LOG_ERROR, errorString);
     return false;
   }
+  //DELETE from events metrics
+  query = "DELETE FROM events_metrics";
+  if (!database::exec(query, errorString)) {
+    //Database query failed
+    logger::log(COMPONENT, LOG_ERROR, errorString);
+    return false;
+  }
+  //DELETE from events options
+  query = "DELETE FROM events_options";
+  if (!database::exec(query, errorString)) {
+    //Database query failed
+    logger::log(COMPONENT, LOG_ERROR, errorString);
+    return false;
+  }
+  query = "DELETE FROM sqlite_sequence WHERE name = \"events_options\"";
+  if (!database::exec(query, errorString)) {
+    //Database query failed
+    logger::log(COMPONENT, LOG_ERROR, errorString);
+    return false;
+  }
   //Delete objects
   for (auto& event : events) {
+    unbindEvent(event);
     delete event;
   }
+  events.clear();
 
   for (auto& event : scheduledEvents) {
     delete event;
   }
+  scheduledEvents.clear();
 
   return true;
 }
@@ -450,6 +864,7 @@ bool Scheduler::dumpScheduling(const std::string& filename /* = "" */) {
         lineStream << ",";
       }
     }
+    lineStream << dumpOptions(event->getOptions());
     lineStream << std::endl;
     std::string line = lineStream.str();
     if (toStdout) {
@@ -480,7 +895,10 @@ bool Scheduler::dumpScheduling(const std::string& filename /* = "" */) {
         lineStream << ",";
       }
     }
-    lineStream << ";" << event->getTimeout();
+    if (event->getTimeout() > 0) {
+      lineStream << ";" << event->getTimeout();
+    }
+    lineStream << dumpOptions(event->getOptions());
     lineStream << std::endl;
     std::string line = lineStream.str();
     if (toStdout) {
@@ -500,6 +918,292 @@ bool Scheduler::dumpScheduling(const std::string& filename /* = "" */) {
   return true;
 }
 
+/**
+ * @function dumpMetrics
+ * @description dump execution metrics stored into database
+ * @param std::string filename optional filename where to write dump; stdout is used otherwise
+ * @returns bool: true if successfully dumped
+**/
+
+bool Scheduler::dumpMetrics(const std::string& filename /* = "" */) {
+
+  std::string errorString;
+  std::vector<std::vector<std::string>> metricsRows;
+  std::string query = "SELECT e.oid, e.mode, m.runs, m.failures, m.timeouts, m.last_duration, m.total_duration, m.max_duration, m.histogram, m.coalesced FROM events_metrics m INNER JOIN scheduled_events e ON e.event_id = m.event_id ORDER BY m.total_duration DESC;";
+  if (!database::select(&metricsRows, query, errorString)) {
+    logger::log(COMPONENT, LOG_ERROR, errorString);
+    return false;
+  }
+
+  std::stringstream dumpStream;
+  for (auto& row : metricsRows) {
+    if (row.size() != 10) {
+      continue;
+    }
+    uint64_t runs = std::stoull(row.at(2));
+    uint64_t avgDuration = runs > 0 ? std::stoull(row.at(6)) / runs : 0;
+    dumpStream << row.at(0) << ";" << row.at(1);
+    dumpStream << ";runs=" << runs << ";failures=" << row.at(3) << ";timeouts=" << row.at(4);
+    dumpStream << ";last=" << row.at(5) << ";avg=" << avgDuration << ";max=" << row.at(7);
+    dumpStream << ";histogram=" << row.at(8) << ";coalesced=" << row.at(9) << std::endl;
+  }
+
+  if (filename.length() == 0) {
+    std::cout << dumpStream.str();
+    return true;
+  }
+  std::ofstream fileStream;
+  fileStream.open(filename, std::ofstream::out | std::ofstream::trunc);
+  if (!fileStream.is_open()) {
+    logger::log(COMPONENT, LOG_ERROR, "Could not open dump file");
+    return false;
+  }
+  fileStream << dumpStream.str();
+  fileStream.close();
+  return true;
+}
+
+/**
+ * @function setExecTimeout
+ * @description set global execution timeout, used by events which don't set exectimeout
+ * @param int timeout in milliseconds; 0 means no timeout
+**/
+
+void Scheduler::setExecTimeout(int timeout) {
+  Event::setDefaultExecTimeout(timeout);
+}
+
+/**
+ * @function requestReload
+ * @description request the scheduler thread to reload events from database
+ * NOTE: this function is async-signal-safe, so that it can be called by a signal handler
+**/
+
+void Scheduler::requestReload() {
+  reloadRequested = 1;
+}
+
+/**
+ * @function setClock
+ * @description set the time source of the scheduler thread; must be called before starting the scheduler
+ * @param Clock* clock (not owned); nullptr to use the system clock
+**/
+
+void Scheduler::setClock(Clock* clock) {
+  schedulerClock = clock != nullptr ? clock : &systemClock;
+}
+
+/**
+ * @function adoptEvent
+ * @description add a scheduled event which is not stored in database (e.g. benchmarks); the scheduler takes its ownership
+ * @param ScheduledEvent* event
+**/
+
+void Scheduler::adoptEvent(ScheduledEvent* event) {
+  scheduledEvents.push_back(event);
+}
+
+/**
+ * @function reloadEvents
+ * @description reload events from database, keeping the events which didn't change
+ * @returns bool: true if events have been reloaded
+ * NOTE: unchanged events keep their state (timer phase, debounce); removed events are retired and freed
+ * once their executions have terminated. INIT events are not executed again.
+**/
+
+bool Scheduler::reloadEvents() {
+
+  std::vector<Event*> newEvents;
+  std::vector<ScheduledEvent*> newScheduledEvents;
+  if (!readEvents(newEvents, newScheduledEvents)) {
+    logger::log(COMPONENT, LOG_ERROR, "Could not reload events; keeping current scheduling");
+    for (auto& event : newEvents) {
+      delete event;
+    }
+    for (auto& event : newScheduledEvents) {
+      delete event;
+    }
+    return false;
+  }
+
+  size_t keptAmount = 0;
+  //Diff events
+  std::multimap<std::string, Event*> currentEvents;
+  for (auto& event : events) {
+    currentEvents.insert(std::make_pair(eventIdentity(event), event));
+  }
+  std::vector<Event*> reloadedEvents;
+  std::vector<Event*> addedEvents;
+  for (auto& event : newEvents) {
+    std::multimap<std::string, Event*>::iterator current = currentEvents.find(eventIdentity(event));
+    if (current != currentEvents.end()) {
+      //Unchanged, keep current instance
+      current->second->setId(event->getId());
+      reloadedEvents.push_back(current->second);
+      currentEvents.erase(current);
+      delete event;
+      keptAmount++;
+    } else {
+      reloadedEvents.push_back(event);
+      addedEvents.push_back(event);
+    }
+  }
+  //Diff scheduled events
+  std::multimap<std::string, ScheduledEvent*> currentScheduledEvents;
+  for (auto& event : scheduledEvents) {
+    currentScheduledEvents.insert(std::make_pair(eventIdentity(event, event->getTimeout()), event));
+  }
+  std::vector<ScheduledEvent*> reloadedScheduledEvents;
+  size_t addedScheduledAmount = 0;
+  for (auto& event : newScheduledEvents) {
+    std::multimap<std::string, ScheduledEvent*>::iterator current = currentScheduledEvents.find(eventIdentity(event, event->getTimeout()));
+    if (current != currentScheduledEvents.end()) {
+      current->second->setId(event->getId());
+      reloadedScheduledEvents.push_back(current->second);
+      currentScheduledEvents.erase(current);
+      delete event;
+      keptAmount++;
+    } else {
+      reloadedScheduledEvents.push_back(event);
+      addedScheduledAmount++;
+    }
+  }
+
+  //Rebind events to OIDs
+  for (auto& removed : currentEvents) {
+    Event* event = removed.second;
+    unbindEvent(event);
+    //Metrics of removed events are discarded
+    event->takeMetrics();
+    retiredEvents.push_back(event);
+  }
+  for (auto& event : addedEvents) {
+    bindEvent(event);
+  }
+  events = reloadedEvents;
+  //Scheduled events are executed by this thread only, so they can be freed immediately
+  for (auto& removed : currentScheduledEvents) {
+    delete removed.second;
+  }
+  scheduledEvents = reloadedScheduledEvents;
+
+  std::stringstream logS;
+  logS << "Events reloaded: " << keptAmount << " unchanged, " << addedEvents.size() + addedScheduledAmount << " added, ";
+  logS << currentEvents.size() + currentScheduledEvents.size() << " removed";
+  logger::log(COMPONENT, LOG_INFO, logS.str());
+  return true;
+}
+
+/**
+ * @function reapEvents
+ * @description free retired events which are not used anymore
+**/
+
+void Scheduler::reapEvents() {
+
+  for (std::vector<Event*>::iterator it = retiredEvents.begin(); it != retiredEvents.end();) {
+    if ((*it)->isBusy()) {
+      ++it;
+      continue;
+    }
+    delete *it;
+    it = retiredEvents.erase(it);
+  }
+}
+
+/**
+ * @function pinEvents
+ * @description get the events bound to oid for provided mode, pinned so that a reload can't free them
+ * @param Oid* oid
+ * @param EventMode mode
+ * @returns std::vector<Event*>: events to release with unpinEvents
+**/
+
+std::vector<Event*> Scheduler::pinEvents(Oid* oid, EventMode mode) {
+
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  std::vector<Event*> boundEvents = oid->getEvents(mode);
+  //Look for subtree events bound to OID or to its ancestors
+  if (!subtreeEvents.empty()) {
+    std::string prefix = oid->getOid();
+    while (prefix.length() > 0) {
+      std::unordered_map<uint64_t, std::vector<Event*>>::iterator prefixEvents = subtreeEvents.find(oidKey(prefix));
+      if (prefixEvents != subtreeEvents.end()) {
+        for (auto& event : prefixEvents->second) {
+          //Key collisions are filtered by OID
+          if (event->getMode() == mode && event->getOid() == prefix) {
+            boundEvents.push_back(event);
+          }
+        }
+      }
+      size_t lastDotPos = prefix.find_last_of('.');
+      prefix = lastDotPos != std::string::npos ? prefix.substr(0, lastDotPos) : "";
+    }
+  }
+  for (auto& event : boundEvents) {
+    event->pin();
+  }
+  return boundEvents;
+}
+
+/**
+ * @function unpinEvents
+ * @description release events returned by pinEvents
+ * @param std::vector<Event*> events to release
+**/
+
+void Scheduler::unpinEvents(const std::vector<Event*>& eventList) {
+  for (auto& event : eventList) {
+    event->unpin();
+  }
+}
+
+/**
+ * @function flushMetrics
+ * @description add metrics recorded by events since last flush to the ones stored into database
+**/
+
+void Scheduler::flushMetrics() {
+
+  std::vector<Event*> allEvents(events.begin(), events.end());
+  allEvents.insert(allEvents.end(), scheduledEvents.begin(), scheduledEvents.end());
+  for (auto& event : allEvents) {
+    EventMetrics recorded = event->takeMetrics();
+    if (recorded.runs == 0 || event->getId() == 0) {
+      continue;
+    }
+    std::string errorString;
+    std::string eventId = std::to_string(event->getId());
+    //Get stored metrics
+    std::vector<std::vector<std::string>> metricsRows;
+    std::string query = "SELECT runs, failures, timeouts, last_duration, total_duration, max_duration, histogram, coalesced FROM events_metrics WHERE event_id = " + eventId + ";";
+    if (!database::select(&metricsRows, query, errorString)) {
+      logger::log(COMPONENT, LOG_ERROR, errorString);
+      continue;
+    }
+    EventMetrics stored;
+    if (metricsRows.size() > 0 && metricsRows.at(0).size() == 8) {
+      std::vector<std::string>& row = metricsRows.at(0);
+      stored.runs = std::stoull(row.at(0));
+      stored.failures = std::stoull(row.at(1));
+      stored.timeouts = std::stoull(row.at(2));
+      stored.lastDuration = std::stoull(row.at(3));
+      stored.totalDuration = std::stoull(row.at(4));
+      stored.maxDuration = std::stoull(row.at(5));
+      stored.setHistogram(row.at(6));
+      stored.coalesced = std::stoull(row.at(7));
+    }
+    stored.merge(recorded);
+    std::stringstream queryStr;
+    queryStr << "INSERT OR REPLACE INTO events_metrics(event_id, runs, failures, timeouts, last_duration, total_duration, max_duration, histogram, coalesced) VALUES(";
+    queryStr << eventId << ", " << stored.runs << ", " << stored.failures << ", " << stored.timeouts << ", ";
+    queryStr << stored.lastDuration << ", " << stored.totalDuration << ", " << stored.maxDuration << ", \"" << stored.getHistogram() << "\", " << stored.coalesced << ");";
+    if (!database::exec(queryStr.str(), errorString)) {
+      logger::log(COMPONENT, LOG_ERROR, errorString);
+    }
+  }
+}
+
 /**
  * @function runScheduler
  * @description 'run' method executed by scheduler thread
@@ -508,44 +1212,301 @@ bool Scheduler::dumpScheduling(const std::string& filename /* = "" */) {
 
 int Scheduler::runScheduler() {
 
-  //Do not execute thread if no scheduled events is set
-  if (scheduledEvents.size() == 0) {
-    return 1;
-  }
-
+  std::chrono::steady_clock::time_point startTime = schedulerClock->now();
   time_t elapsedTime = 0; //Stores elapsed seconds since thread started
-  //Sort events by their 'absolute' timeout
-  std::sort(scheduledEvents.begin(), scheduledEvents.end(), sortByTimeout);
-  time_t nextEventTime = scheduledEvents.at(0)->getTimeout();
+  time_t lastFlushTime = 0;
+  //Scheduled events by next run
+  std::multimap<time_t, ScheduledEvent*> timeline;
+  buildTimeline(timeline, elapsedTime);
+  //Events suspended because their OID is idle
+  std::vector<ScheduledEvent*> suspendedEvents;
   //Stop called is set at scheduler destructor
   while (!stopCalled) {
-    //If elapsed time % nextEventTime == 0, exec command's id
-    if (elapsedTime != 0 && elapsedTime % nextEventTime == 0) {
-      //Execute commands for all events which satisfy previous condition
-      //That because there could be more than one event with same relative timeout
-      for (auto& event : scheduledEvents) {
-        //Check condition
-        if (elapsedTime % event->getTimeout() == 0) {
-          time_t tNow = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-          //If true execute event's commands
-          logger::log(COMPONENT, LOG_INFO, "Executing scheduling events for OID " + event->getOid());
-          event->executeCommands();
-          //Get elapsed time between before and after execution
-          time_t evElapsedTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() - tNow;
-          //Add to elapsed time event execution elapsed time
-          elapsedTime += evElapsedTime;
+    //Reload events if requested (SIGHUP)
+    if (reloadRequested) {
+      reloadRequested = 0;
+      if (reloadEvents()) {
+        buildTimeline(timeline, elapsedTime);
+        //Suspended events may have been retired; kept ones are suspended again at their next run
+        suspendedEvents.clear();
+      }
+    }
+    //Free retired events which are not used anymore
+    reapEvents();
+    //Identical commands of sharing events executed in this tick run once
+    CommandResults tickResults;
+    //Resume suspended events whose OID has been read meanwhile
+    for (std::vector<ScheduledEvent*>::iterator it = suspendedEvents.begin(); it != suspendedEvents.end() && !stopCalled;) {
+      ScheduledEvent* event = *it;
+      if (isIdle(event, startTime)) {
+        ++it;
+        continue;
+      }
+      it = suspendedEvents.erase(it);
+      event->admit(elapsedTime, false);
+      logger::log(COMPONENT, LOG_INFO, "OID " + event->getOid() + " has been read; resuming scheduling events");
+      event->executeCommands(&tickResults);
+    }
+    //Execute events whose run is due
+    bool executed = false;
+    while (!stopCalled && !timeline.empty() && timeline.begin()->first <= elapsedTime) {
+      ScheduledEvent* event = timeline.begin()->second;
+      timeline.erase(timeline.begin());
+      if (event->admit(elapsedTime, isIdle(event, startTime))) {
+        logger::log(COMPONENT, LOG_INFO, "Executing scheduling events for OID " + event->getOid());
+        event->executeCommands(&tickResults);
+      } else if (event->isSuspended() && std::find(suspendedEvents.begin(), suspendedEvents.end(), event) == suspendedEvents.end()) {
+        logger::log(COMPONENT, LOG_INFO, "OID " + event->getOid() + " is idle; suspending scheduling events");
+        suspendedEvents.push_back(event);
+      } else {
+        logger::log(COMPONENT, LOG_DEBUG, "Skipped scheduling events for OID " + event->getOid());
+      }
+      //Schedule next run after execution, skipping runs missed meanwhile
+      elapsedTime = std::chrono::duration_cast<std::chrono::seconds>(schedulerClock->now() - startTime).count();
+      if (event->schedule(elapsedTime, schedulerClock->wallTime()) >= 0) {
+        timeline.insert(std::make_pair(event->getNextRun(), event));
+      }
+      executed = true;
+    }
+    if (executed && !timeline.empty()) {
+      logger::log(COMPONENT, LOG_INFO, "Next scheduled event in " + std::to_string(timeline.begin()->first - elapsedTime) + " seconds");
+    }
+    //Persist execution metrics
+    if (elapsedTime - lastFlushTime >= METRICS_FLUSH_INTERVAL) {
+      flushMetrics();
+      lastFlushTime = elapsedTime;
+    }
+    //Sleep until next second
+    schedulerClock->sleepUntil(startTime + std::chrono::seconds(elapsedTime + 1));
+    elapsedTime = std::chrono::duration_cast<std::chrono::seconds>(schedulerClock->now() - startTime).count();
+  }
+
+  return 0;
+}
+
+/**
+ * @function buildTimeline
+ * @description sort scheduled events by their next run; events not scheduled yet are scheduled
+ * @param std::multimap<time_t, ScheduledEvent*>& timeline to fill
+ * @param time_t elapsed seconds since scheduler start
+**/
+
+void Scheduler::buildTimeline(std::multimap<time_t, ScheduledEvent*>& timeline, time_t elapsedTime) {
+
+  timeline.clear();
+  for (auto& event : scheduledEvents) {
+    //Events kept by a reload keep their next run
+    if (event->getNextRun() < 0 && event->schedule(elapsedTime, schedulerClock->wallTime()) < 0) {
+      logger::log(COMPONENT, LOG_WARN, "Scheduled event for OID " + event->getOid() + " is never going to run");
+      continue;
+    }
+    timeline.insert(std::make_pair(event->getNextRun(), event));
+  }
+}
+
+/**
+ * @function isIdle
+ * @description check whether the OID of a scheduled event hasn't been read within the event idle window
+ * @param ScheduledEvent* event
+ * @param time_point reads are tracked since then (scheduler start, by scheduler clock)
+ * @returns bool: true if OID is idle; false if the event has no idle window or the OID doesn't exist
+**/
+
+bool Scheduler::isIdle(ScheduledEvent* event, std::chrono::steady_clock::time_point since) {
+
+  if (event->getIdle() <= 0 || mibtable == nullptr) {
+    return false;
+  }
+  Oid* oid = mibtable->getOidByOid(event->getOid());
+  if (oid == nullptr) {
+    return false;
+  }
+  std::chrono::steady_clock::time_point lastRead = std::max(oid->getLastRead(), since);
+  return schedulerClock->now() - lastRead >= std::chrono::seconds(event->getIdle());
+}
+
+/**
+ * @function runInitEvents
+ * @description 'run' method executed by init thread; executes INIT events on a pool of workers,
+ * each event as soon as the INIT events of the OIDs it's after have completed
+ * @param std::vector<Event*> INIT events to execute (pinned)
+ * @returns int 0 when terminates
+ * NOTE: events in a dependency cycle are executed anyway once nothing else can run
+**/
+
+int Scheduler::runInitEvents(std::vector<Event*> initEvents) {
+
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  //Resolve dependencies
+  std::map<Event*, int> waitingFor;            //Event => amount of INIT events it's waiting for
+  std::multimap<Event*, Event*> dependents;    //Event => events waiting for it
+  for (auto& event : initEvents) {
+    waitingFor[event] = 0;
+    for (auto& afterOid : event->getAfter()) {
+      bool found = false;
+      for (auto& other : initEvents) {
+        if (other != event && other->getOid() == afterOid) {
+          dependents.insert(std::make_pair(other, event));
+          waitingFor[event]++;
+          found = true;
+        }
+      }
+      if (!found) {
+        logger::log(COMPONENT, LOG_WARN, "INIT event for OID " + event->getOid() + " is after OID " + afterOid + ", which has no INIT events");
+      }
+    }
+  }
+  std::deque<Event*> ready;
+  for (auto& event : initEvents) {
+    if (waitingFor[event] == 0) {
+      ready.push_back(event);
+    }
+  }
+
+  std::set<Event*> started;
+  int running = 0;
+  std::mutex poolMutex;
+  std::condition_variable poolCondition;
+  auto worker = [&]() {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (!stopCalled && started.size() < initEvents.size()) {
+      if (ready.empty()) {
+        if (running > 0) {
+          poolCondition.wait(lock);
+          continue;
+        }
+        //Nothing running and nothing ready: remaining events are in a dependency cycle
+        for (auto& event : initEvents) {
+          if (started.count(event) == 0) {
+            logger::log(COMPONENT, LOG_WARN, "INIT event for OID " + event->getOid() + " is in a dependency cycle; executing it anyway");
+            ready.push_back(event);
+          }
+        }
+        continue;
+      }
+      Event* event = ready.front();
+      ready.pop_front();
+      if (!started.insert(event).second) {
+        //Already queued when breaking a cycle
+        continue;
+      }
+      running++;
+      lock.unlock();
+      logger::log(COMPONENT, LOG_INFO, "Executing INIT events for OID " + event->getOid());
+      event->executeCommands();
+      //Value may have been initialized by the event
+      Oid* oid = mibtable != nullptr ? mibtable->getOidByOid(event->getOid()) : nullptr;
+      if (oid != nullptr) {
+        oid->reloadValue();
+      }
+      {
+        std::lock_guard<std::mutex> initLock(initMutex);
+        pendingInits.erase(pendingInits.find(event->getOid()));
+      }
+      lock.lock();
+      running--;
+      std::pair<std::multimap<Event*, Event*>::iterator, std::multimap<Event*, Event*>::iterator> waiting = dependents.equal_range(event);
+      for (std::multimap<Event*, Event*>::iterator it = waiting.first; it != waiting.second; ++it) {
+        if (--waitingFor[it->second] == 0 && started.count(it->second) == 0) {
+          ready.push_back(it->second);
         }
-        //Then calculate event relative timeout
-        event->calcRelativeTimeout(elapsedTime);
       }
-      std::sort(scheduledEvents.begin(), scheduledEvents.end(), sortByRelativeTimeout);
-      //Reset nextEventTime
-      nextEventTime = scheduledEvents.at(0)->getTimeout();
-      logger::log(COMPONENT, LOG_INFO, "Next scheduled event in " + std::to_string(nextEventTime) + " seconds");
+      poolCondition.notify_all();
+    }
+    //Wake up idle workers, since there is nothing left to do
+    poolCondition.notify_all();
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::min(initEvents.size(), static_cast<size_t>(INIT_WORKERS)); i++) {
+    workers.push_back(std::thread(worker));
+  }
+  for (auto& workerThread : workers) {
+    workerThread.join();
+  }
+  //Release events (including the ones skipped because of stop)
+  for (auto& event : initEvents) {
+    event->unpin();
+  }
+  {
+    std::lock_guard<std::mutex> lock(initMutex);
+    pendingInits.clear();
+  }
+  std::stringstream logS;
+  logS << "Executed " << started.size() << " INIT events in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() << " ms";
+  logger::log(COMPONENT, LOG_INFO, logS.str());
+  return 0;
+}
+
+/**
+ * @function isInitPending
+ * @description check whether INIT events of OID are still pending
+ * @param std::string oid
+ * @returns bool
+**/
+
+bool Scheduler::isInitPending(const std::string& oid) {
+  std::lock_guard<std::mutex> lock(initMutex);
+  return pendingInits.count(oid) > 0;
+}
+
+/**
+ * @function runDispatcher
+ * @description 'run' method executed by dispatcher thread; executes deferred events when due
+ * @returns int 0 when terminates
+**/
+
+int Scheduler::runDispatcher() {
+
+  std::unique_lock<std::mutex> lock(dispatchMutex);
+  //Stop called is set at scheduler destructor
+  while (!stopCalled) {
+    //Refreshes have priority, since requests may be waiting for them
+    if (!refreshQueue.empty()) {
+      Oid* oid = refreshQueue.front();
+      refreshQueue.pop_front();
+      lock.unlock();
+      refreshOid(oid);
+      lock.lock();
+      continue;
     }
-    //Sleep for one second
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    elapsedTime++;
+    if (deferredEvents.empty()) {
+      dispatchCondition.wait(lock);
+      continue;
+    }
+    std::multimap<std::chrono::steady_clock::time_point, Event*>::iterator nextEv = deferredEvents.begin();
+    if (nextEv->first > std::chrono::steady_clock::now()) {
+      dispatchCondition.wait_until(lock, nextEv->first);
+      continue;
+    }
+    Event* event = nextEv->second;
+    //Pin event before it leaves the queue, since it could have been retired by a reload
+    event->pin();
+    deferredEvents.erase(nextEv);
+    //Execute event outside the lock; the trigger goes through debounce again
+    lock.unlock();
+    std::string triggerOid;
+    std::string value = event->takePendingValue(triggerOid);
+    triggerEvent(event, value, triggerOid);
+    event->unpin();
+    lock.lock();
+  }
+
+  //Pending refreshes are dropped; nobody is going to read them
+  refreshQueue.clear();
+  refreshingOids.clear();
+  refreshCondition.notify_all();
+
+  //Flush deferred executions, so that the last values are processed anyway
+  while (!deferredEvents.empty()) {
+    Event* event = deferredEvents.begin()->second;
+    deferredEvents.erase(deferredEvents.begin());
+    lock.unlock();
+    logger::log(COMPONENT, LOG_INFO, "Executing deferred events for OID " + event->getOid());
+    std::string triggerOid;
+    std::string value = event->takePendingValue(triggerOid);
+    event->executeCommands(value, triggerOid);
+    lock.lock();
   }
 
   return 0;
@@ -553,37 +1514,55 @@ int Scheduler::runScheduler() {
 
 /**
  * @function addEvent
- * @description add event to database (and to event vector)
+ * @description add event to database (and to event vector); an existing event with the same OID and mode gets
+ * the commands appended and the options merged, and is reloaded by the running scheduler
  * @param std::string oid
  * @param EventMode mode
  * @param std::vector<std::string> command list
+ * @param std::string& error string pointer
  * @param int optional timeout (for scheduled event)
+ * @param EventOptions optional event options
  * @returns bool: true if add successfully
 **/
 
-bool Scheduler::addEvent(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, int timeout /*= 0*/) {
+bool Scheduler::addEvent(const std::string& oid, EventMode mode, const std::vector<std::string>& commandList, std::string& error, int timeout /*= 0*/, const EventOptions& options /* = EventOptions() */) {
 
-  //Try to open database
-  std::string errorString;
   //Check if event doesn't already exist
   std::stringstream queryStr;
   Event* dummyEv = new Event(oid, mode, commandList);
-  queryStr << "SELECT event_id FROM scheduled_events WHERE oid = \"" << oid << "\" AND mode = \"" << dummyEv->getModeName() << "\";";
+  queryStr << "SELECT event_id, timeout FROM scheduled_events WHERE oid = \"" << oid << "\" AND mode = \"" << dummyEv->getModeName() << "\";";
   delete dummyEv;
   std::vector<std::vector<std::string>> result;
-  if (!database::select(&result, queryStr.str(), errorString)) {
-    logger::log(COMPONENT, LOG_ERROR, errorString);
+  if (!database::select(&result, queryStr.str(), error)) {
     return false;
   }
   //Get eventId if result.size > 0
   if (result.size() > 0) {
     //@! Event already exists
     int eventId = std::stoi(result.at(0).at(0));
+    int storedTimeout = std::stoi(result.at(0).at(1));
+    //Options are merged into the stored ones; check the resulting event
+    queryStr.str(std::string());
+    queryStr << "SELECT name, value FROM events_options WHERE event_id = " << eventId << ";";
+    result.clear();
+    if (!database::select(&result, queryStr.str(), error)) {
+      return false;
+    }
+    EventOptions mergedOptions;
+    for (auto& row : result) {
+      mergedOptions[row.at(0)] = row.at(1);
+    }
+    for (auto& option : options) {
+      mergedOptions[option.first] = option.second;
+    }
+    if (!checkOptions(oid, mode, commandList, storedTimeout, mergedOptions, error)) {
+      return false;
+    }
     queryStr.str(std::string());
     queryStr << "SELECT execution_order FROM events_commands WHERE event_id = " << eventId << " ORDER BY execution_order DESC LIMIT 1;";
     result.clear();
-    if (!database::select(&result, queryStr.str(), errorString)) {
-      logger::log(COMPONENT, LOG_ERROR, errorString);
+    if (!database::select(&result, queryStr.str(), error)) {
+      return false;
     }
     //Get execution order
     int executionOrder = 0;
@@ -598,53 +1577,77 @@ bool Scheduler::addEvent(const std::string& oid, EventMode mode, const std::vect
       cmdQueryStr << ++executionOrder << ", ";
       cmdQueryStr << eventId << ");";
       std::string query = cmdQueryStr.str();
-      if (!database::exec(query, errorString)) {
+      if (!database::exec(query, error)) {
         //Database query failed
-        logger::log(COMPONENT, LOG_ERROR, errorString);
         return false;
       }
     }
+    //Update options
+    if (!addEventOptions(std::to_string(eventId), options, error)) {
+      return false;
+    }
+    //The loaded event is outdated; the scheduler thread replaces it with the stored one
+    requestReload();
+    return true;
   } else {
     //@!New event
-
-    //Event id is the ID the event will take into the database
-    //We know it because it's an auto incremented key
-    //It's the total amount of events + 1
-    int nextEventId = scheduledEvents.size() + events.size() + 1;
+    Event* addedEv;
 
     //Instance and create new event
     if (mode == EventMode::AUTO) {
       ScheduledEvent* newEv = new ScheduledEvent(oid, mode, commandList, timeout);
+      if (!applyOptions(newEv, options, error)) {
+        delete newEv;
+        return false;
+      }
       std::stringstream evQueryStr;
       evQueryStr << "INSERT INTO scheduled_events(mode, timeout, oid) VALUES (\"";
       evQueryStr << newEv->getModeName() << "\",";
       evQueryStr << newEv->getTimeout() << ",\"";
       evQueryStr << newEv->getOid() << "\");";
       std::string query = evQueryStr.str();
-      if (!database::exec(query, errorString)) {
+      if (!database::exec(query, error)) {
         //Database query failed
-        logger::log(COMPONENT, LOG_ERROR, errorString);
         delete newEv;
         return false;
       }
       //Add event to scheduled events vector
       scheduledEvents.push_back(newEv);
+      addedEv = newEv;
     } else {
       Event* newEv = new Event(oid, mode, commandList);
+      if (!applyOptions(newEv, options, error)) {
+        delete newEv;
+        return false;
+      }
       std::stringstream evQueryStr;
       evQueryStr << "INSERT INTO scheduled_events(mode, oid) VALUES (\"";
       evQueryStr << newEv->getModeName() << "\",\"";
       evQueryStr << newEv->getOid() << "\");";
       std::string query = evQueryStr.str();
-      if (!database::exec(query, errorString)) {
+      if (!database::exec(query, error)) {
         //Database query failed
-        logger::log(COMPONENT, LOG_ERROR, errorString);
         delete newEv;
         return false;
       }
       //Add event to scheduled vector
       events.push_back(newEv);
+      bindEvent(newEv);
+      addedEv = newEv;
+    }
+    //Get the ID the event took into the database
+    queryStr.str(std::string());
+    queryStr << "SELECT MAX(event_id) FROM scheduled_events;";
+    result.clear();
+    if (!database::select(&result, queryStr.str(), error)) {
+      return false;
+    }
+    if (result.size() == 0) {
+      error = "Could not get the id of the new event";
+      return false;
     }
+    int nextEventId = std::stoi(result.at(0).at(0));
+    addedEv->setId(nextEventId);
     //Add commands to database
     int executionOrder = 0;
     for (auto& cmd : commandList) {
@@ -654,13 +1657,123 @@ bool Scheduler::addEvent(const std::string& oid, EventMode mode, const std::vect
       cmdQueryStr << ++executionOrder << ", ";
       cmdQueryStr << nextEventId << ");";
       std::string query = cmdQueryStr.str();
-      if (!database::exec(query, errorString)) {
+      if (!database::exec(query, error)) {
         //Database query failed
-        logger::log(COMPONENT, LOG_ERROR, errorString);
         return false;
       }
     }
+    //Add options to database
+    return addEventOptions(std::to_string(nextEventId), options, error);
   }
 
   return true;
 }
+
+/**
+ * @function addEventOptions
+ * @description save event options to database; existing options with the same name are replaced
+ * @param std::string event id
+ * @param EventOptions options to save
+ * @param std::string& error string pointer
+ * @returns bool: true if saved successfully
+**/
+
+bool Scheduler::addEventOptions(const std::string& eventId, const EventOptions& options, std::string& error) {
+
+  for (auto& option : options) {
+    std::stringstream optQueryStr;
+    optQueryStr << "DELETE FROM events_options WHERE event_id = " << eventId << " AND name = \"" << option.first << "\";";
+    optQueryStr << "INSERT INTO events_options(name, value, event_id) VALUES(\"";
+    optQueryStr << option.first << "\", \"";
+    optQueryStr << option.second << "\", ";
+    optQueryStr << eventId << ");";
+    if (!database::exec(optQueryStr.str(), error)) {
+      //Database query failed
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @function loadEventOptions
+ * @description load event options from database and apply them to event
+ * @param Event* event
+ * @param std::string event id
+ * @returns bool: true if database query succeeded
+ * NOTE: invalid options are discarded
+**/
+
+bool Scheduler::loadEventOptions(Event* event, const std::string& eventId) {
+
+  std::string errorString;
+  std::vector<std::vector<std::string>> optionRows;
+  std::string query = "SELECT name, value FROM events_options WHERE event_id = \"" + eventId + "\";";
+  if (!database::select(&optionRows, query, errorString)) {
+    logger::log(COMPONENT, LOG_ERROR, errorString);
+    return false;
+  }
+  for (auto& row : optionRows) {
+    if (row.size() != 2) {
+      continue;
+    }
+    if (!event->setOption(row.at(0), row.at(1), errorString)) {
+      std::stringstream logS;
+      logS << "Event_id " << eventId << ": " << errorString;
+      logger::log(COMPONENT, LOG_WARN, logS.str());
+    }
+  }
+  return true;
+}
+
+/**
+ * @function bindEvent
+ * @description attach event to the OID it is associated to, in order to dispatch it by OID
+ * @param Event* event to bind
+ * NOTE: subtree events are indexed by OID prefix instead
+**/
+
+void Scheduler::bindEvent(Event* event) {
+
+  if (mibtable == nullptr) {
+    return;
+  }
+  if (event->isSubtree()) {
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    subtreeEvents[oidKey(event->getOid())].push_back(event);
+    return;
+  }
+  Oid* assocOid = mibtable->getOidByOid(event->getOid());
+  if (assocOid == nullptr) {
+    logger::log(COMPONENT, LOG_WARN, "Event associated to unknown OID " + event->getOid());
+    return;
+  }
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  assocOid->attachEvent(event);
+}
+
+/**
+ * @function unbindEvent
+ * @description detach event from its OID (or from the subtree index)
+ * @param Event* event to unbind
+**/
+
+void Scheduler::unbindEvent(Event* event) {
+
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  if (event->isSubtree()) {
+    std::unordered_map<uint64_t, std::vector<Event*>>::iterator prefixEvents = subtreeEvents.find(oidKey(event->getOid()));
+    if (prefixEvents != subtreeEvents.end()) {
+      std::vector<Event*>& eventList = prefixEvents->second;
+      eventList.erase(std::remove(eventList.begin(), eventList.end(), event), eventList.end());
+      if (eventList.empty()) {
+        subtreeEvents.erase(prefixEvents);
+      }
+    }
+    return;
+  }
+  Oid* assocOid = mibtable != nullptr ? mibtable->getOidByOid(event->getOid()) : nullptr;
+  if (assocOid != nullptr) {
+    assocOid->detachEvent(event);
+  }
+}
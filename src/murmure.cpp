@@ -22,27 +22,75 @@
 **/
 
 #include <core/murmure.hpp>
+#include <core/passpersist.hpp>
+#include <utils/unixsocket.hpp>
+
+#include <cerrno>
+#include <poll.h>
+#include <thread>
+#include <unistd.h>
 
 using namespace murmure;
 
+//Requests for nonexistent OIDs come in floods (scanners, misconfigured managers); don't log each of them
+static logger::RateLimit noSuchNameLog(COMPONENT, LOG_WARN, NO_SUCH_NAME_LOG_BURST, NO_SUCH_NAME_LOG_INTERVAL);
+
+/**
+ * @function onReloadSignal
+ * @description SIGHUP handler; requests the scheduler to reload events from database
+ * @param int signal number
+**/
+
+void onReloadSignal(int signum) {
+  Scheduler::requestReload();
+}
+
+/**
+ * @function appendVarbind
+ * @description Append OID, type and value lines to response
+ * @param std::string&: response
+ * @param Oid*: OID to output
+**/
+
+inline void appendVarbind(std::string& response, Oid* oid) {
+  response += oid->getOid();
+  response += '\n';
+  response += oid->getPrimitiveType();
+  response += '\n';
+  response += oid->getPrintableValue();
+  response += '\n';
+}
+
+/**
+ * @function onStopSignal
+ * @description SIGTERM/SIGINT handler in AgentX and SNMP agent modes; terminates the agent
+ * @param int signal number
+**/
+
+void onStopSignal(int signum) {
+  agentx::Subagent::requestStop();
+  snmp::Agent::requestStop();
+}
+
 /**
  * @function snmp_get
- * @description Issue GET request and print output
+ * @description Issue GET request and append output to response
  * @param Mibtable*: pointer to MIB-table
  * @param Scheduler*: pointer to scheduler
  * @param std::string: requested OID to get
+ * @param std::string&: response output lines are appended to
 **/
 
-inline void snmp_get(Mibtable* mibtab, Scheduler* mibScheduler, const std::string& requestedOid) {
+inline void snmp_get(Mibtable* mibtab, Scheduler* mibScheduler, const std::string& requestedOid, std::string& response) {
 
   //Try to get OID from mibtable
   Oid* reqOid = mibtab->getOidByOid(requestedOid);
   if (reqOid == nullptr) {
-    std::stringstream ss;
-    ss << "OID " << requestedOid << " does not exist";
-    logger::log(COMPONENT, LOG_WARN, ss.str());
+    if (noSuchNameLog.admit()) {
+      logger::log(COMPONENT, LOG_WARN, "OID " + requestedOid + " does not exist");
+    }
     //Output no-such-name
-    std::cout << "no-such-name" << std::endl;
+    response += "no-such-name\n";
     return;
   }
 
@@ -52,81 +100,137 @@ inline void snmp_get(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
     ss << "OID " << requestedOid << " is NOT-ACCESSIBLE";
     logger::log(COMPONENT, LOG_WARN, ss.str());
     //Output no-access
-    std::cout << "no-access" << std::endl;
+    response += "no-access\n";
     return;
   }
 
-  //Exec GET commands
-  mibScheduler->fetchAndExec(requestedOid, EventMode::GET);
+  //Exec GET commands (according to OID freshness policy)
+  mibScheduler->refresh(reqOid);
 
   //Else output OID, type, value
-  std::cout << reqOid->getOid() << std::endl;
-  std::cout << reqOid->getPrimitiveType() << std::endl;
-  std::cout << reqOid->getPrintableValue() << std::endl;
+  appendVarbind(response, reqOid);
 
   return;
 }
 
+/**
+ * @function isAccessible
+ * @description returns whether oid can be returned by GETNEXT/GETBULK
+ * @param Oid*
+ * @returns bool
+**/
+
+static bool isAccessible(Oid* oid) {
+  return oid->getAccessMode() != AccessMode::NOT_ACCESSIBLE;
+}
+
 /**
  * @function snmp_getnext
- * @description Issue GETNEXT request and print output
+ * @description Issue GETNEXT request and append output to response
  * @param Mibtable*: pointer to MIB-table
  * @param Scheduler*: pointer to scheduler
  * @param std::string: requested OID to get
+ * @param walkCursor&: walk cursor of the client; a walk continues from the last returned OID without searching it
+ * @param std::string&: response output lines are appended to
 **/
 
-inline void snmp_getnext(Mibtable* mibtab, Scheduler* mibScheduler, const std::string& requestedOid) {
+inline void snmp_getnext(Mibtable* mibtab, Scheduler* mibScheduler, const std::string& requestedOid, walkCursor& cursor, std::string& response) {
 
-  //Get nextOid
-  std::string nextOid = requestedOid;
-  bool oidFound = false;
-  do {
-    nextOid = mibtab->getNextOid(nextOid);
-    if (nextOid == "") {
-      //Output no-such-name
-      std::cout << "no-such-name" << std::endl;
-      break;
-    }
-    Oid* assocOid = mibtab->getOidByOid(nextOid);
-    //Get on next oid
-    if (assocOid == nullptr) {
-      std::stringstream ss;
-      ss << "OID " << requestedOid << " does not exist";
-      logger::log(COMPONENT, LOG_WARN, ss.str());
-      //Output no-such-name
-      std::cout << "no-such-name" << std::endl;
-      return;
-    }
+  //Get next accessible OID
+  Oid* nextOid = mibtab->getNext(requestedOid, cursor, isAccessible);
+  if (nextOid == nullptr) {
+    //Output no-such-name
+    response += "no-such-name\n";
+    return;
+  }
 
-    //Check access mode
-    if (assocOid->getAccessMode() == AccessMode::NOT_ACCESSIBLE) {
-      oidFound = false;
-      continue;
-    }
+  //Exec GET commands of the OID which is returned
+  mibScheduler->refresh(nextOid);
+
+  //Else output OID, type, value
+  appendVarbind(response, nextOid);
+}
 
-    oidFound = true;
-    //Exec GET commands
-    mibScheduler->fetchAndExec(requestedOid, EventMode::GET);
+/**
+ * @function isInSubtree
+ * @description returns whether oid is rootOid or one of its descendants
+ * @param std::string oid
+ * @param std::string rootOid
+ * @returns bool
+**/
 
-    //Else output OID, type, value
-    std::cout << assocOid->getOid() << std::endl;
-    std::cout << assocOid->getPrimitiveType() << std::endl;
-    std::cout << assocOid->getPrintableValue() << std::endl;
-  } while (!oidFound);
-  return;
+static bool isInSubtree(const std::string& oid, const std::string& rootOid) {
+  return oid.compare(0, rootOid.length(), rootOid) == 0 && (oid.length() == rootOid.length() || oid[rootOid.length()] == '.');
+}
+
+/**
+ * @function snmp_getbulk
+ * @description Issue GETBULK request: append up to maxRepetitions accessible OIDs following requested one,
+ * collected in a single table scan, and an END line
+ * @param Mibtable*: pointer to MIB-table
+ * @param Scheduler*: pointer to scheduler
+ * @param std::string: requested OID; it doesn't need to exist
+ * @param size_t: max amount of OIDs to return
+ * @param std::vector<Oid*>&: buffer for the collected OIDs
+ * @param std::string&: response output lines are appended to
+**/
+
+inline void snmp_getbulk(Mibtable* mibtab, Scheduler* mibScheduler, const std::string& requestedOid, size_t maxRepetitions, std::vector<Oid*>& successors, std::string& response) {
+
+  mibtab->getSuccessors(requestedOid, maxRepetitions, successors, isAccessible);
+  for (auto& oid : successors) {
+    //Exec GET commands of each OID which is returned
+    mibScheduler->refresh(oid);
+    appendVarbind(response, oid);
+  }
+  response += "END\n";
+}
+
+/**
+ * @function snmp_walk
+ * @description Append rootOid, if accessible, and all the accessible OIDs beneath it, collected WALK_BULK_SIZE at a time
+ * @param Mibtable*: pointer to MIB-table
+ * @param Scheduler*: pointer to scheduler
+ * @param std::string: subtree root OID
+ * @param std::string&: response output lines are appended to
+**/
+
+inline void snmp_walk(Mibtable* mibtab, Scheduler* mibScheduler, const std::string& rootOid, std::string& response) {
+
+  Oid* root = mibtab->getOidByOid(rootOid);
+  if (root != nullptr && isAccessible(root)) {
+    mibScheduler->refresh(root);
+    appendVarbind(response, root);
+  }
+  std::vector<Oid*> successors;
+  std::string cursor = rootOid;
+  do {
+    mibtab->getSuccessors(cursor, WALK_BULK_SIZE, successors, isAccessible);
+    for (auto& oid : successors) {
+      if (!isInSubtree(oid->getOid(), rootOid)) {
+        return;
+      }
+      mibScheduler->refresh(oid);
+      appendVarbind(response, oid);
+    }
+    if (!successors.empty()) {
+      cursor = successors.back()->getOid();
+    }
+  } while (successors.size() == WALK_BULK_SIZE);
 }
 
 /**
  * @function snmp_set
- * @description Issue SET request and print output
+ * @description Issue SET request and append output to response
  * @param Mibtable*: pointer to MIB-table
  * @param Scheduler*: pointer to scheduler
  * @param std::string: requested OID to get
  * @param std::string: string data type
  * @param std::string: printable value to set
+ * @param std::string&: response output lines are appended to
 **/
 
-inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::string requestedOid, const std::string& datatype, const std::string& value) {
+inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::string requestedOid, const std::string& datatype, const std::string& value, std::string& response) {
 
   //Try to get OID from mibtable
   Oid* reqOid = mibtab->getOidByOid(requestedOid);
@@ -139,11 +243,11 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
       parentOidStr = requestedOid.substr(0, lastDotPos);
     } else {
       //@! Is not a valid OID
-      std::stringstream ss;
-      ss << "OID " << requestedOid << " does not exist";
-      logger::log(COMPONENT, LOG_WARN, ss.str());
+      if (noSuchNameLog.admit()) {
+        logger::log(COMPONENT, LOG_WARN, "OID " + requestedOid + " does not exist");
+      }
       //Output no-such-name
-      std::cout << "no-such-name" << std::endl;
+      response += "no-such-name\n";
       return;
     }
     if (mibtab->isTableChild(parentOidStr)) {
@@ -155,7 +259,7 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
         ss << "OID " << parentOid << " is not at least READCREATE";
         logger::log(COMPONENT, LOG_WARN, ss.str());
         //Output read-only
-        std::cout << "read-only" << std::endl;
+        response += "read-only\n";
         return;
       }
       //Access mode is OK
@@ -164,13 +268,9 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
       if (mibtab->addOid(childOid)) {
         //@! Table element added Successfully
         //if added successfully output OID, type, value
-        std::cout << childOid->getOid() << std::endl;
-        std::cout << childOid->getPrimitiveType() << std::endl;
-        std::cout << childOid->getPrintableValue() << std::endl;
-        //Export value to env
-        setenv("SNMP_VALUE", value.c_str(), 1);
-        //Exec SET commands for parent OID
-        mibScheduler->fetchAndExec(parentOidStr, EventMode::SET);
+        appendVarbind(response, childOid);
+        //Exec SET commands for parent OID; value is exported as SNMP_VALUE, new OID as SNMP_OID
+        mibScheduler->fetchAndExec(parentOid, EventMode::SET, value, childOid->getOid());
         return;
       } else {
         //Commit failed
@@ -178,16 +278,16 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
         ss << "Unable to set value for OID " << requestedOid;
         logger::log(COMPONENT, LOG_ERROR, ss.str());
         //Output read-only
-        std::cout << "commit-failed" << std::endl;
+        response += "commit-failed\n";
         return;
       }
     } else {
       //@! OID exists but it is not table
-      std::stringstream ss;
-      ss << "OID " << requestedOid << " does not exist";
-      logger::log(COMPONENT, LOG_WARN, ss.str());
+      if (noSuchNameLog.admit()) {
+        logger::log(COMPONENT, LOG_WARN, "OID " + requestedOid + " does not exist");
+      }
       //Output no-such-name
-      std::cout << "no-such-name" << std::endl;
+      response += "no-such-name\n";
       return;
     }
   }
@@ -199,7 +299,7 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
     ss << "OID " << requestedOid << " is not READWRITE";
     logger::log(COMPONENT, LOG_WARN, ss.str());
     //Output read-only
-    std::cout << "read-only" << std::endl;
+    response += "read-only\n";
     return;
   }
 
@@ -210,7 +310,7 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
     ss << "Wrong type for OID " << requestedOid << "; expected " << expectedType << " got " << datatype;
     logger::log(COMPONENT, LOG_WARN, ss.str());
     //Output read-only
-    std::cout << "wrong-type" << std::endl;
+    response += "wrong-type\n";
     return;
   }
 
@@ -220,22 +320,423 @@ inline void snmp_set(Mibtable* mibtab, Scheduler* mibScheduler, const std::strin
     ss << "Unable to set value for OID " << requestedOid;
     logger::log(COMPONENT, LOG_ERROR, ss.str());
     //Output read-only
-    std::cout << "commit-failed" << std::endl;
+    response += "commit-failed\n";
     return;
   }
 
-  //Export value to env
-  setenv("SNMP_VALUE", value.c_str(), 1);
-  //Exec SET commands
-  mibScheduler->fetchAndExec(requestedOid, EventMode::SET);
+  //Exec SET commands; value is exported as SNMP_VALUE
+  mibScheduler->fetchAndExec(reqOid, EventMode::SET, value);
 
   //Else output OID, type, value
-  std::cout << reqOid->getOid() << std::endl;
-  std::cout << reqOid->getPrimitiveType() << std::endl;
-  std::cout << reqOid->getPrintableValue() << std::endl;
+  appendVarbind(response, reqOid);
   return;
 }
 
+//Buffers reused across requests
+typedef struct {
+  std::string requestedOid;
+  std::string datatype;
+  std::string value;
+  std::vector<Oid*> successors;
+  walkCursor cursor;
+} requestBuffers;
+
+/**
+ * @function serveRequest
+ * @description Read a pass_persist request, execute it and write its response
+ * @param PassPersist&: request channel
+ * @param requestBuffers&: buffers reused across requests
+ * @param Mibtable*: pointer to MIB-table
+ * @param Scheduler*: pointer to scheduler
+ * @returns bool: false if channel has terminated (closed or empty line)
+**/
+
+static bool serveRequest(PassPersist& channel, requestBuffers& buffers, Mibtable* mibtab, Scheduler* mibScheduler) {
+
+  LineView command;
+  LineView line;
+  std::string& response = channel.getResponse();
+  if (!channel.readLine(command) || command.empty()) { //Terminate
+    return false;
+  } else if (command.equals("PING")) {
+    //Output PONG (part of the "secret" net-snmp handshaking)
+    response += "PONG\n";
+  } else if (command.equals("stats")) {
+    //Counters for tuning, one per line, followed by END
+    uint64_t cursorHits;
+    uint64_t cursorMisses;
+    mibtab->getCursorStats(cursorHits, cursorMisses);
+    response += "walk-cursor-hits " + std::to_string(cursorHits) + "\n";
+    response += "walk-cursor-misses " + std::to_string(cursorMisses) + "\n";
+    uint64_t ingestRecords;
+    uint64_t ingestApplied;
+    uint64_t ingestUnknown;
+    uint64_t ingestInvalid;
+    uint64_t ingestDropped;
+    ingest::Consumer::getStats(ingestRecords, ingestApplied, ingestUnknown, ingestInvalid, ingestDropped);
+    response += "ingest-records " + std::to_string(ingestRecords) + "\n";
+    response += "ingest-applied " + std::to_string(ingestApplied) + "\n";
+    response += "ingest-unknown " + std::to_string(ingestUnknown) + "\n";
+    response += "ingest-invalid " + std::to_string(ingestInvalid) + "\n";
+    response += "ingest-dropped " + std::to_string(ingestDropped) + "\n";
+    response += "END\n";
+  } else if (command.equals("get")) {
+    //Read requested OID
+    if (!channel.readLine(line)) {
+      return false;
+    }
+    line.copyTo(buffers.requestedOid);
+    logger::log(COMPONENT, LOG_INFO, "Received GET for OID " + buffers.requestedOid);
+    snmp_get(mibtab, mibScheduler, buffers.requestedOid, response);
+  } else if (command.equals("getnext")) {
+    if (!channel.readLine(line)) {
+      return false;
+    }
+    line.copyTo(buffers.requestedOid);
+    logger::log(COMPONENT, LOG_INFO, "Received GETNEXT for OID " + buffers.requestedOid);
+    snmp_getnext(mibtab, mibScheduler, buffers.requestedOid, buffers.cursor, response);
+  } else if (command.equals("getbulk")) {
+    //Two lines; first is OID, second is max repetitions
+    if (!channel.readLine(line)) {
+      return false;
+    }
+    line.copyTo(buffers.requestedOid);
+    if (!channel.readLine(line)) {
+      return false;
+    }
+    line.copyTo(buffers.value);
+    size_t maxRepetitions = 0;
+    try {
+      maxRepetitions = std::stoul(buffers.value);
+    } catch (std::exception& ex) {
+      //An empty response is returned, so that client doesn't wait
+      logger::log(COMPONENT, LOG_ERROR, "Invalid GETBULK max repetitions '" + buffers.value + "'");
+    }
+    std::stringstream bulkStream;
+    bulkStream << "Received GETBULK for OID " << buffers.requestedOid << "; Max repetitions: " << maxRepetitions;
+    logger::log(COMPONENT, LOG_INFO, bulkStream.str());
+    snmp_getbulk(mibtab, mibScheduler, buffers.requestedOid, maxRepetitions, buffers.successors, response);
+  } else if (command.equals("set")) {
+    //Two lines; first is OID, second is: 'datatype' 'value'
+    if (!channel.readLine(line)) {
+      return false;
+    }
+    line.copyTo(buffers.requestedOid);
+    //Get params
+    if (!channel.readLine(line)) {
+      return false;
+    }
+    //Split params into two tokens
+    size_t sepPos = line.find(' ');
+    if (sepPos == std::string::npos) {
+      logger::log(COMPONENT, LOG_ERROR, "Invalid SET parameters for OID " + buffers.requestedOid);
+      //Reply anyway, so that client doesn't wait
+      response += "wrong-type\n";
+    } else {
+      buffers.datatype.assign(line.data, sepPos);
+      buffers.value.assign(line.data + sepPos + 1, line.length - sepPos - 1);
+      //Convert datatype to upper case - just to be sure
+      std::transform(buffers.datatype.begin(), buffers.datatype.end(), buffers.datatype.begin(), ::toupper);
+      std::stringstream setStream;
+      setStream << "Received SET for OID " << buffers.requestedOid << "; Type: " << buffers.datatype << "; Value: " << buffers.value;
+      logger::log(COMPONENT, LOG_INFO, setStream.str());
+      snmp_set(mibtab, mibScheduler, buffers.requestedOid, buffers.datatype, buffers.value, response);
+    }
+  }
+  //Write the complete response at once
+  return response.empty() || channel.flush();
+}
+
+/**
+ * @function serveSocket
+ * @description Daemon socket worker: serves pass_persist requests of each connection, until it's closed;
+ * workers accept connections from the same socket, so clients are served concurrently
+ * @param int: listening socket
+ * @param Mibtable*: pointer to MIB-table
+ * @param Scheduler*: pointer to scheduler
+**/
+
+static void serveSocket(int listenFd, Mibtable* mibtab, Scheduler* mibScheduler) {
+
+  requestBuffers buffers;
+  int clientFd;
+  while ((clientFd = unixsocket::accept(listenFd)) >= 0) {
+    PassPersist channel(clientFd, clientFd);
+    //Each connection walks on its own
+    buffers.cursor = walkCursor();
+    while (serveRequest(channel, buffers, mibtab, mibScheduler)) {
+    }
+    close(clientFd);
+  }
+}
+
+/**
+ * @function forwardRequest
+ * @description Forward a pass_persist request to a running daemon and print its response
+ * @param std::string: daemon socket path
+ * @param std::string: request lines
+ * @param bool&: set to true if request has been sent to the daemon
+ * @returns bool: true if the response has been received
+**/
+
+static bool forwardRequest(const std::string& socketPath, const std::string& request, bool& sent) {
+
+  sent = false;
+  std::string error;
+  int sockFd = unixsocket::connect(socketPath, error);
+  if (sockFd < 0) {
+    //No daemon running
+    return false;
+  }
+  //Empty line terminates the connection after the request
+  PassPersist channel(sockFd, sockFd);
+  channel.getResponse() = request + "\n";
+  sent = channel.flush();
+  std::string response;
+  LineView line;
+  while (sent && channel.readLine(line)) {
+    response.append(line.data, line.length);
+    response += '\n';
+  }
+  close(sockFd);
+  if (response.empty()) {
+    return false;
+  }
+  std::cout << response;
+  return true;
+}
+
+/**
+ * @function forwardWalk
+ * @description Walk a subtree on a running daemon and print rootOid, if accessible, and the OIDs beneath it;
+ * root is requested with GET, the others with GETBULK
+ * @param std::string: daemon socket path
+ * @param std::string: subtree root OID
+ * @param bool&: set to true if a request has been sent to the daemon
+ * @returns bool: true if the walk has been completed
+**/
+
+static bool forwardWalk(const std::string& socketPath, const std::string& rootOid, bool& sent) {
+
+  sent = false;
+  std::string error;
+  int sockFd = unixsocket::connect(socketPath, error);
+  if (sockFd < 0) {
+    //No daemon running
+    return false;
+  }
+  PassPersist channel(sockFd, sockFd);
+  std::string cursor = rootOid;
+  std::string oid;
+  std::string output;
+  //Root response is either OID, type and value lines or an error line
+  LineView line;
+  channel.getResponse() = "get\n" + rootOid + "\n";
+  if (!channel.flush() || !channel.readLine(line)) {
+    close(sockFd);
+    return false;
+  }
+  sent = true;
+  if (line.length > 0 && line.data[0] == '.') {
+    output.append(line.data, line.length);
+    output += '\n';
+    for (int i = 0; i < 2 && channel.readLine(line); i++) {
+      output.append(line.data, line.length);
+      output += '\n';
+    }
+    std::cout << output;
+  }
+  bool completed = false;
+  while (!completed) {
+    channel.getResponse() = "getbulk\n" + cursor + "\n" + std::to_string(WALK_BULK_SIZE) + "\n";
+    if (!channel.flush()) {
+      break;
+    }
+    //Response is OID, type and value lines for each OID, followed by END
+    size_t received = 0;
+    bool ended = false;
+    output.clear();
+    while (channel.readLine(line)) {
+      if (line.equals("END")) {
+        ended = true;
+        break;
+      }
+      line.copyTo(oid);
+      received++;
+      bool inSubtree = !completed && isInSubtree(oid, rootOid);
+      completed = completed || !inSubtree;
+      if (inSubtree) {
+        output += oid;
+        output += '\n';
+        cursor = oid;
+      }
+      for (int i = 0; i < 2 && channel.readLine(line); i++) {
+        if (inSubtree) {
+          output.append(line.data, line.length);
+          output += '\n';
+        }
+      }
+    }
+    std::cout << output;
+    if (!ended) {
+      break;
+    }
+    completed = completed || received < WALK_BULK_SIZE;
+  }
+  //Empty line terminates the connection
+  channel.getResponse() = "\n";
+  channel.flush();
+  close(sockFd);
+  return completed;
+}
+
+//Transaction batch changes are written in
+typedef struct {
+  bool open;
+  bool failed; //Some changes could not be committed
+  std::chrono::steady_clock::time_point since;
+} batchTransaction;
+
+/**
+ * @function beginBatchWrites
+ * @description open the batch transaction, if not open yet; changes are written without it if it can't be opened
+ * @param batchTransaction&
+**/
+
+static void beginBatchWrites(batchTransaction& transaction) {
+
+  if (transaction.open) {
+    return;
+  }
+  std::string dbError;
+  if (!database::begin(dbError)) {
+    logger::log(COMPONENT, LOG_ERROR, "Could not begin batch transaction: " + dbError);
+    return;
+  }
+  transaction.open = true;
+  transaction.since = std::chrono::steady_clock::now();
+}
+
+/**
+ * @function commitBatchWrites
+ * @description commit the batch transaction, if open
+ * @param batchTransaction&
+**/
+
+static void commitBatchWrites(batchTransaction& transaction) {
+
+  if (!transaction.open) {
+    return;
+  }
+  transaction.open = false;
+  std::string dbError;
+  if (!database::commit(dbError)) {
+    logger::log(COMPONENT, LOG_ERROR, "Could not commit batch transaction: " + dbError);
+    transaction.failed = true;
+  }
+}
+
+/**
+ * @function awaitBatchInput
+ * @description wait for batch input on stdin; commit the batch transaction if none arrives before its commit interval expires
+ * @param batchTransaction&
+**/
+
+static void awaitBatchInput(batchTransaction& transaction) {
+
+  std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - transaction.since);
+  long long remaining = BATCH_COMMIT_INTERVAL - elapsed.count();
+  int timeout = remaining > 0 ? static_cast<int>(remaining) : 0;
+  struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+  int ready;
+  do {
+    ready = poll(&pfd, 1, timeout);
+  } while (ready < 0 && errno == EINTR);
+  if (ready == 0) {
+    commitBatchWrites(transaction);
+  }
+}
+
+/**
+ * @function serveBatchLine
+ * @description Execute a batch line ('get <oid>', 'getnext <oid>', 'set <oid> <type> <value>' or 'change <oid> <value>')
+ * and append its output to response, as the equivalent one-shot command would print it
+ * @param std::string: batch line
+ * @param Mibtable*: pointer to MIB-table
+ * @param Scheduler*: pointer to scheduler
+ * @param walkCursor&: walk cursor of the batch
+ * @param batchTransaction&: transaction changes are written in
+ * @param std::string&: response output lines are appended to
+ * @returns bool: false if line is not a valid request
+ * NOTE: event commands may write the database as well (e.g. murmure -C), so the transaction
+ * is committed before any request which may execute events
+**/
+
+static bool serveBatchLine(const std::string& line, Mibtable* mibtab, Scheduler* mibScheduler, walkCursor& cursor, batchTransaction& transaction, std::string& response) {
+
+  //Command and OID are separated by a space; set/change parameters follow another one
+  size_t oidPos = line.find(' ');
+  if (oidPos == std::string::npos) {
+    return false;
+  }
+  std::string command = line.substr(0, oidPos);
+  size_t paramsPos = line.find(' ', oidPos + 1);
+  std::string requestedOid = line.substr(oidPos + 1, paramsPos == std::string::npos ? std::string::npos : paramsPos - oidPos - 1);
+  std::string params = paramsPos == std::string::npos ? "" : line.substr(paramsPos + 1);
+  if (command == "get" && paramsPos == std::string::npos) {
+    logger::log(COMPONENT, LOG_INFO, "Received GET for OID " + requestedOid);
+    commitBatchWrites(transaction);
+    snmp_get(mibtab, mibScheduler, requestedOid, response);
+  } else if (command == "getnext" && paramsPos == std::string::npos) {
+    logger::log(COMPONENT, LOG_INFO, "Received GETNEXT for OID " + requestedOid);
+    commitBatchWrites(transaction);
+    snmp_getnext(mibtab, mibScheduler, requestedOid, cursor, response);
+  } else if (command == "set") {
+    //Params are: 'datatype' 'value'
+    size_t sepPos = params.find(' ');
+    if (sepPos == std::string::npos) {
+      return false;
+    }
+    std::string datatype = params.substr(0, sepPos);
+    std::string value = params.substr(sepPos + 1);
+    std::transform(datatype.begin(), datatype.end(), datatype.begin(), ::toupper);
+    std::stringstream setStream;
+    setStream << "Received SET for OID " << requestedOid << "; Type: " << datatype << "; Value: " << value;
+    logger::log(COMPONENT, LOG_INFO, setStream.str());
+    //SET events of new table rows are bound to the table
+    Oid* eventsOid = mibtab->getOidByOid(requestedOid);
+    size_t lastDotPos = requestedOid.find_last_of('.');
+    if (eventsOid == nullptr && lastDotPos != std::string::npos) {
+      eventsOid = mibtab->getOidByOid(requestedOid.substr(0, lastDotPos));
+    }
+    if (eventsOid != nullptr && mibScheduler->hasEvents(eventsOid, EventMode::SET)) {
+      commitBatchWrites(transaction);
+    } else {
+      beginBatchWrites(transaction);
+    }
+    snmp_set(mibtab, mibScheduler, requestedOid, datatype, value, response);
+  } else if (command == "change" && paramsPos != std::string::npos) {
+    //Change value manually, as -C does; no events are executed
+    beginBatchWrites(transaction);
+    Oid* assocOid = mibtab->getOidByOid(requestedOid);
+    if (assocOid == nullptr) {
+      if (noSuchNameLog.admit()) {
+        logger::log(COMPONENT, LOG_WARN, "OID " + requestedOid + " does not exist");
+      }
+      response += "no-such-name\n";
+    } else if (assocOid->setValue(params)) {
+      logger::log(COMPONENT, LOG_INFO, "Value for OID " + requestedOid + " set to " + params);
+      appendVarbind(response, assocOid);
+    } else {
+      logger::log(COMPONENT, LOG_ERROR, "Could not set value for OID " + requestedOid);
+      response += "wrong-value\n";
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
 inline bool initializeDatabase() {
   std::string error;
   //open SQL file
@@ -261,6 +762,8 @@ int main(int argc, char* argv[]) {
 
   //Exitcode declaration
   int exitcode = 0;
+  //iostreams are not mixed with C stdio
+  std::ios::sync_with_stdio(false);
 
   //Getopts
   /**
@@ -299,6 +802,47 @@ int main(int argc, char* argv[]) {
     logger::logLevel = DEFAULT_MURMURE_LOGLEVEL;
   }
   logger::toStdout = false;
+  //Initialize events execution timeout
+  if (cmdLineOpts.execTimeoutSet) {
+    Scheduler::setExecTimeout(cmdLineOpts.execTimeout);
+  }
+  //Initialize execution classes
+  for (auto& classSpec : cmdLineOpts.execClasses) {
+    std::string classError;
+    if (!process::configureClass(classSpec, classError)) {
+      std::cout << classError << std::endl;
+      return 255;
+    }
+  }
+  //One-shot requests are forwarded to the running daemon, if any; the daemon on the default socket
+  //may serve another database, so requests on a database passed with -d are forwarded only to -U
+  bool forward = cmdLineOpts.socketPathSet || !cmdLineOpts.dbPathSet;
+  if (forward && (cmdLineOpts.command == Command::GET || cmdLineOpts.command == Command::GET_NEXT || cmdLineOpts.command == Command::SET)) {
+    std::string request;
+    if (cmdLineOpts.command == Command::GET) {
+      request = "get\n" + cmdLineOpts.args.at(0) + "\n";
+    } else if (cmdLineOpts.command == Command::GET_NEXT) {
+      request = "getnext\n" + cmdLineOpts.args.at(0) + "\n";
+    } else {
+      request = "set\n" + cmdLineOpts.args.at(0) + "\n" + cmdLineOpts.args.at(1) + " " + cmdLineOpts.args.at(2) + "\n";
+    }
+    bool sent;
+    if (forwardRequest(cmdLineOpts.socketPathSet ? cmdLineOpts.socketPath : DEFAULT_MURMURE_SOCKET, request, sent)) {
+      return 0;
+    } else if (sent) {
+      //Don't repeat the request in process; it may have been executed already
+      logger::log(COMPONENT, LOG_ERROR, "Daemon didn't answer to forwarded request");
+      return 1;
+    }
+  } else if (forward && cmdLineOpts.command == Command::WALK) {
+    bool sent;
+    if (forwardWalk(cmdLineOpts.socketPathSet ? cmdLineOpts.socketPath : DEFAULT_MURMURE_SOCKET, cmdLineOpts.args.at(0), sent)) {
+      return 0;
+    } else if (sent) {
+      logger::log(COMPONENT, LOG_ERROR, "Daemon didn't complete forwarded walk");
+      return 1;
+    }
+  }
   //Initialize the database
   if (cmdLineOpts.dbPathSet) {
     database::init(cmdLineOpts.dbPath);
@@ -317,16 +861,22 @@ int main(int argc, char* argv[]) {
     std::cout << "Murmure " << MURMURE_VERSION << " - Developed by Christian Visintin" << std::endl;
     std::cout << "<https://github.com/ChristianVisintin/Murmure> (C) 2018-2019" << std::endl;
     std::cout << USAGE << std::endl;
-  } else if (cmdLineOpts.command == Command::DAEMON) { //@! DAEMON
-    //Daemon Mode
+  } else if (cmdLineOpts.command == Command::DAEMON || cmdLineOpts.command == Command::AGENTX || cmdLineOpts.command == Command::SNMP_AGENT) { //@! DAEMON
+    //Daemon Mode (pass_persist on stdin, AgentX subagent or SNMPv2c agent)
     //Set silent mode
     logger::toStdout = false;
+    //Start executor before loading the MIB, so that commands launch cost doesn't grow with daemon size
+    std::string executorError;
+    if (!process::startExecutor(executorError)) {
+      logger::log(COMPONENT, LOG_WARN, "Could not start executor (" + executorError + "); commands will be forked by the daemon");
+    }
     //Instance new mibtable
     Mibtable* mibtab = new Mibtable();
     //Load mibtable
     if (!mibtab->loadMibTable()) {
       logger::log(COMPONENT, LOG_FATAL, "MIB table loading failed; execution aborted");
       delete mibtab;
+      process::stopExecutor();
       return 1;
     }
     logger::log(COMPONENT, LOG_INFO, "MIB table loaded successfully");
@@ -335,67 +885,122 @@ int main(int argc, char* argv[]) {
     //Load scheduler events
     if (!mibScheduler->loadEvents()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
+      process::stopExecutor();
       return 2;
     }
     logger::log(COMPONENT, LOG_INFO, "Scheduler loaded successfully");
     //Start scheduler
     if (!mibScheduler->startScheduler()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not start scheduler; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
+      process::stopExecutor();
       return 2;
     }
+    //Reload events on SIGHUP; restart interrupted reads on stdin
+    struct sigaction reloadAction;
+    reloadAction.sa_handler = onReloadSignal;
+    sigemptyset(&reloadAction.sa_mask);
+    reloadAction.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &reloadAction, nullptr);
     logger::log(COMPONENT, LOG_INFO, "Murmure daemon started");
-    std::string command;
-    //Daemon terminates when command == ""
-    while (true) {
-      //Get line
-      std::getline(std::cin, command);
-
-      if (command == "") { //Terminate daemon
-        break;
-      } else if (command == "PING") {
-        //Output PONG (part of the "secret" net-snmp handshaking)
-        std::cout << "PONG" << std::endl;
-      } else if (command == "get") {
-        //Read from stdout requested OID
-        std::string requestedOid;
-        std::getline(std::cin, requestedOid);
-        logger::log(COMPONENT, LOG_INFO, "Received GET for OID " + requestedOid);
-        snmp_get(mibtab, mibScheduler, requestedOid);
-      } else if (command == "getnext") {
-        std::string requestedOid;
-        std::getline(std::cin, requestedOid);
-        logger::log(COMPONENT, LOG_INFO, "Received GETNEXT for OID " + requestedOid);
-        snmp_getnext(mibtab, mibScheduler, requestedOid);
-      } else if (command == "set") {
-        //Two lines; first is OID, second is: 'datatype' 'value'
-        std::string requestedOid;
-        std::getline(std::cin, requestedOid);
-        //Get params
-        std::string setParams;
-        std::getline(std::cin, setParams);
-        //Split params into two tokens
-        size_t sepPos = setParams.find(' ');
-        if (sepPos == std::string::npos) {
-          logger::log(COMPONENT, LOG_ERROR, "Invalid SET parameters");
-          //Wait for next command
-          continue;
+    //Serve one-shot clients (-g/-n/-s) on the daemon socket
+    std::string socketPath = cmdLineOpts.socketPathSet ? cmdLineOpts.socketPath : DEFAULT_MURMURE_SOCKET;
+    std::string socketError;
+    int listenFd = unixsocket::listen(socketPath, socketError);
+    std::vector<std::thread> socketWorkers;
+    if (listenFd >= 0) {
+      int workers = cmdLineOpts.workersSet ? cmdLineOpts.workers : DEFAULT_SOCKET_WORKERS;
+      for (int i = 0; i < workers; i++) {
+        socketWorkers.push_back(std::thread(serveSocket, listenFd, mibtab, mibScheduler));
+      }
+      std::stringstream socketStream;
+      socketStream << "Listening for requests on " << socketPath << " with " << workers << " workers";
+      logger::log(COMPONENT, LOG_INFO, socketStream.str());
+    } else {
+      logger::log(COMPONENT, LOG_WARN, "Could not open daemon socket (" + socketError + "); requests are served on stdin only");
+    }
+    //Apply values pushed by collectors through the ingestion ring
+    ingest::Consumer ingestConsumer(mibtab);
+    if (cmdLineOpts.ingestSet) {
+      std::string ingestPath = cmdLineOpts.ingestPath.empty() ? DEFAULT_MURMURE_INGEST : cmdLineOpts.ingestPath;
+      std::string ingestError;
+      if (ingestConsumer.start(ingestPath, ingestError)) {
+        logger::log(COMPONENT, LOG_INFO, "Ingesting values from " + ingestPath);
+      } else {
+        logger::log(COMPONENT, LOG_WARN, "Could not start ingestion (" + ingestError + ")");
+      }
+    }
+    if (cmdLineOpts.command == Command::AGENTX || cmdLineOpts.command == Command::SNMP_AGENT) {
+      //Agents terminate on SIGTERM/SIGINT
+      struct sigaction stopAction;
+      stopAction.sa_handler = onStopSignal;
+      sigemptyset(&stopAction.sa_mask);
+      stopAction.sa_flags = 0;
+      sigaction(SIGTERM, &stopAction, nullptr);
+      sigaction(SIGINT, &stopAction, nullptr);
+    }
+    if (cmdLineOpts.command == Command::SNMP_AGENT) {
+      snmp::Agent agent(mibtab, mibScheduler);
+      std::string snmpError;
+      bool configured = true;
+      for (auto& communitySpec : cmdLineOpts.communities) {
+        if (!agent.addCommunity(communitySpec, snmpError)) {
+          configured = false;
+          break;
         }
-        std::string datatype = setParams.substr(0, sepPos);
-        std::string value = setParams.substr(sepPos + 1);
-        //Convert datatype to lower case - just to be sure
-        std::transform(datatype.begin(), datatype.end(), datatype.begin(), ::toupper);
-        std::stringstream setStream;
-        setStream << "Received SET for OID " << requestedOid << "; Type: " << datatype << "; Value: " << value;
-        logger::log(COMPONENT, LOG_INFO, setStream.str());
-        snmp_set(mibtab, mibScheduler, requestedOid, datatype, value);
+      }
+      std::string endpoint = cmdLineOpts.args.size() > 0 ? cmdLineOpts.args.at(0) : "";
+      if (!configured || !agent.run(endpoint, cmdLineOpts.snmpThreadsSet ? cmdLineOpts.snmpThreads : 1, snmpError)) {
+        logger::log(COMPONENT, LOG_FATAL, "Could not start SNMP agent: " + snmpError);
+        exitcode = 1;
+      }
+    } else if (cmdLineOpts.command == Command::AGENTX) {
+      std::string masterPath = cmdLineOpts.args.size() > 0 ? cmdLineOpts.args.at(0) : DEFAULT_AGENTX_SOCKET;
+      agentx::Subagent subagent(mibtab, mibScheduler, masterPath);
+      std::string agentxError;
+      if (!subagent.run(agentxError)) {
+        logger::log(COMPONENT, LOG_FATAL, "Could not start AgentX subagent: " + agentxError);
+        exitcode = 1;
+      }
+    } else {
+      //Requests are parsed in place from the input buffer
+      PassPersist passPersist(STDIN_FILENO, STDOUT_FILENO);
+      requestBuffers buffers;
+      //Daemon terminates when command == "" or stdin is closed
+      while (serveRequest(passPersist, buffers, mibtab, mibScheduler)) {
       }
     }
+    if (listenFd >= 0) {
+      unixsocket::shutdown(listenFd);
+      for (auto& worker : socketWorkers) {
+        worker.join();
+      }
+      unixsocket::close(listenFd, socketPath);
+    }
+    ingestConsumer.stop();
+    uint64_t cursorHits;
+    uint64_t cursorMisses;
+    mibtab->getCursorStats(cursorHits, cursorMisses);
+    std::stringstream cursorStream;
+    cursorStream << "Walk cursor: " << cursorHits << " hits, " << cursorMisses << " misses";
+    logger::log(COMPONENT, LOG_INFO, cursorStream.str());
+    if (cmdLineOpts.ingestSet) {
+      uint64_t ingestRecords;
+      uint64_t ingestApplied;
+      uint64_t ingestUnknown;
+      uint64_t ingestInvalid;
+      uint64_t ingestDropped;
+      ingest::Consumer::getStats(ingestRecords, ingestApplied, ingestUnknown, ingestInvalid, ingestDropped);
+      std::stringstream ingestStream;
+      ingestStream << "Ingestion: " << ingestRecords << " records, " << ingestApplied << " values applied, " << ingestUnknown << " unknown OIDs, " << ingestInvalid << " invalid values, " << ingestDropped << " dropped";
+      logger::log(COMPONENT, LOG_INFO, ingestStream.str());
+    }
+    delete mibScheduler; //Free scheduler (its threads use mibtab)
     delete mibtab;       //Free mibtab
-    delete mibScheduler; //Free scheduler
+    process::stopExecutor();
     logger::log(COMPONENT, LOG_INFO, "Murmure daemon terminated");
   } else if (cmdLineOpts.command == Command::GET) { //@! GET
     //Set silent mode
@@ -414,23 +1019,25 @@ int main(int argc, char* argv[]) {
     //Load scheduler events
     if (!mibScheduler->loadEvents()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     logger::log(COMPONENT, LOG_INFO, "Scheduler loaded successfully");
     //Start scheduler
     if (!mibScheduler->startScheduler()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not start scheduler; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     std::string requestedOid = cmdLineOpts.args.at(0);
     logger::log(COMPONENT, LOG_INFO, "Received GET for OID " + requestedOid);
-    snmp_get(mibtab, mibScheduler, requestedOid);
+    std::string response;
+    snmp_get(mibtab, mibScheduler, requestedOid, response);
+    std::cout << response;
+    delete mibScheduler; //Free scheduler (its threads use mibtab)
     delete mibtab;       //Free mibtab
-    delete mibScheduler; //Free scheduler
   } else if (cmdLineOpts.command == Command::GET_NEXT) { //@! GET NEXT
     //Set silent mode
     logger::toStdout = false;
@@ -448,24 +1055,27 @@ int main(int argc, char* argv[]) {
     //Load scheduler events
     if (!mibScheduler->loadEvents()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     logger::log(COMPONENT, LOG_INFO, "Scheduler loaded successfully");
     //Start scheduler
     if (!mibScheduler->startScheduler()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not start scheduler; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     std::string requestedOid = cmdLineOpts.args.at(0);
     logger::log(COMPONENT, LOG_INFO, "Received GETNEXT for OID " + requestedOid);
-    snmp_getnext(mibtab, mibScheduler, requestedOid);
+    std::string response;
+    walkCursor cursor;
+    snmp_getnext(mibtab, mibScheduler, requestedOid, cursor, response);
+    std::cout << response;
+    delete mibScheduler; //Free scheduler (its threads use mibtab)
     delete mibtab;       //Free mibtab
-    delete mibScheduler; //Free scheduler
-  } else if (cmdLineOpts.command == Command::SET) { //@! SET
+  } else if (cmdLineOpts.command == Command::WALK) { //@! WALK
     //Set silent mode
     logger::toStdout = false;
     //Instance new mibtable
@@ -482,16 +1092,52 @@ int main(int argc, char* argv[]) {
     //Load scheduler events
     if (!mibScheduler->loadEvents()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
+      delete mibScheduler;
       delete mibtab;
+      return 2;
+    }
+    logger::log(COMPONENT, LOG_INFO, "Scheduler loaded successfully");
+    //Start scheduler
+    if (!mibScheduler->startScheduler()) {
+      logger::log(COMPONENT, LOG_FATAL, "Could not start scheduler; execution aborted");
       delete mibScheduler;
+      delete mibtab;
+      return 2;
+    }
+    std::string requestedOid = cmdLineOpts.args.at(0);
+    logger::log(COMPONENT, LOG_INFO, "Received WALK for OID " + requestedOid);
+    std::string response;
+    snmp_walk(mibtab, mibScheduler, requestedOid, response);
+    std::cout << response;
+    delete mibScheduler; //Free scheduler (its threads use mibtab)
+    delete mibtab;       //Free mibtab
+  } else if (cmdLineOpts.command == Command::SET) { //@! SET
+    //Set silent mode
+    logger::toStdout = false;
+    //Instance new mibtable
+    Mibtable* mibtab = new Mibtable();
+    //Load mibtable
+    if (!mibtab->loadMibTable()) {
+      logger::log(COMPONENT, LOG_FATAL, "MIB table loading failed; execution aborted");
+      delete mibtab;
+      return 1;
+    }
+    logger::log(COMPONENT, LOG_INFO, "MIB table loaded successfully");
+    //Instance scheduler
+    Scheduler* mibScheduler = new Scheduler(mibtab);
+    //Load scheduler events
+    if (!mibScheduler->loadEvents()) {
+      logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
+      delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     logger::log(COMPONENT, LOG_INFO, "Scheduler loaded successfully");
     //Start scheduler
     if (!mibScheduler->startScheduler()) {
       logger::log(COMPONENT, LOG_INFO, "Could not start scheduler; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     std::string requestedOid = cmdLineOpts.args.at(0);
@@ -500,9 +1146,11 @@ int main(int argc, char* argv[]) {
     std::transform(datatype.begin(), datatype.end(), datatype.begin(), ::toupper);
     std::stringstream setStream;
     setStream << "Received SET for OID " << requestedOid << "; Type: " << datatype << "; Value: " << value;
-    snmp_set(mibtab, mibScheduler, requestedOid, datatype, value);
+    std::string response;
+    snmp_set(mibtab, mibScheduler, requestedOid, datatype, value, response);
+    std::cout << response;
+    delete mibScheduler; //Free scheduler (its threads use mibtab)
     delete mibtab;       //Free mibtab
-    delete mibScheduler; //Free scheduler
   } else if (cmdLineOpts.command == Command::PARSE_MIB) { //@! PARSE MIB
     std::string rootOid = cmdLineOpts.args.at(0);
     std::string mibFile = cmdLineOpts.args.at(1);
@@ -528,8 +1176,8 @@ int main(int argc, char* argv[]) {
     //Load scheduler events
     if (!mibScheduler->loadEvents()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
     //Check if a file has to be parsed or if user wants to insert scheduling manually
@@ -573,7 +1221,7 @@ int main(int argc, char* argv[]) {
         } else if (modeStr == "AUTO") {
           mode = EventMode::AUTO;
           //@! Ask timeout for Scheduled events
-          std::cout << "Set timeout for scheduled event: ";
+          std::cout << "Set timeout for scheduled event (0 if cron option is set): ";
           std::cin >> timeout;
         } else if (modeStr == "INIT") {
           mode = EventMode::INIT;
@@ -595,9 +1243,27 @@ int main(int argc, char* argv[]) {
           commandList.push_back(command);
         }
 
+        //Ask for options
+        EventOptions options;
+        std::cout << "Set event options (name=value); press ENTER (without typing anything else) to skip" << std::endl;
+        while (1) {
+          std::string option;
+          std::cout << ">> ";
+          std::getline(std::cin, option);
+          if (option == "") {
+            break;
+          }
+          size_t eqPos = option.find('=');
+          if (eqPos == std::string::npos) {
+            std::cout << "Invalid option, expected name=value" << std::endl;
+            continue;
+          }
+          options[option.substr(0, eqPos)] = option.substr(eqPos + 1);
+        }
+
         //Commit changes
         std::string errorString;
-        if (mibScheduler->parseScheduling(oid, mode, commandList, errorString, timeout)) {
+        if (mibScheduler->parseScheduling(oid, mode, commandList, errorString, timeout, options)) {
           std::cout << "Scheduling entry saved successfully" << std::endl;
         } else {
           std::cout << "Scheduling entry refused: " << errorString << std::endl;
@@ -605,8 +1271,8 @@ int main(int argc, char* argv[]) {
       }
     }
 
-    delete mibtab;
     delete mibScheduler;
+    delete mibtab;
   } else if (cmdLineOpts.command == Command::DUMP_SCHEDULE) {
     std::string dumpFile = "";
     //Check if dump file has been provided
@@ -627,8 +1293,8 @@ int main(int argc, char* argv[]) {
     //Load scheduler events
     if (!mibScheduler->loadEvents()) {
       logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
-      delete mibtab;
       delete mibScheduler;
+      delete mibtab;
       return 2;
     }
 
@@ -639,7 +1305,23 @@ int main(int argc, char* argv[]) {
     }
 
     exitcode = 0;
+    delete mibScheduler;
     delete mibtab;
+
+  } else if (cmdLineOpts.command == Command::DUMP_METRICS) {
+    std::string dumpFile = "";
+    //Check if dump file has been provided
+    if (cmdLineOpts.args.size() > 0) {
+      dumpFile = cmdLineOpts.args.at(0);
+    }
+    //Instance new scheduler, no mib table needed
+    Scheduler* mibScheduler = new Scheduler();
+    //Dump metrics
+    exitcode = 0;
+    if (!mibScheduler->dumpMetrics(dumpFile)) {
+      logger::log(COMPONENT, LOG_FATAL, "Metrics dump failed");
+      exitcode = 1;
+    }
     delete mibScheduler;
 
   } else if (cmdLineOpts.command == Command::RESET) {
@@ -698,6 +1380,101 @@ int main(int argc, char* argv[]) {
       }
     }
     delete mibtab;
+  } else if (cmdLineOpts.command == Command::BATCH) { //@! BATCH
+    //Set silent mode
+    logger::toStdout = false;
+    //Open requests file; '-' is stdin
+    std::string batchFile = cmdLineOpts.args.at(0);
+    std::ifstream batchStream;
+    if (batchFile != "-") {
+      batchStream.open(batchFile);
+      if (!batchStream.is_open()) {
+        logger::log(COMPONENT, LOG_FATAL, "Could not open batch file " + batchFile);
+        return 1;
+      }
+    }
+    std::istream& input = batchFile != "-" ? batchStream : std::cin;
+    //Instance new mibtable
+    Mibtable* mibtab = new Mibtable();
+    //Load mibtable
+    if (!mibtab->loadMibTable()) {
+      logger::log(COMPONENT, LOG_FATAL, "MIB table loading failed; execution aborted");
+      delete mibtab;
+      return 1;
+    }
+    logger::log(COMPONENT, LOG_INFO, "MIB table loaded successfully");
+    //Instance scheduler
+    Scheduler* mibScheduler = new Scheduler(mibtab);
+    //Load scheduler events
+    if (!mibScheduler->loadEvents()) {
+      logger::log(COMPONENT, LOG_FATAL, "Could not load scheduler events; execution aborted");
+      delete mibScheduler;
+      delete mibtab;
+      return 2;
+    }
+    logger::log(COMPONENT, LOG_INFO, "Scheduler loaded successfully");
+    //Start scheduler
+    if (!mibScheduler->startScheduler()) {
+      logger::log(COMPONENT, LOG_FATAL, "Could not start scheduler; execution aborted");
+      delete mibScheduler;
+      delete mibtab;
+      return 2;
+    }
+    //Changes are written to database in transactions, committed at most every BATCH_COMMIT_INTERVAL
+    batchTransaction transaction;
+    transaction.open = false;
+    transaction.failed = false;
+    std::string line;
+    std::string response;
+    walkCursor cursor;
+    size_t lineNumber = 0;
+    while (true) {
+      //Don't keep other processes waiting on the transaction while stdin is idle
+      if (transaction.open && &input == &std::cin && input.rdbuf()->in_avail() <= 0) {
+        awaitBatchInput(transaction);
+      }
+      if (!std::getline(input, line)) {
+        break;
+      }
+      lineNumber++;
+      line = strutils::trim(line);
+      //Skip empty lines and comments
+      if (line.empty() || line.at(0) == '#') {
+        continue;
+      }
+      //A malformed value mustn't abort the batch, discarding the whole transaction
+      uint64_t eventFailures = Event::getRequestFailures();
+      try {
+        if (!serveBatchLine(line, mibtab, mibScheduler, cursor, transaction, response)) {
+          logger::log(COMPONENT, LOG_ERROR, "Invalid batch request at line " + std::to_string(lineNumber) + ": " + line);
+          response += "invalid-request\n";
+          exitcode = 1;
+        }
+      } catch (std::exception& ex) {
+        logger::log(COMPONENT, LOG_ERROR, "Invalid value at batch line " + std::to_string(lineNumber) + ": " + line);
+        response += "wrong-value\n";
+        exitcode = 1;
+      }
+      if (Event::getRequestFailures() != eventFailures) {
+        logger::log(COMPONENT, LOG_ERROR, "Events failed at batch line " + std::to_string(lineNumber) + ": " + line);
+        exitcode = 1;
+      }
+      std::cout << response;
+      response.clear();
+      //Other processes mustn't wait on the batch for too long
+      if (transaction.open && std::chrono::steady_clock::now() - transaction.since >= std::chrono::milliseconds(BATCH_COMMIT_INTERVAL)) {
+        commitBatchWrites(transaction);
+      }
+    }
+    commitBatchWrites(transaction);
+    if (transaction.failed) {
+      logger::log(COMPONENT, LOG_FATAL, "Some batch changes could not be committed");
+      exitcode = 1;
+    } else {
+      logger::log(COMPONENT, LOG_INFO, "Batch of " + std::to_string(lineNumber) + " lines committed");
+    }
+    delete mibScheduler; //Free scheduler (its threads use mibtab)
+    delete mibtab;       //Free mibtab
   } else {
     logger::log(COMPONENT, LOG_ERROR, "Unknown command");
     exitcode = 255;
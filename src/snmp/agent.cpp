@@ -0,0 +1,486 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <snmp/agent.hpp>
+#include <utils/logger.hpp>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define COMPONENT "SNMP"
+
+namespace murmure {
+namespace snmp {
+
+volatile sig_atomic_t Agent::stopRequested = 0;
+
+/**
+ * @function Agent
+ * @description Agent class constructor
+ * @param Mibtable* mibtable served to SNMP managers
+ * @param Scheduler* scheduler which executes GET/SET events
+**/
+
+Agent::Agent(Mibtable* mibtable, Scheduler* scheduler) : served(0), badCommunities(0), malformed(0) {
+  this->mibtable = mibtable;
+  this->scheduler = scheduler;
+}
+
+/**
+ * @function requestStop
+ * @description make run return; async-signal-safe
+**/
+
+void Agent::requestStop() {
+  stopRequested = 1;
+}
+
+/**
+ * @function addCommunity
+ * @description grant access to a community
+ * @param std::string specification: <community>[:ro|:rw]; read only if access is omitted
+ * @param std::string& error
+ * @returns bool: false if specification is not valid
+**/
+
+bool Agent::addCommunity(const std::string& spec, std::string& error) {
+  size_t colonPos = spec.find_last_of(':');
+  std::string community = spec.substr(0, colonPos);
+  std::string access = colonPos != std::string::npos ? spec.substr(colonPos + 1) : "ro";
+  if (community.empty()) {
+    error = "Empty community in '" + spec + "'";
+    return false;
+  }
+  if (access == "ro") {
+    communities[community] = AccessMode::READONLY;
+  } else if (access == "rw") {
+    communities[community] = AccessMode::READWRITE;
+  } else {
+    error = "Invalid access '" + access + "' for community " + community + " (ro/rw)";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @function run
+ * @description bind the agent and serve requests until a stop is requested;
+ * with more than one thread, each thread receives on its own SO_REUSEPORT socket
+ * @param std::string endpoint: [address:]port
+ * @param int amount of receiving threads
+ * @param std::string& error
+ * @returns bool: false if agent can't be started
+**/
+
+bool Agent::run(const std::string& endpoint, int threads, std::string& error) {
+
+  std::string address = DEFAULT_SNMP_ADDRESS;
+  std::string portStr = endpoint;
+  size_t colonPos = endpoint.find_last_of(':');
+  if (colonPos != std::string::npos) {
+    address = endpoint.substr(0, colonPos);
+    portStr = endpoint.substr(colonPos + 1);
+  }
+  int port = DEFAULT_SNMP_PORT;
+  if (!portStr.empty()) {
+    try {
+      port = std::stoi(portStr);
+    } catch (std::exception& ex) {
+      port = -1;
+    }
+  }
+  if (port <= 0 || port > 65535) {
+    error = "Invalid port '" + portStr + "'";
+    return false;
+  }
+  if (communities.empty()) {
+    communities[DEFAULT_SNMP_COMMUNITY] = AccessMode::READONLY;
+  }
+  std::vector<int> sockets;
+  for (int i = 0; i < threads; i++) {
+    int sockFd = openSocket(address, port, threads > 1, error);
+    if (sockFd < 0) {
+      for (auto& openFd : sockets) {
+        close(openFd);
+      }
+      return false;
+    }
+    sockets.push_back(sockFd);
+  }
+  std::stringstream startStream;
+  startStream << "SNMPv2c agent listening on " << address << ":" << port << " with " << threads << " threads";
+  logger::log(COMPONENT, LOG_INFO, startStream.str());
+  std::vector<std::thread> receivers;
+  for (size_t i = 1; i < sockets.size(); i++) {
+    receivers.push_back(std::thread(&Agent::receive, this, sockets.at(i)));
+  }
+  receive(sockets.at(0));
+  for (auto& receiver : receivers) {
+    receiver.join();
+  }
+  for (auto& sockFd : sockets) {
+    close(sockFd);
+  }
+  std::stringstream statsStream;
+  statsStream << "SNMPv2c agent stopped; served " << served << " requests; dropped " << badCommunities << " with unknown community, " << malformed << " malformed";
+  logger::log(COMPONENT, LOG_INFO, statsStream.str());
+  return true;
+}
+
+/**
+ * @function openSocket
+ * @description create a non blocking UDP socket bound to address and port
+ * @param std::string IPv4 address
+ * @param int port
+ * @param bool share port with the other receiving threads (SO_REUSEPORT)
+ * @param std::string& error
+ * @returns int: socket; -1 on error
+**/
+
+int Agent::openSocket(const std::string& address, int port, bool reusePort, std::string& error) {
+
+  sockaddr_in sockAddress;
+  memset(&sockAddress, 0, sizeof(sockAddress));
+  sockAddress.sin_family = AF_INET;
+  sockAddress.sin_port = htons(static_cast<uint16_t>(port));
+  if (inet_pton(AF_INET, address.c_str(), &sockAddress.sin_addr) != 1) {
+    error = "Invalid address '" + address + "'";
+    return -1;
+  }
+  int sockFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sockFd < 0) {
+    error = "Could not create socket: " + std::string(strerror(errno));
+    return -1;
+  }
+  int enable = 1;
+  if (reusePort && setsockopt(sockFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0) {
+    error = "SO_REUSEPORT is not supported: " + std::string(strerror(errno));
+    close(sockFd);
+    return -1;
+  }
+  if (bind(sockFd, reinterpret_cast<sockaddr*>(&sockAddress), sizeof(sockAddress)) != 0) {
+    error = "Could not bind " + address + ":" + std::to_string(port) + ": " + std::string(strerror(errno));
+    close(sockFd);
+    return -1;
+  }
+  return sockFd;
+}
+
+/**
+ * @function receive
+ * @description receiving thread: wait for datagrams with epoll, then receive and answer them in batches
+ * @param int socket
+**/
+
+void Agent::receive(int sockFd) {
+
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    logger::log(COMPONENT, LOG_ERROR, "Could not create epoll instance: " + std::string(strerror(errno)));
+    return;
+  }
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.fd = sockFd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, sockFd, &event);
+  //Buffers are reused across batches
+  std::vector<char> buffers(SNMP_RECEIVE_BATCH * SNMP_MAX_MESSAGE);
+  std::vector<BerWriter> writers(SNMP_RECEIVE_BATCH);
+  mmsghdr datagrams[SNMP_RECEIVE_BATCH];
+  iovec datagramIovs[SNMP_RECEIVE_BATCH];
+  sockaddr_in peers[SNMP_RECEIVE_BATCH];
+  mmsghdr responses[SNMP_RECEIVE_BATCH];
+  iovec responseIovs[SNMP_RECEIVE_BATCH];
+  message request;
+  SetTransaction transaction(mibtable, scheduler);
+  std::vector<walkCursor> cursors(SNMP_WALK_CURSORS);
+  while (!stopRequested) {
+    int ready = epoll_wait(epollFd, &event, 1, SNMP_POLL_INTERVAL);
+    if (ready <= 0) {
+      continue;
+    }
+    int received;
+    do {
+      for (int i = 0; i < SNMP_RECEIVE_BATCH; i++) {
+        datagramIovs[i].iov_base = buffers.data() + i * SNMP_MAX_MESSAGE;
+        datagramIovs[i].iov_len = SNMP_MAX_MESSAGE;
+        memset(&datagrams[i].msg_hdr, 0, sizeof(msghdr));
+        datagrams[i].msg_hdr.msg_iov = &datagramIovs[i];
+        datagrams[i].msg_hdr.msg_iovlen = 1;
+        datagrams[i].msg_hdr.msg_name = &peers[i];
+        datagrams[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+      }
+      received = recvmmsg(sockFd, datagrams, SNMP_RECEIVE_BATCH, MSG_DONTWAIT, nullptr);
+      if (received <= 0) {
+        break;
+      }
+      unsigned int responseCount = 0;
+      for (int i = 0; i < received; i++) {
+        BerWriter& writer = writers.at(responseCount);
+        walkCursor& cursor = cursors.at((peers[i].sin_addr.s_addr ^ peers[i].sin_port) % SNMP_WALK_CURSORS);
+        if (!handleMessage(static_cast<const char*>(datagramIovs[i].iov_base), datagrams[i].msg_len, request, writer, transaction, cursor)) {
+          continue;
+        }
+        responseIovs[responseCount].iov_base = const_cast<char*>(writer.getBuffer().data());
+        responseIovs[responseCount].iov_len = writer.getBuffer().length();
+        memset(&responses[responseCount].msg_hdr, 0, sizeof(msghdr));
+        responses[responseCount].msg_hdr.msg_iov = &responseIovs[responseCount];
+        responses[responseCount].msg_hdr.msg_iovlen = 1;
+        responses[responseCount].msg_hdr.msg_name = &peers[i];
+        responses[responseCount].msg_hdr.msg_namelen = datagrams[i].msg_hdr.msg_namelen;
+        responseCount++;
+      }
+      unsigned int sent = 0;
+      while (sent < responseCount) {
+        int sentNow = sendmmsg(sockFd, responses + sent, responseCount - sent, 0);
+        if (sentNow < 0 && errno == EINTR) {
+          continue;
+        } else if (sentNow <= 0) {
+          //Send buffer full or peer unreachable; SNMP managers retry
+          logger::log(COMPONENT, LOG_DEBUG, "Could not send response: " + std::string(strerror(errno)));
+          break;
+        }
+        sent += sentNow;
+      }
+    } while (received == SNMP_RECEIVE_BATCH);
+  }
+  close(epollFd);
+}
+
+/**
+ * @function handleMessage
+ * @description decode and execute an SNMP request, encoding its response in writer
+ * @param const char* datagram
+ * @param size_t datagram length
+ * @param message& request buffer
+ * @param BerWriter& response writer
+ * @param SetTransaction& transaction of this thread
+ * @param walkCursor& walk cursor of the manager
+ * @returns bool: false if datagram must be dropped (no response)
+**/
+
+bool Agent::handleMessage(const char* data, size_t length, message& request, BerWriter& writer, SetTransaction& transaction, walkCursor& cursor) {
+
+  if (!decodeMessage(data, length, request) || request.version != SNMP_VERSION_2C) {
+    malformed++;
+    return false;
+  }
+  auto community = communities.find(request.community);
+  if (community == communities.end()) {
+    badCommunities++;
+    logger::log(COMPONENT, LOG_DEBUG, "Dropping request with unknown community '" + request.community + "'");
+    return false;
+  }
+  switch (request.type) {
+  case PduType::GET:
+    get(request);
+    break;
+  case PduType::GETNEXT:
+    getNext(request, cursor);
+    break;
+  case PduType::GETBULK:
+    getBulk(request);
+    break;
+  case PduType::SET:
+    set(request, community->second, transaction);
+    break;
+  default:
+    malformed++;
+    return false;
+  }
+  served++;
+  PduType requestType = request.type;
+  request.type = PduType::RESPONSE;
+  if (encodeMessage(writer, request) < request.varbinds.size() && requestType != PduType::GETBULK) {
+    //Only GetBulk responses can be cut
+    request.errorStatus = SNMP_ERR_TOOBIG;
+    request.errorIndex = 0;
+    request.varbinds.clear();
+    encodeMessage(writer, request);
+  }
+  return true;
+}
+
+/**
+ * @function encodeValue
+ * @description refresh oid (GET events) and encode its value
+ * @param Oid*
+ * @param varbind& binding to fill
+ * @returns bool: false if value can't be encoded
+**/
+
+bool Agent::encodeValue(Oid* oid, varbind& binding) {
+  scheduler->refresh(oid);
+  return murmure::encodeValue(oid, binding);
+}
+
+/**
+ * @function get
+ * @description GetRequest: replace request varbinds with their values
+ * @param message& request
+**/
+
+void Agent::get(message& request) {
+  request.errorStatus = SNMP_ERR_NOERROR;
+  request.errorIndex = 0;
+  for (auto& binding : request.varbinds) {
+    Oid* oid = mibtable->getOidByOid(binding.oid);
+    if (oid == nullptr || !isLeaf(oid) || !encodeValue(oid, binding)) {
+      binding.type = oid == nullptr ? VarbindType::NOSUCHOBJECT : VarbindType::NOSUCHINSTANCE;
+      binding.data.clear();
+    }
+  }
+}
+
+/**
+ * @function getNext
+ * @description GetNextRequest: replace request varbinds with their successor leaves
+ * @param message& request
+ * @param walkCursor& walk cursor of the manager
+**/
+
+void Agent::getNext(message& request, walkCursor& cursor) {
+  request.errorStatus = SNMP_ERR_NOERROR;
+  request.errorIndex = 0;
+  for (auto& binding : request.varbinds) {
+    Oid* oid = nextLeaf(mibtable, binding.oid, false, "", &cursor);
+    if (oid == nullptr || !encodeValue(oid, binding)) {
+      binding.type = VarbindType::ENDOFMIBVIEW;
+      binding.data.clear();
+    }
+  }
+}
+
+/**
+ * @function getBulk
+ * @description GetBulkRequest: non repeaters are served as GetNext; the others are repeated
+ * up to max repetitions times, row by row
+ * @param message& request
+**/
+
+void Agent::getBulk(message& request) {
+
+  size_t nonRepeaters = static_cast<size_t>(std::max(request.errorStatus, 0));
+  size_t maxRepetitions = static_cast<size_t>(std::max(request.errorIndex, 0));
+  std::vector<varbind> requested;
+  requested.swap(request.varbinds);
+  request.errorStatus = SNMP_ERR_NOERROR;
+  request.errorIndex = 0;
+  nonRepeaters = std::min(nonRepeaters, requested.size());
+  for (size_t i = 0; i < nonRepeaters; i++) {
+    varbind binding = requested.at(i);
+    Oid* oid = nextLeaf(mibtable, binding.oid, false);
+    if (oid == nullptr || !encodeValue(oid, binding)) {
+      binding.type = VarbindType::ENDOFMIBVIEW;
+      binding.data.clear();
+    }
+    request.varbinds.push_back(binding);
+  }
+  //Each repeater collects its successors in a single table scan; they're returned row by row
+  size_t repeaters = requested.size() - nonRepeaters;
+  if (repeaters == 0) {
+    return;
+  }
+  maxRepetitions = std::min(maxRepetitions, (SNMP_MAX_BULK_VARBINDS - std::min<size_t>(nonRepeaters, SNMP_MAX_BULK_VARBINDS)) / repeaters);
+  std::vector<std::vector<Oid*>> successors(repeaters);
+  for (size_t i = 0; i < repeaters; i++) {
+    mibtable->getSuccessors(requested.at(nonRepeaters + i).oid, maxRepetitions, successors.at(i), isLeaf);
+  }
+  std::vector<bool> ended(repeaters, false);
+  for (size_t repetition = 0; repetition < maxRepetitions; repetition++) {
+    bool allEnded = true;
+    for (size_t i = 0; i < repeaters; i++) {
+      varbind binding;
+      binding.oid = requested.at(nonRepeaters + i).oid;
+      if (ended.at(i) || repetition >= successors.at(i).size() || !encodeValue(successors.at(i).at(repetition), binding)) {
+        binding.type = VarbindType::ENDOFMIBVIEW;
+        binding.data.clear();
+        ended.at(i) = true;
+      } else {
+        requested.at(nonRepeaters + i).oid = binding.oid;
+        allEnded = false;
+      }
+      request.varbinds.push_back(binding);
+    }
+    if (allEnded) {
+      break;
+    }
+  }
+}
+
+/**
+ * @function set
+ * @description SetRequest: all varbinds are tested, then committed; committed values are restored
+ * if a commit fails. Response varbinds are the request ones
+ * @param message& request
+ * @param AccessMode community access
+ * @param SetTransaction& transaction of this thread
+**/
+
+void Agent::set(message& request, AccessMode access, SetTransaction& transaction) {
+
+  request.errorStatus = SNMP_ERR_NOERROR;
+  request.errorIndex = 0;
+  if (access != AccessMode::READWRITE) {
+    request.errorStatus = SNMP_ERR_NOACCESS;
+    request.errorIndex = request.varbinds.empty() ? 0 : 1;
+    return;
+  }
+  std::lock_guard<std::mutex> guard(setMutex);
+  transaction.clear();
+  for (size_t i = 0; i < request.varbinds.size(); i++) {
+    uint16_t error = transaction.test(request.varbinds.at(i));
+    if (error != SNMP_ERR_NOERROR) {
+      request.errorStatus = error;
+      request.errorIndex = static_cast<int32_t>(i + 1);
+      transaction.clear();
+      return;
+    }
+  }
+  uint16_t index;
+  uint16_t error = transaction.commit(index);
+  if (error != SNMP_ERR_NOERROR) {
+    uint16_t undoIndex;
+    if (transaction.undo(undoIndex) != SNMP_ERR_NOERROR) {
+      error = SNMP_ERR_UNDOFAILED;
+      index = undoIndex;
+    }
+    request.errorStatus = error;
+    request.errorIndex = index;
+  }
+  //SET events of committed values are executed
+  transaction.cleanup();
+}
+
+} // namespace snmp
+}
@@ -0,0 +1,620 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <snmp/ber.hpp>
+
+namespace murmure {
+namespace snmp {
+
+//Placeholder length bytes written by open; the length is compacted by close
+#define BER_LENGTH_PLACEHOLDER 3
+
+/**
+ * @function parseOid
+ * @description split a dotted OID string into sub-identifiers
+ * @param std::string oid
+ * @param std::vector<uint32_t>& sub-identifiers
+**/
+
+static void parseOid(const std::string& oid, std::vector<uint32_t>& subids) {
+  subids.clear();
+  size_t position = 0;
+  while (position < oid.length()) {
+    if (oid[position] == '.') {
+      position++;
+      continue;
+    }
+    uint32_t subid = 0;
+    while (position < oid.length() && oid[position] != '.') {
+      subid = subid * 10 + (oid[position++] - '0');
+    }
+    subids.push_back(subid);
+  }
+}
+
+/**
+ * @function lengthSize
+ * @description returns the amount of bytes required to encode a length
+ * @param size_t length
+ * @returns size_t
+**/
+
+static size_t lengthSize(size_t length) {
+  size_t size = 1;
+  if (length >= 0x80) {
+    for (size_t remaining = length; remaining > 0; remaining >>= 8) {
+      size++;
+    }
+  }
+  return size;
+}
+
+/**
+ * @function BerReader
+ * @description BerReader class constructor
+ * @param const char* data
+ * @param size_t data length
+**/
+
+BerReader::BerReader(const char* data, size_t length) {
+  this->data = data;
+  this->length = length;
+  this->position = 0;
+}
+
+/**
+ * @function readHeader
+ * @description read the identifier and length of next element; position is moved to its content
+ * @param uint8_t& tag
+ * @param size_t& content length
+ * @returns bool: false if data is truncated or uses an unsupported form
+**/
+
+bool BerReader::readHeader(uint8_t& tag, size_t& contentLength) {
+  if (position + 2 > length) {
+    return false;
+  }
+  tag = static_cast<uint8_t>(data[position++]);
+  //Multi-byte tags are not used by SNMP
+  if ((tag & 0x1F) == 0x1F) {
+    return false;
+  }
+  uint8_t first = static_cast<uint8_t>(data[position++]);
+  if (first < 0x80) {
+    contentLength = first;
+  } else {
+    //Long form; indefinite length is not allowed
+    size_t lengthBytes = first & 0x7F;
+    if (lengthBytes == 0 || lengthBytes > 4 || position + lengthBytes > length) {
+      return false;
+    }
+    contentLength = 0;
+    for (size_t i = 0; i < lengthBytes; i++) {
+      contentLength = (contentLength << 8) | static_cast<uint8_t>(data[position++]);
+    }
+  }
+  return contentLength <= length - position;
+}
+
+/**
+ * @function readInteger
+ * @description read a signed INTEGER
+ * @param int64_t& value
+ * @returns bool: false if element is not a valid INTEGER
+**/
+
+bool BerReader::readInteger(int64_t& value) {
+  uint8_t tag;
+  size_t contentLength;
+  if (!readHeader(tag, contentLength) || tag != BER_INTEGER || contentLength == 0 || contentLength > 8) {
+    return false;
+  }
+  //Sign extension
+  value = static_cast<int8_t>(data[position++]);
+  for (size_t i = 1; i < contentLength; i++) {
+    value = static_cast<int64_t>((static_cast<uint64_t>(value) << 8) | static_cast<uint8_t>(data[position++]));
+  }
+  return true;
+}
+
+/**
+ * @function readUnsigned
+ * @description read an unsigned integer element (Counter32, Gauge32, TimeTicks, Counter64)
+ * @param uint8_t expected tag
+ * @param uint64_t& value
+ * @returns bool: false if element is not valid
+**/
+
+bool BerReader::readUnsigned(uint8_t expectedTag, uint64_t& value) {
+  uint8_t tag;
+  size_t contentLength;
+  if (!readHeader(tag, contentLength) || tag != expectedTag || contentLength == 0 || contentLength > 9) {
+    return false;
+  }
+  value = 0;
+  for (size_t i = 0; i < contentLength; i++) {
+    value = (value << 8) | static_cast<uint8_t>(data[position++]);
+  }
+  return true;
+}
+
+/**
+ * @function readOctets
+ * @description read a primitive element content as raw bytes
+ * @param uint8_t expected tag
+ * @param std::string& octets
+ * @returns bool: false if element is not valid
+**/
+
+bool BerReader::readOctets(uint8_t expectedTag, std::string& octets) {
+  uint8_t tag;
+  size_t contentLength;
+  if (!readHeader(tag, contentLength) || tag != expectedTag) {
+    return false;
+  }
+  octets.assign(data + position, contentLength);
+  position += contentLength;
+  return true;
+}
+
+/**
+ * @function readOid
+ * @description read an OBJECT IDENTIFIER
+ * @param std::string& dotted OID, with a leading dot
+ * @returns bool: false if element is not valid
+**/
+
+bool BerReader::readOid(std::string& oid) {
+  uint8_t tag;
+  size_t contentLength;
+  if (!readHeader(tag, contentLength) || tag != BER_OBJECTIDENTIFIER) {
+    return false;
+  }
+  oid.clear();
+  size_t end = position + contentLength;
+  bool first = true;
+  while (position < end) {
+    uint64_t subid = 0;
+    uint8_t byte;
+    do {
+      if (position >= end || subid > 0xFFFFFFFF) {
+        return false;
+      }
+      byte = static_cast<uint8_t>(data[position++]);
+      subid = (subid << 7) | (byte & 0x7F);
+    } while ((byte & 0x80) != 0);
+    //Arcs are 32 bit; the first sub-identifier carries the first two arcs
+    if (subid > (first ? 0xFFFFFFFFull + 80 : 0xFFFFFFFFull)) {
+      return false;
+    }
+    if (first) {
+      //First two arcs are combined
+      uint64_t arc = subid < 80 ? subid / 40 : 2;
+      oid += '.';
+      oid += std::to_string(arc);
+      subid -= arc * 40;
+      first = false;
+    }
+    oid += '.';
+    oid += std::to_string(subid);
+  }
+  return true;
+}
+
+/**
+ * @function readVarbind
+ * @description read a variable binding
+ * @param varbind& binding
+ * @returns bool: false if element is not valid or value type is unknown
+**/
+
+bool BerReader::readVarbind(varbind& binding) {
+  BerReader inner(nullptr, 0);
+  if (!enter(BER_SEQUENCE, inner) || !inner.readOid(binding.oid) || inner.atEnd()) {
+    return false;
+  }
+  binding.number = 0;
+  binding.data.clear();
+  uint8_t tag = static_cast<uint8_t>(inner.data[inner.position]);
+  binding.type = static_cast<VarbindType>(tag);
+  int64_t value;
+  switch (binding.type) {
+  case VarbindType::INTEGER:
+    if (!inner.readInteger(value) || value < INT32_MIN || value > INT32_MAX) {
+      return false;
+    }
+    binding.number = static_cast<uint32_t>(static_cast<int32_t>(value));
+    break;
+  case VarbindType::COUNTER32:
+  case VarbindType::GAUGE32:
+  case VarbindType::TIMETICKS:
+    if (!inner.readUnsigned(tag, binding.number) || binding.number > UINT32_MAX) {
+      return false;
+    }
+    break;
+  case VarbindType::COUNTER64:
+    if (!inner.readUnsigned(tag, binding.number)) {
+      return false;
+    }
+    break;
+  case VarbindType::OCTETSTRING:
+  case VarbindType::IPADDRESS:
+  case VarbindType::OPAQUE:
+  case VarbindType::NULLVALUE:
+  case VarbindType::NOSUCHOBJECT:
+  case VarbindType::NOSUCHINSTANCE:
+  case VarbindType::ENDOFMIBVIEW:
+    if (!inner.readOctets(tag, binding.data)) {
+      return false;
+    }
+    break;
+  case VarbindType::OBJECTIDENTIFIER:
+    if (!inner.readOid(binding.data)) {
+      return false;
+    }
+    break;
+  default:
+    return false;
+  }
+  return inner.atEnd();
+}
+
+/**
+ * @function enter
+ * @description read a constructed element header and point inner reader to its content
+ * @param uint8_t expected tag
+ * @param BerReader& inner
+ * @returns bool: false if element is not valid
+**/
+
+bool BerReader::enter(uint8_t expectedTag, BerReader& inner) {
+  uint8_t tag;
+  size_t contentLength;
+  if (!readHeader(tag, contentLength) || tag != expectedTag) {
+    return false;
+  }
+  inner = BerReader(data + position, contentLength);
+  position += contentLength;
+  return true;
+}
+
+/**
+ * @function atEnd
+ * @description returns whether all data has been read
+ * @returns bool
+**/
+
+bool BerReader::atEnd() {
+  return position >= length;
+}
+
+/**
+ * @function BerWriter
+ * @description BerWriter class constructor
+**/
+
+BerWriter::BerWriter() {
+}
+
+/**
+ * @function clear
+ * @description start a new encoding
+**/
+
+void BerWriter::clear() {
+  buffer.clear();
+}
+
+/**
+ * @function open
+ * @description start a constructed element
+ * @param uint8_t tag
+ * @returns size_t: mark to pass to close
+**/
+
+size_t BerWriter::open(uint8_t tag) {
+  size_t mark = buffer.length();
+  buffer += static_cast<char>(tag);
+  buffer.append(BER_LENGTH_PLACEHOLDER, '\0');
+  return mark;
+}
+
+/**
+ * @function close
+ * @description complete a constructed element, writing its length in the shortest form
+ * @param size_t mark returned by open
+**/
+
+void BerWriter::close(size_t mark) {
+  size_t lengthPos = mark + 1;
+  size_t contentLength = buffer.length() - lengthPos - BER_LENGTH_PLACEHOLDER;
+  size_t size = lengthSize(contentLength);
+  if (size < BER_LENGTH_PLACEHOLDER) {
+    buffer.erase(lengthPos, BER_LENGTH_PLACEHOLDER - size);
+  } else if (size > BER_LENGTH_PLACEHOLDER) {
+    buffer.insert(lengthPos, size - BER_LENGTH_PLACEHOLDER, '\0');
+  }
+  if (size == 1) {
+    buffer[lengthPos] = static_cast<char>(contentLength);
+    return;
+  }
+  buffer[lengthPos] = static_cast<char>(0x80 | (size - 1));
+  for (size_t i = size - 1; i > 0; i--) {
+    buffer[lengthPos + i] = static_cast<char>(contentLength & 0xFF);
+    contentLength >>= 8;
+  }
+}
+
+/**
+ * @function writeInteger
+ * @description append a signed integer, two's complement in the shortest form
+ * @param uint8_t tag
+ * @param int64_t value
+**/
+
+void BerWriter::writeInteger(uint8_t tag, int64_t value) {
+  size_t size = 8;
+  //Drop leading bytes which only carry the sign
+  while (size > 1) {
+    int64_t top = value >> ((size - 1) * 8 - 1);
+    if (top != 0 && top != -1) {
+      break;
+    }
+    size--;
+  }
+  buffer += static_cast<char>(tag);
+  buffer += static_cast<char>(size);
+  for (size_t i = size; i > 0; i--) {
+    buffer += static_cast<char>((static_cast<uint64_t>(value) >> ((i - 1) * 8)) & 0xFF);
+  }
+}
+
+/**
+ * @function writeUnsigned
+ * @description append an unsigned integer; a leading zero is added when the high bit is set
+ * @param uint8_t tag
+ * @param uint64_t value
+**/
+
+void BerWriter::writeUnsigned(uint8_t tag, uint64_t value) {
+  size_t size = 1;
+  while (size < 8 && (value >> (size * 8)) != 0) {
+    size++;
+  }
+  bool pad = ((value >> ((size - 1) * 8)) & 0x80) != 0;
+  buffer += static_cast<char>(tag);
+  buffer += static_cast<char>(size + (pad ? 1 : 0));
+  if (pad) {
+    buffer += '\0';
+  }
+  for (size_t i = size; i > 0; i--) {
+    buffer += static_cast<char>((value >> ((i - 1) * 8)) & 0xFF);
+  }
+}
+
+/**
+ * @function writeOctets
+ * @description append a primitive element with raw content
+ * @param uint8_t tag
+ * @param std::string octets
+**/
+
+void BerWriter::writeOctets(uint8_t tag, const std::string& octets) {
+  size_t mark = open(tag);
+  buffer += octets;
+  close(mark);
+}
+
+/**
+ * @function writeNull
+ * @description append an element with no content
+ * @param uint8_t tag
+**/
+
+void BerWriter::writeNull(uint8_t tag) {
+  buffer += static_cast<char>(tag);
+  buffer += '\0';
+}
+
+/**
+ * @function writeOid
+ * @description append an OBJECT IDENTIFIER
+ * @param std::string dotted OID
+**/
+
+void BerWriter::writeOid(const std::string& oid) {
+  std::vector<uint32_t> subids;
+  parseOid(oid, subids);
+  while (subids.size() < 2) {
+    subids.push_back(0);
+  }
+  size_t mark = open(BER_OBJECTIDENTIFIER);
+  for (size_t i = 1; i < subids.size(); i++) {
+    //First two arcs are combined
+    uint64_t subid = i == 1 ? static_cast<uint64_t>(subids.at(0)) * 40 + subids.at(1) : subids.at(i);
+    size_t groups = 1;
+    while (groups < 10 && (subid >> (groups * 7)) != 0) {
+      groups++;
+    }
+    for (size_t group = groups; group > 0; group--) {
+      uint8_t byte = (subid >> ((group - 1) * 7)) & 0x7F;
+      buffer += static_cast<char>(group > 1 ? byte | 0x80 : byte);
+    }
+  }
+  close(mark);
+}
+
+/**
+ * @function writeVarbind
+ * @description append a variable binding
+ * @param varbind
+**/
+
+void BerWriter::writeVarbind(const varbind& binding) {
+  size_t mark = open(BER_SEQUENCE);
+  writeOid(binding.oid);
+  uint8_t tag = static_cast<uint8_t>(binding.type);
+  switch (binding.type) {
+  case VarbindType::INTEGER:
+    writeInteger(tag, static_cast<int32_t>(binding.number));
+    break;
+  case VarbindType::COUNTER32:
+  case VarbindType::GAUGE32:
+  case VarbindType::TIMETICKS:
+  case VarbindType::COUNTER64:
+    writeUnsigned(tag, binding.number);
+    break;
+  case VarbindType::OCTETSTRING:
+  case VarbindType::IPADDRESS:
+  case VarbindType::OPAQUE:
+    writeOctets(tag, binding.data);
+    break;
+  case VarbindType::OBJECTIDENTIFIER:
+    writeOid(binding.data);
+    break;
+  default:
+    writeNull(tag);
+    break;
+  }
+  close(mark);
+}
+
+/**
+ * @function size
+ * @description returns the amount of bytes encoded
+ * @returns size_t
+**/
+
+size_t BerWriter::size() {
+  return buffer.length();
+}
+
+/**
+ * @function truncate
+ * @description drop the bytes encoded after size
+ * @param size_t size
+**/
+
+void BerWriter::truncate(size_t size) {
+  buffer.resize(size);
+}
+
+/**
+ * @function getBuffer
+ * @description returns encoded bytes, valid until next clear
+ * @returns const std::string&
+**/
+
+const std::string& BerWriter::getBuffer() {
+  return buffer;
+}
+
+/**
+ * @function decodeMessage
+ * @description decode an SNMP message (v1/v2c community based)
+ * @param const char* data
+ * @param size_t data length
+ * @param message& decoded request
+ * @returns bool: false if message is malformed
+**/
+
+bool decodeMessage(const char* data, size_t length, message& request) {
+
+  BerReader reader(data, length);
+  BerReader messageReader(nullptr, 0);
+  int64_t version;
+  if (!reader.enter(BER_SEQUENCE, messageReader) || !messageReader.readInteger(version) || !messageReader.readOctets(BER_OCTETSTRING, request.community)) {
+    return false;
+  }
+  request.version = static_cast<int32_t>(version);
+  //PDU tag is peeked by readHeader
+  BerReader pduReader = messageReader;
+  uint8_t tag;
+  size_t pduLength;
+  if (!pduReader.readHeader(tag, pduLength) || tag < static_cast<uint8_t>(PduType::GET) || tag > static_cast<uint8_t>(PduType::REPORT)) {
+    return false;
+  }
+  request.type = static_cast<PduType>(tag);
+  if (!messageReader.enter(tag, pduReader)) {
+    return false;
+  }
+  int64_t requestId;
+  int64_t errorStatus;
+  int64_t errorIndex;
+  BerReader listReader(nullptr, 0);
+  if (!pduReader.readInteger(requestId) || !pduReader.readInteger(errorStatus) || !pduReader.readInteger(errorIndex) || !pduReader.enter(BER_SEQUENCE, listReader)) {
+    return false;
+  }
+  request.requestId = static_cast<int32_t>(requestId);
+  request.errorStatus = static_cast<int32_t>(errorStatus);
+  request.errorIndex = static_cast<int32_t>(errorIndex);
+  request.varbinds.clear();
+  while (!listReader.atEnd()) {
+    varbind binding;
+    if (!listReader.readVarbind(binding)) {
+      return false;
+    }
+    request.varbinds.push_back(binding);
+  }
+  return true;
+}
+
+/**
+ * @function encodeMessage
+ * @description encode an SNMP message; varbinds which would make it exceed maxSize are left out
+ * @param BerWriter& writer
+ * @param message
+ * @param size_t max message size
+ * @returns size_t: amount of varbinds encoded
+**/
+
+size_t encodeMessage(BerWriter& writer, const message& response, size_t maxSize /* = SNMP_MAX_MESSAGE */) {
+
+  writer.clear();
+  size_t messageMark = writer.open(BER_SEQUENCE);
+  writer.writeInteger(BER_INTEGER, response.version);
+  writer.writeOctets(BER_OCTETSTRING, response.community);
+  size_t pduMark = writer.open(static_cast<uint8_t>(response.type));
+  writer.writeInteger(BER_INTEGER, response.requestId);
+  writer.writeInteger(BER_INTEGER, response.errorStatus);
+  writer.writeInteger(BER_INTEGER, response.errorIndex);
+  size_t listMark = writer.open(BER_SEQUENCE);
+  //Below 64 KiB closing the sequences can only shrink their length fields
+  size_t encoded = 0;
+  for (auto& binding : response.varbinds) {
+    size_t mark = writer.size();
+    writer.writeVarbind(binding);
+    if (writer.size() > maxSize) {
+      writer.truncate(mark);
+      break;
+    }
+    encoded++;
+  }
+  writer.close(listMark);
+  writer.close(pduMark);
+  writer.close(messageMark);
+  return encoded;
+}
+
+} // namespace snmp
+}
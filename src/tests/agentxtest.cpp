@@ -0,0 +1,262 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * AgentX PDU encoding tests: PDUs written by PduWriter are read back by readHeader and PduReader,
+ * and truncated or malformed payloads are rejected. Run with 'make check'
+**/
+
+#include <agentx/pdu.hpp>
+#include <tests/check.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace murmure;
+using namespace murmure::agentx;
+
+/**
+ * @function makeBinding
+ * @description build a varbind
+ * @returns varbind
+**/
+
+static varbind makeBinding(VarbindType type, const std::string& oid, uint64_t number, const std::string& data) {
+  varbind binding;
+  binding.type = type;
+  binding.oid = oid;
+  binding.number = number;
+  binding.data = data;
+  return binding;
+}
+
+//Varbinds of every type, as a GET response would carry them
+static const std::vector<varbind> bindings = {
+  makeBinding(VarbindType::INTEGER, ".1.3.6.1.4.1.9999.1.0", 0xFFFFFFD6, ""),
+  makeBinding(VarbindType::COUNTER32, ".1.3.6.1.4.1.9999.2.0", 4000000000u, ""),
+  makeBinding(VarbindType::GAUGE32, ".1.3.6.1.4.1.9999.3.0", 7, ""),
+  makeBinding(VarbindType::TIMETICKS, ".1.3.6.1.4.1.9999.4.0", 123456, ""),
+  makeBinding(VarbindType::COUNTER64, ".1.3.6.1.4.1.9999.5.0", 0x0123456789ABCDEFull, ""),
+  makeBinding(VarbindType::OCTETSTRING, ".1.3.6.1.4.1.9999.6.0", 0, "hello"),
+  makeBinding(VarbindType::OCTETSTRING, ".1.3.6.1.4.1.9999.7.0", 0, ""),
+  makeBinding(VarbindType::IPADDRESS, ".1.3.6.1.4.1.9999.8.0", 0, std::string("\x0a\x00\x00\x01", 4)),
+  makeBinding(VarbindType::OPAQUE, ".1.3.6.1.4.1.9999.9.0", 0, std::string("\x00\xff\x10", 3)),
+  makeBinding(VarbindType::OBJECTIDENTIFIER, ".1.3.6.1.4.1.9999.10.0", 0, ".1.3.6.1.2.1.1.1"),
+  makeBinding(VarbindType::NULLVALUE, ".1.2.840.10006", 0, ""),
+  makeBinding(VarbindType::NOSUCHOBJECT, ".1.3.6.1.4.1.9999.11", 0, ""),
+  makeBinding(VarbindType::NOSUCHINSTANCE, ".1.3.6.1.4.1.9999.12.1", 0, ""),
+  makeBinding(VarbindType::ENDOFMIBVIEW, ".1.3.6.1.4.1.9999.13", 0, "")
+};
+
+/**
+ * @function writeResponse
+ * @description encode a RESPONSE PDU with all the test varbinds
+ * @param PduWriter&
+ * @returns std::string: encoded PDU
+**/
+
+static std::string writeResponse(PduWriter& writer) {
+  writer.begin(PduType::RESPONSE, 0, 0x01020304, 42, 0xDEADBEEF);
+  writer.writeUint32(1234); //sysUpTime
+  writer.writeUint16(AGENTX_ERR_NOERROR);
+  writer.writeUint16(0);
+  for (auto& binding : bindings) {
+    writer.writeVarbind(binding);
+  }
+  return writer.finish();
+}
+
+/**
+ * @function readResponse
+ * @description decode the payload written by writeResponse
+ * @param PduReader&
+ * @param std::vector<varbind>& decoded varbinds
+ * @returns bool: false if payload could not be decoded
+**/
+
+static bool readResponse(PduReader& reader, std::vector<varbind>& decoded) {
+  uint32_t upTime;
+  uint16_t error;
+  uint16_t index;
+  decoded.clear();
+  if (!reader.readUint32(upTime) || !reader.readUint16(error) || !reader.readUint16(index)) {
+    return false;
+  }
+  while (!reader.atEnd()) {
+    varbind binding;
+    if (!reader.readVarbind(binding)) {
+      return false;
+    }
+    decoded.push_back(binding);
+  }
+  return upTime == 1234 && error == AGENTX_ERR_NOERROR && index == 0;
+}
+
+static void testResponseRoundTrip() {
+  PduWriter writer;
+  std::string pdu = writeResponse(writer);
+  CHECK(pdu.length() % 4 == 0);
+  pduHeader header;
+  CHECK(readHeader(pdu.data(), header));
+  CHECK(header.type == PduType::RESPONSE);
+  CHECK((header.flags & AGENTX_FLAG_NETWORK_BYTE_ORDER) != 0);
+  CHECK(header.sessionId == 0x01020304);
+  CHECK(header.transactionId == 42);
+  CHECK(header.packetId == 0xDEADBEEF);
+  CHECK(header.payloadLength == pdu.length() - AGENTX_HEADER_SIZE);
+  PduReader reader(pdu.data() + AGENTX_HEADER_SIZE, header.payloadLength, true);
+  std::vector<varbind> decoded;
+  CHECK(readResponse(reader, decoded));
+  if (!CHECK(decoded.size() == bindings.size())) {
+    return;
+  }
+  for (size_t i = 0; i < bindings.size(); i++) {
+    CHECK(decoded[i].type == bindings[i].type);
+    CHECK(decoded[i].oid == bindings[i].oid);
+    CHECK(decoded[i].number == bindings[i].number);
+    CHECK(decoded[i].data == bindings[i].data);
+  }
+}
+
+static void testSearchRanges() {
+  PduWriter writer;
+  writer.begin(PduType::GETNEXT, 0, 1, 2, 3);
+  writer.writeOid(".1.3.6.1.4.1.9999", true);
+  writer.writeOid("");
+  writer.writeOid(".1.3.6.1.2.1.1", false);
+  writer.writeOid(".1.3.6.1.2.1.2", false);
+  const std::string& pdu = writer.finish();
+  PduReader reader(pdu.data() + AGENTX_HEADER_SIZE, pdu.length() - AGENTX_HEADER_SIZE, true);
+  searchRange range;
+  CHECK(reader.readSearchRange(range));
+  CHECK(range.start == ".1.3.6.1.4.1.9999");
+  CHECK(range.include);
+  CHECK(range.end.empty());
+  CHECK(reader.readSearchRange(range));
+  CHECK(range.start == ".1.3.6.1.2.1.1");
+  CHECK(!range.include);
+  CHECK(range.end == ".1.3.6.1.2.1.2");
+  CHECK(reader.atEnd());
+  CHECK(!reader.readSearchRange(range));
+}
+
+static void testOidPrefix() {
+  PduWriter writer;
+  //Internet prefix is compressed: 4 header bytes plus the sub-identifiers after 1.3.6.1.4
+  writer.begin(PduType::GET, 0, 0, 0, 0);
+  writer.writeOid(".1.3.6.1.4.1.9999");
+  CHECK(writer.finish().length() == AGENTX_HEADER_SIZE + 4 + 2 * 4);
+  //Other OIDs (and a fifth sub-identifier out of prefix range) are not
+  const std::vector<std::string> oids = {".1.2.840.10006", ".1.3.6.1", ".1.3.6.1.0.5", ".1.3.6.1.256.1", ".1.3.6.1.4.1.4294967295"};
+  for (auto& oid : oids) {
+    writer.begin(PduType::GET, 0, 0, 0, 0);
+    writer.writeOid(oid);
+    const std::string& pdu = writer.finish();
+    PduReader reader(pdu.data() + AGENTX_HEADER_SIZE, pdu.length() - AGENTX_HEADER_SIZE, true);
+    std::string decoded;
+    bool include;
+    CHECK(reader.readOid(decoded, include) && decoded == oid);
+  }
+}
+
+static void testHostByteOrder() {
+  //Master agents may send PDUs in little endian
+  const char header[AGENTX_HEADER_SIZE] = {1, static_cast<char>(PduType::GET), 0, 0, 4, 3, 2, 1, 9, 0, 0, 0, 1, 0, 0, 0, 8, 0, 0, 0};
+  pduHeader decoded;
+  CHECK(readHeader(header, decoded));
+  CHECK(decoded.sessionId == 0x01020304);
+  CHECK(decoded.transactionId == 9);
+  CHECK(decoded.packetId == 1);
+  CHECK(decoded.payloadLength == 8);
+  const char payload[] = {0x34, 0x12, 0x78, 0x56, 0x34, 0x12, 0x01, 0, 0, 0, 0x02, 0, 0, 0};
+  PduReader reader(payload, sizeof(payload), false);
+  uint16_t shortValue;
+  uint32_t value;
+  uint64_t longValue;
+  CHECK(reader.readUint16(shortValue) && shortValue == 0x1234);
+  CHECK(reader.readUint32(value) && value == 0x12345678);
+  CHECK(reader.readUint64(longValue) && longValue == 0x0000000200000001ull);
+  CHECK(reader.atEnd());
+}
+
+static void testTruncated() {
+  PduWriter writer;
+  std::string pdu = writeResponse(writer);
+  std::string payload = pdu.substr(AGENTX_HEADER_SIZE);
+  //Any truncation of a well formed payload must be detected, at any byte
+  for (size_t length = 0; length < payload.length(); length++) {
+    std::string truncated = payload.substr(0, length);
+    PduReader reader(truncated.data(), truncated.length(), true);
+    std::vector<varbind> decoded;
+    bool read = readResponse(reader, decoded);
+    //A cut between two varbinds is a shorter, valid, list
+    CHECK(!read || decoded.size() < bindings.size());
+  }
+  //Octet string length beyond payload
+  const char octets[] = {0x7F, static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), 'a', 'b', 'c', 'd'};
+  PduReader octetsReader(octets, sizeof(octets), true);
+  std::string value;
+  CHECK(!octetsReader.readOctets(value));
+  //Octet string without its padding
+  const char unpadded[] = {0, 0, 0, 3, 'a', 'b', 'c'};
+  PduReader unpaddedReader(unpadded, sizeof(unpadded), true);
+  CHECK(!unpaddedReader.readOctets(value));
+  //OID with more sub-identifiers than bytes
+  const char oid[] = {8, 0, 0, 0, 0, 0, 0, 1};
+  PduReader oidReader(oid, sizeof(oid), true);
+  bool include;
+  CHECK(!oidReader.readOid(value, include));
+  //Skipping past the end
+  PduReader skipReader(oid, sizeof(oid), true);
+  CHECK(!skipReader.skip(sizeof(oid) + 1));
+  CHECK(skipReader.skip(sizeof(oid)) && skipReader.atEnd());
+}
+
+static void testMalformed() {
+  PduWriter writer;
+  std::string pdu = writeResponse(writer);
+  //Unsupported version
+  pdu[0] = 2;
+  pduHeader header;
+  CHECK(!readHeader(pdu.data(), header));
+  //Unknown varbind type
+  writer.begin(PduType::RESPONSE, 0, 0, 0, 0);
+  writer.writeUint16(99);
+  writer.writeUint16(0);
+  writer.writeOid(".1.3.6.1.4.1.9999.1.0");
+  writer.writeUint32(0);
+  const std::string& unknown = writer.finish();
+  PduReader reader(unknown.data() + AGENTX_HEADER_SIZE, unknown.length() - AGENTX_HEADER_SIZE, true);
+  varbind binding;
+  CHECK(!reader.readVarbind(binding));
+}
+
+int main() {
+  testResponseRoundTrip();
+  testSearchRanges();
+  testOidPrefix();
+  testHostByteOrder();
+  testTruncated();
+  testMalformed();
+  return tests::report("agentx");
+}
@@ -0,0 +1,281 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * SNMP BER encoding tests: elements and messages written by BerWriter are read back by BerReader and decodeMessage,
+ * lengths in short and long form included, and truncated or malformed input is rejected. Run with 'make check'
+**/
+
+#include <snmp/ber.hpp>
+#include <tests/check.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace murmure;
+using namespace murmure::snmp;
+
+/**
+ * @function makeBinding
+ * @description build a varbind
+ * @returns varbind
+**/
+
+static varbind makeBinding(VarbindType type, const std::string& oid, uint64_t number, const std::string& data) {
+  varbind binding;
+  binding.type = type;
+  binding.oid = oid;
+  binding.number = number;
+  binding.data = data;
+  return binding;
+}
+
+/**
+ * @function readOid
+ * @description decode a single OBJECT IDENTIFIER element
+ * @param std::string encoded element
+ * @param std::string& dotted OID
+ * @returns bool: false if element is not valid
+**/
+
+static bool readOid(const std::string& encoded, std::string& oid) {
+  BerReader reader(encoded.data(), encoded.length());
+  return reader.readOid(oid) && reader.atEnd();
+}
+
+static void testIntegers() {
+  const std::vector<int64_t> values = {0, 1, 127, 128, 255, 256, -1, -128, -129, -32768, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN};
+  BerWriter writer;
+  for (auto& value : values) {
+    writer.clear();
+    writer.writeInteger(BER_INTEGER, value);
+    BerReader reader(writer.getBuffer().data(), writer.size());
+    int64_t decoded;
+    CHECK(reader.readInteger(decoded) && decoded == value && reader.atEnd());
+  }
+  //Shortest form
+  writer.clear();
+  writer.writeInteger(BER_INTEGER, 128);
+  CHECK(writer.getBuffer() == std::string("\x02\x02\x00\x80", 4));
+  writer.clear();
+  writer.writeInteger(BER_INTEGER, -128);
+  CHECK(writer.getBuffer() == std::string("\x02\x01\x80", 3));
+  const std::vector<uint64_t> unsignedValues = {0, 0x7F, 0x80, 0xFFFFFFFF, UINT64_MAX};
+  for (auto& value : unsignedValues) {
+    writer.clear();
+    writer.writeUnsigned(static_cast<uint8_t>(VarbindType::COUNTER64), value);
+    BerReader reader(writer.getBuffer().data(), writer.size());
+    uint64_t decoded;
+    CHECK(reader.readUnsigned(static_cast<uint8_t>(VarbindType::COUNTER64), decoded) && decoded == value && reader.atEnd());
+  }
+  //Empty and oversized contents
+  int64_t value;
+  BerReader empty("\x02\x00", 2);
+  CHECK(!empty.readInteger(value));
+  const std::string nineBytes("\x02\x09\x01\x00\x00\x00\x00\x00\x00\x00\x00", 11);
+  BerReader oversized(nineBytes.data(), nineBytes.length());
+  CHECK(!oversized.readInteger(value));
+}
+
+static void testLengths() {
+  BerWriter writer;
+  //Content lengths around the short/long form boundaries: header is tag plus 1, 2, 3 or 4 length bytes
+  const std::vector<size_t> lengths = {0, 1, 127, 128, 255, 256, 65535, 65536};
+  const std::vector<size_t> headerSizes = {2, 2, 2, 3, 3, 4, 4, 5};
+  for (size_t i = 0; i < lengths.size(); i++) {
+    std::string content(lengths[i], 'x');
+    writer.clear();
+    writer.writeOctets(BER_OCTETSTRING, content);
+    CHECK(writer.size() == headerSizes[i] + lengths[i]);
+    BerReader reader(writer.getBuffer().data(), writer.size());
+    std::string decoded;
+    CHECK(reader.readOctets(BER_OCTETSTRING, decoded) && decoded == content && reader.atEnd());
+  }
+  //Long form is accepted also when not minimal
+  BerReader nonMinimal("\x04\x82\x00\x02" "ab", 6);
+  std::string decoded;
+  CHECK(nonMinimal.readOctets(BER_OCTETSTRING, decoded) && decoded == "ab");
+  //Indefinite length and lengths longer than 4 bytes are not
+  uint8_t tag;
+  size_t length;
+  BerReader indefinite("\x30\x80\x00\x00", 4);
+  CHECK(!indefinite.readHeader(tag, length));
+  BerReader fiveBytes("\x04\x85\x00\x00\x00\x00\x01" "a", 8);
+  CHECK(!fiveBytes.readHeader(tag, length));
+  //Multi-byte tags
+  BerReader longTag("\x1F\x01\x00", 3);
+  CHECK(!longTag.readHeader(tag, length));
+}
+
+static void testTruncatedLengths() {
+  uint8_t tag;
+  size_t length;
+  //Length bytes missing
+  BerReader noLength("\x04", 1);
+  CHECK(!noLength.readHeader(tag, length));
+  BerReader shortLongForm("\x04\x82\x01", 3);
+  CHECK(!shortLongForm.readHeader(tag, length));
+  //Content shorter than length, in short and long form
+  BerReader shortContent("\x04\x05" "abcd", 6);
+  CHECK(!shortContent.readHeader(tag, length));
+  BerReader shortLongContent("\x04\x81\x80" "abcd", 7);
+  CHECK(!shortLongContent.readHeader(tag, length));
+  BerReader hugeLength("\x04\x84\xFF\xFF\xFF\xFF" "abcd", 10);
+  CHECK(!hugeLength.readHeader(tag, length));
+  //Inner element longer than its enclosing sequence
+  BerReader outer("\x30\x03\x04\x05" "abcde", 9);
+  BerReader inner(nullptr, 0);
+  std::string octets;
+  CHECK(outer.enter(BER_SEQUENCE, inner) && !inner.readOctets(BER_OCTETSTRING, octets));
+}
+
+static void testOids() {
+  BerWriter writer;
+  const std::vector<std::string> oids = {".1.3.6.1.4.1.9999.1.0", ".1.3", ".0.0", ".2.999.1", ".1.3.6.1.4.1.4294967295", ".2.4294967215"};
+  for (auto& oid : oids) {
+    writer.clear();
+    writer.writeOid(oid);
+    std::string decoded;
+    CHECK(readOid(writer.getBuffer(), decoded) && decoded == oid);
+  }
+  //1.3.6.1.2.1 in its well known encoding
+  writer.clear();
+  writer.writeOid(".1.3.6.1.2.1");
+  CHECK(writer.getBuffer() == std::string("\x06\x05\x2B\x06\x01\x02\x01", 7));
+  std::string decoded;
+  //Arcs beyond 32 bits: 2^32 (5 bytes) and a 10 byte arc
+  CHECK(!readOid(std::string("\x06\x06\x2B\x90\x80\x80\x80\x00", 8), decoded));
+  CHECK(!readOid(std::string("\x06\x0B\x2B\x81\x81\x81\x81\x81\x81\x81\x81\x81\x01", 13), decoded));
+  //Largest 32 bit arc is accepted
+  CHECK(readOid(std::string("\x06\x06\x2B\x8F\xFF\xFF\xFF\x7F", 8), decoded) && decoded == ".1.3.4294967295");
+  //Last arc not terminated
+  CHECK(!readOid(std::string("\x06\x02\x2B\x86", 4), decoded));
+}
+
+static void testGetBulkRoundTrip() {
+  message request;
+  request.version = SNMP_VERSION_2C;
+  request.community = "public";
+  request.type = PduType::GETBULK;
+  request.requestId = 0x7FFFFFFF;
+  request.errorStatus = 1;  //Non repeaters
+  request.errorIndex = 25;  //Max repetitions
+  request.varbinds.push_back(makeBinding(VarbindType::NULLVALUE, ".1.3.6.1.2.1.1.3", 0, ""));
+  request.varbinds.push_back(makeBinding(VarbindType::NULLVALUE, ".1.3.6.1.4.1.9999", 0, ""));
+  BerWriter writer;
+  CHECK(encodeMessage(writer, request) == 2);
+  message decoded;
+  CHECK(decodeMessage(writer.getBuffer().data(), writer.size(), decoded));
+  CHECK(decoded.version == SNMP_VERSION_2C);
+  CHECK(decoded.community == "public");
+  CHECK(decoded.type == PduType::GETBULK);
+  CHECK(decoded.requestId == 0x7FFFFFFF);
+  CHECK(decoded.errorStatus == 1);
+  CHECK(decoded.errorIndex == 25);
+  if (CHECK(decoded.varbinds.size() == 2)) {
+    CHECK(decoded.varbinds[0].oid == ".1.3.6.1.2.1.1.3" && decoded.varbinds[0].type == VarbindType::NULLVALUE);
+    CHECK(decoded.varbinds[1].oid == ".1.3.6.1.4.1.9999" && decoded.varbinds[1].type == VarbindType::NULLVALUE);
+  }
+  //Any truncation is rejected
+  for (size_t length = 0; length < writer.size(); length++) {
+    CHECK(!decodeMessage(writer.getBuffer().data(), length, decoded));
+  }
+
+  //Response with values of every type, long enough to need long form lengths
+  message response = request;
+  response.type = PduType::RESPONSE;
+  response.errorStatus = 0;
+  response.errorIndex = 0;
+  response.varbinds.clear();
+  for (uint32_t i = 1; i <= 50; i++) {
+    std::string prefix = ".1.3.6.1.4.1.9999." + std::to_string(i);
+    response.varbinds.push_back(makeBinding(VarbindType::INTEGER, prefix + ".1", static_cast<uint32_t>(-static_cast<int32_t>(i)), ""));
+    response.varbinds.push_back(makeBinding(VarbindType::COUNTER32, prefix + ".2", 0xFFFFFFFF, ""));
+    response.varbinds.push_back(makeBinding(VarbindType::GAUGE32, prefix + ".3", i, ""));
+    response.varbinds.push_back(makeBinding(VarbindType::TIMETICKS, prefix + ".4", i * 100, ""));
+    response.varbinds.push_back(makeBinding(VarbindType::COUNTER64, prefix + ".5", UINT64_MAX - i, ""));
+    response.varbinds.push_back(makeBinding(VarbindType::OCTETSTRING, prefix + ".6", 0, std::string(i * 3, 'v')));
+    response.varbinds.push_back(makeBinding(VarbindType::IPADDRESS, prefix + ".7", 0, std::string("\x0a\x00\x00\x01", 4)));
+    response.varbinds.push_back(makeBinding(VarbindType::OBJECTIDENTIFIER, prefix + ".8", 0, ".1.3.6.1.2.1.1.1"));
+  }
+  response.varbinds.push_back(makeBinding(VarbindType::ENDOFMIBVIEW, ".1.3.6.1.4.1.9999.51", 0, ""));
+  CHECK(encodeMessage(writer, response) == response.varbinds.size());
+  CHECK(decodeMessage(writer.getBuffer().data(), writer.size(), decoded));
+  if (CHECK(decoded.varbinds.size() == response.varbinds.size())) {
+    for (size_t i = 0; i < response.varbinds.size(); i++) {
+      CHECK(decoded.varbinds[i].type == response.varbinds[i].type);
+      CHECK(decoded.varbinds[i].oid == response.varbinds[i].oid);
+      CHECK(decoded.varbinds[i].number == response.varbinds[i].number);
+      CHECK(decoded.varbinds[i].data == response.varbinds[i].data);
+    }
+  }
+  //Varbinds which don't fit are left out, the message stays valid
+  size_t encoded = encodeMessage(writer, response, 1000);
+  CHECK(encoded > 0 && encoded < response.varbinds.size());
+  CHECK(writer.size() <= 1000);
+  CHECK(decodeMessage(writer.getBuffer().data(), writer.size(), decoded) && decoded.varbinds.size() == encoded);
+}
+
+static void testMalformedMessages() {
+  message decoded;
+  //PDU tag out of range
+  const std::string badPdu("\x30\x0F\x02\x01\x01\x04\x01" "p" "\xA9\x07\x02\x01\x01\x02\x01\x00\x02\x01\x00", 17);
+  CHECK(!decodeMessage(badPdu.data(), badPdu.length(), decoded));
+  //Varbind value with unknown tag
+  BerWriter writer;
+  size_t mark = writer.open(BER_SEQUENCE);
+  writer.writeOid(".1.3.6.1.4.1.9999.1");
+  writer.writeNull(0x49);
+  writer.close(mark);
+  BerReader reader(writer.getBuffer().data(), writer.size());
+  varbind binding;
+  CHECK(!reader.readVarbind(binding));
+  //INTEGER value out of 32 bit range
+  writer.clear();
+  mark = writer.open(BER_SEQUENCE);
+  writer.writeOid(".1.3.6.1.4.1.9999.1");
+  writer.writeInteger(BER_INTEGER, static_cast<int64_t>(INT32_MAX) + 1);
+  writer.close(mark);
+  BerReader integerReader(writer.getBuffer().data(), writer.size());
+  CHECK(!integerReader.readVarbind(binding));
+  //Trailing data after the value
+  writer.clear();
+  mark = writer.open(BER_SEQUENCE);
+  writer.writeOid(".1.3.6.1.4.1.9999.1");
+  writer.writeNull(BER_NULL);
+  writer.writeNull(BER_NULL);
+  writer.close(mark);
+  BerReader trailingReader(writer.getBuffer().data(), writer.size());
+  CHECK(!trailingReader.readVarbind(binding));
+}
+
+int main() {
+  testIntegers();
+  testLengths();
+  testTruncatedLengths();
+  testOids();
+  testGetBulkRoundTrip();
+  testMalformedMessages();
+  return tests::report("ber");
+}
@@ -0,0 +1,142 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+/**
+ * Cron schedule tests: field syntax (lists, ranges, steps), invalid expressions, and the day of month / day of week rule.
+ * Times are UTC. Run with 'make check'
+**/
+
+#include <mibscheduler/cronschedule.hpp>
+#include <tests/check.hpp>
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace murmure;
+
+/**
+ * @function utc
+ * @description build a UTC time
+ * @returns time_t
+**/
+
+static time_t utc(int year, int month, int day, int hour, int minute) {
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mon = month - 1;
+  date.tm_mday = day;
+  date.tm_hour = hour;
+  date.tm_min = minute;
+  return timegm(&date);
+}
+
+/**
+ * @function checkRuns
+ * @description check the next runs of a cron expression
+ * @param std::string expression
+ * @param time_t start
+ * @param std::vector<time_t> expected next runs, in order
+**/
+
+static void checkRuns(const std::string& expression, time_t start, const std::vector<time_t>& expected) {
+  CronSchedule schedule;
+  std::string error;
+  if (!CHECK(schedule.parse(expression, error))) {
+    return;
+  }
+  time_t last = start;
+  for (auto& run : expected) {
+    time_t previous = last;
+    last = schedule.next(last);
+    if (!CHECK(last == run)) {
+      std::cerr << "'" << expression << "' after " << previous << ": got " << last << ", expected " << run << std::endl;
+      return;
+    }
+  }
+}
+
+static void testFields() {
+  time_t start = utc(2024, 1, 1, 0, 7);
+  //Steps over the whole range and from a value
+  checkRuns("*/15 * * * *", start, {utc(2024, 1, 1, 0, 15), utc(2024, 1, 1, 0, 30), utc(2024, 1, 1, 0, 45), utc(2024, 1, 1, 1, 0)});
+  checkRuns("50/5 * * * *", start, {utc(2024, 1, 1, 0, 50), utc(2024, 1, 1, 0, 55), utc(2024, 1, 1, 1, 50)});
+  //Lists and ranges
+  checkRuns("5,10 * * * *", start, {utc(2024, 1, 1, 0, 10), utc(2024, 1, 1, 1, 5), utc(2024, 1, 1, 1, 10)});
+  checkRuns("0 9-11 * * *", start, {utc(2024, 1, 1, 9, 0), utc(2024, 1, 1, 10, 0), utc(2024, 1, 1, 11, 0), utc(2024, 1, 2, 9, 0)});
+  //Range with step, combined in a list
+  checkRuns("0 9-17/4,22 * * *", start, {utc(2024, 1, 1, 9, 0), utc(2024, 1, 1, 13, 0), utc(2024, 1, 1, 17, 0), utc(2024, 1, 1, 22, 0), utc(2024, 1, 2, 9, 0)});
+  //Months; the first run is on the next matching month
+  checkRuns("30 6 1 6,12 *", start, {utc(2024, 6, 1, 6, 30), utc(2024, 12, 1, 6, 30), utc(2025, 6, 1, 6, 30)});
+  //Next run is strictly after the given time
+  checkRuns("7 0 * * *", start, {utc(2024, 1, 2, 0, 7)});
+  //Leap day
+  checkRuns("0 0 29 2 *", start, {utc(2024, 2, 29, 0, 0), utc(2028, 2, 29, 0, 0)});
+}
+
+static void testDays() {
+  //2024-01-01 is a monday
+  time_t start = utc(2023, 12, 31, 12, 0);
+  //Day of week only; sunday is both 0 and 7
+  checkRuns("0 0 * * 1", start, {utc(2024, 1, 1, 0, 0), utc(2024, 1, 8, 0, 0)});
+  checkRuns("0 0 * * 7", start, {utc(2024, 1, 7, 0, 0), utc(2024, 1, 14, 0, 0)});
+  checkRuns("0 0 * * 0", start, {utc(2024, 1, 7, 0, 0)});
+  checkRuns("0 0 * * 5-6", start, {utc(2024, 1, 5, 0, 0), utc(2024, 1, 6, 0, 0), utc(2024, 1, 12, 0, 0)});
+  //Day of month only
+  checkRuns("0 0 15 * *", start, {utc(2024, 1, 15, 0, 0), utc(2024, 2, 15, 0, 0)});
+  //Both restricted: either matches (the 1st and mondays)
+  checkRuns("0 0 1 * 1", start, {utc(2024, 1, 1, 0, 0), utc(2024, 1, 8, 0, 0), utc(2024, 1, 15, 0, 0), utc(2024, 1, 22, 0, 0), utc(2024, 1, 29, 0, 0), utc(2024, 2, 1, 0, 0), utc(2024, 2, 5, 0, 0)});
+  checkRuns("0 0 1-2 * 3", start, {utc(2024, 1, 1, 0, 0), utc(2024, 1, 2, 0, 0), utc(2024, 1, 3, 0, 0), utc(2024, 1, 10, 0, 0)});
+  //A field starting with '*' is not restricted, even with a step: both have to match (odd days which are mondays)
+  checkRuns("0 0 */2 * 1", start, {utc(2024, 1, 1, 0, 0), utc(2024, 1, 15, 0, 0), utc(2024, 1, 29, 0, 0), utc(2024, 2, 5, 0, 0), utc(2024, 2, 19, 0, 0)});
+  //The 1st of the month, on even days of week
+  checkRuns("0 0 1 * */2", start, {utc(2024, 2, 1, 0, 0), utc(2024, 6, 1, 0, 0), utc(2024, 8, 1, 0, 0)});
+}
+
+static void testInvalid() {
+  const std::vector<std::string> expressions = {"", "* * * *", "* * * * * *", "60 * * * *", "* 24 * * *", "* * 0 * *", "* * 32 * *", "* * * 13 *",
+                                                 "* * * * 8", "*/0 * * * *", "*/-1 * * * *", "5-1 * * * *", "a * * * *", "1- * * * *", "1,,2 * * * *", "** * * * *"};
+  for (auto& expression : expressions) {
+    CronSchedule schedule;
+    std::string error;
+    if (!CHECK(!schedule.parse(expression, error))) {
+      std::cerr << "accepted: '" << expression << "'" << std::endl;
+    }
+    CHECK(!schedule.isSet() && schedule.next(0) == -1);
+  }
+  //Valid, but never matching
+  CronSchedule impossible;
+  std::string error;
+  CHECK(impossible.parse("0 0 30 2 *", error) && impossible.next(utc(2024, 1, 1, 0, 0)) == -1);
+}
+
+int main() {
+  //Schedules are in local time
+  setenv("TZ", "UTC", 1);
+  tzset();
+  testFields();
+  testDays();
+  testInvalid();
+  return tests::report("cron");
+}
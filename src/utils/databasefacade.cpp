@@ -25,17 +25,42 @@
 
 #include <sqlite3.h>
 
+#include <mutex>
+#include <thread>
+
 using namespace database;
 
 std::string databasePath;
 sqlite3* db;
-sqlite3_stmt* statement;
 bool isOpen = false; //Is database open?
+bool inTransaction = false; //Is a transaction open? Database is kept open until it ends
+std::thread::id transactionOwner; //Thread which opened the transaction; other threads mustn't join it
+std::mutex dbMutex;  //Serializes database access among threads
 
 void database::init(const std::string& dbPath) {
   databasePath = dbPath;
 }
 
+/**
+ * @function connect
+ * @description Open a connection to database
+ * @param sqlite3**: connection
+ * @param std::string&: error string pointer
+ * @returns bool: True if open succeeded
+**/
+
+bool connect(sqlite3** connection, std::string& error) {
+
+  if (sqlite3_open(databasePath.c_str(), connection) != SQLITE_OK) {
+    error = std::string(sqlite3_errmsg(*connection));
+    sqlite3_close(*connection);
+    return false;
+  }
+  //Other processes (e.g. event commands running murmure -C) may be writing
+  sqlite3_busy_timeout(*connection, DATABASE_BUSY_TIMEOUT);
+  return true;
+}
+
 /**
  * @function open
  * @description Open database
@@ -46,13 +71,11 @@ void database::init(const std::string& dbPath) {
 bool open(std::string& error) {
 
   if (!isOpen) {
-    if (sqlite3_open(databasePath.c_str(), &db) == SQLITE_OK) {
-      isOpen = true;
-      return true;
-    } else {
-      error = std::string(sqlite3_errmsg(db));
+    if (!connect(&db, error)) {
       return false;
     }
+    isOpen = true;
+    return true;
   } else {
     error = "Database already open";
     return true;
@@ -81,42 +104,100 @@ bool close(std::string& error) {
 
   isOpen = false;
   db = NULL;
-  statement = NULL;
 
   return true;
 }
 
 /**
- * @function exec
- * @description Exec a change in the database (e.g. update, insert, create, delete)
- * @param std::string query to exec
+ * @function withConnection
+ * @description Run an operation on database; database is opened around it, unless the calling thread's transaction keeps it open.
+ * While another thread is in a transaction, the operation is run on a connection of its own, so that it doesn't join that transaction
+ * (it waits for it to be committed to write, instead)
+ * @param Operation: callable taking the connection (sqlite3*) and the error string pointer, returning bool
  * @param std::string&: error string pointer
  * @returns bool: True if succeeded
 **/
 
-bool database::exec(std::string query, std::string& error) {
+template <typename Operation>
+bool withConnection(Operation operation, std::string& error) {
 
+  std::unique_lock<std::mutex> lock(dbMutex);
+  if (inTransaction && transactionOwner != std::this_thread::get_id()) {
+    lock.unlock();
+    sqlite3* connection;
+    if (!connect(&connection, error)) {
+      return false;
+    }
+    bool rc = operation(connection, error);
+    sqlite3_close(connection);
+    return rc;
+  }
   //Open database
   if (!open(error)) {
     return false;
   }
-  char* errMsg = 0;
-  bool rc;
-  //Exec query
-  if (sqlite3_exec(db, query.c_str(), NULL, 0, &errMsg) == SQLITE_OK) {
-    sqlite3_free(errMsg);
-    rc = true;
-  } else {
-    error = std::string(errMsg);
-    sqlite3_free(errMsg);
-    rc = false;
-  }
-  if (!close(error)) {
+  bool rc = operation(db, error);
+  if (!inTransaction && !close(error)) {
     return false;
   }
   return rc;
 }
 
+/**
+ * @function exec
+ * @description Exec a change in the database (e.g. update, insert, create, delete)
+ * @param std::string query to exec
+ * @param std::string&: error string pointer
+ * @returns bool: True if succeeded
+**/
+
+bool database::exec(std::string query, std::string& error) {
+
+  return withConnection([&query](sqlite3* connection, std::string& error) {
+    char* errMsg = 0;
+    bool rc;
+    //Exec query
+    if (sqlite3_exec(connection, query.c_str(), NULL, 0, &errMsg) == SQLITE_OK) {
+      sqlite3_free(errMsg);
+      rc = true;
+    } else {
+      error = std::string(errMsg);
+      sqlite3_free(errMsg);
+      rc = false;
+    }
+    return rc;
+  }, error);
+}
+
+/**
+ * @function execBatch
+ * @description Exec a list of changes atomically, in a single write
+ * @param std::vector<std::string> queries to exec
+ * @param std::string&: error string pointer
+ * @returns bool: True if all the changes succeeded; if any fails, none is applied
+ * NOTE: a savepoint is used, so that changes nest in the transaction opened by begin, if any
+**/
+
+bool database::execBatch(const std::vector<std::string>& queries, std::string& error) {
+
+  return withConnection([&queries](sqlite3* connection, std::string& error) {
+    char* errMsg = 0;
+    bool rc = sqlite3_exec(connection, "SAVEPOINT batch;", NULL, 0, &errMsg) == SQLITE_OK;
+    for (size_t i = 0; rc && i < queries.size(); i++) {
+      rc = sqlite3_exec(connection, queries[i].c_str(), NULL, 0, &errMsg) == SQLITE_OK;
+    }
+    if (rc) {
+      rc = sqlite3_exec(connection, "RELEASE batch;", NULL, 0, &errMsg) == SQLITE_OK;
+    }
+    if (!rc) {
+      error = errMsg != 0 ? std::string(errMsg) : std::string(sqlite3_errmsg(connection));
+      sqlite3_exec(connection, "ROLLBACK TO batch; RELEASE batch;", NULL, 0, NULL);
+    }
+    sqlite3_free(errMsg);
+    return rc;
+  }, error);
+}
+
 /**
  * @function select
  * @description Select from database
@@ -127,49 +208,134 @@ bool database::exec(std::string query, std::string& error) {
 **/
 
 bool database::select(std::vector<std::vector<std::string>>* result, std::string query, std::string& error) {
-  //Open database
-  if (!open(error)) {
-    return false;
-  }
-  //Empty result vector
-  result->clear();
 
-  size_t vectorSize = 0;
-  if (sqlite3_prepare_v2(db, query.c_str(), query.size(), &statement, NULL) != SQLITE_OK) {
-    error = std::string(sqlite3_errmsg(db));
+  return withConnection([result, &query](sqlite3* connection, std::string& error) {
+    //Empty result vector
+    result->clear();
+
+    size_t vectorSize = 0;
+    sqlite3_stmt* statement;
+    if (sqlite3_prepare_v2(connection, query.c_str(), query.size(), &statement, NULL) != SQLITE_OK) {
+      error = std::string(sqlite3_errmsg(connection));
+      sqlite3_finalize(statement);
+      return false;
+    }
+    //Iterate over rows
+    int stepCode;
+    bool res = true;
+    do {
+      stepCode = sqlite3_step(statement);
+      if (stepCode != SQLITE_ROW && stepCode != SQLITE_DONE) {
+        //Is error
+        error = std::string(sqlite3_errmsg(connection));
+        res = false;
+      } else if (stepCode == SQLITE_ROW) {
+        //Is SQLITE_ROW
+        const int columnCount = sqlite3_column_count(statement);
+        std::vector<std::string> row;
+        row.reserve(columnCount);
+        for (int i = 0; i < columnCount; i++) {
+          //Push columns to row vector
+          std::string column = std::string(reinterpret_cast<char*>(const_cast<unsigned char*>(sqlite3_column_text(statement, i))));
+          row.push_back(column);
+        }
+        //Push row to result vector
+        result->resize(vectorSize++);
+        result->push_back(row);
+      }
+    } while (stepCode == SQLITE_ROW);
+    //SQLITE_DONE
+
+    sqlite3_reset(statement);
     sqlite3_finalize(statement);
+    return res;
+  }, error);
+}
+
+/**
+ * @function endTransaction
+ * @description terminate the open transaction and close database; database mutex must be held
+ * @param const char*: statement terminating the transaction (COMMIT/ROLLBACK)
+ * @param std::string&: error string pointer
+ * @returns bool: True if succeeded
+**/
+
+bool endTransaction(const char* statement, std::string& error) {
+
+  if (!inTransaction) {
+    error = "No transaction is open";
     return false;
   }
-  //Iterate over rows
-  int stepCode;
-  bool res = true;
-  do {
-    stepCode = sqlite3_step(statement);
-    if (stepCode != SQLITE_ROW && stepCode != SQLITE_DONE) {
-      //Is error
-      error = std::string(sqlite3_errmsg(db));
-      res = false;
-    } else if (stepCode == SQLITE_ROW) {
-      //Is SQLITE_ROW
-      const int columnCount = sqlite3_column_count(statement);
-      std::vector<std::string> row;
-      row.reserve(columnCount);
-      for (int i = 0; i < columnCount; i++) {
-        //Push columns to row vector
-        std::string column = std::string(reinterpret_cast<char*>(const_cast<unsigned char*>(sqlite3_column_text(statement, i))));
-        row.push_back(column);
-      }
-      //Push row to result vector
-      result->resize(vectorSize++);
-      result->push_back(row);
-    }
-  } while (stepCode == SQLITE_ROW);
-  //SQLITE_DONE
-
-  sqlite3_reset(statement);
-  sqlite3_finalize(statement);
+  if (transactionOwner != std::this_thread::get_id()) {
+    error = "Transaction was opened by another thread";
+    return false;
+  }
+  char* errMsg = 0;
+  bool rc = true;
+  if (sqlite3_exec(db, statement, NULL, 0, &errMsg) != SQLITE_OK) {
+    error = std::string(errMsg);
+    rc = false;
+  }
+  sqlite3_free(errMsg);
+  inTransaction = false;
   if (!close(error)) {
     return false;
   }
-  return res;
+  return rc;
+}
+
+/**
+ * @function begin
+ * @description Open a transaction; changes are written at once by commit, and database is kept open until then.
+ * The transaction belongs to the calling thread: other threads' statements are executed outside of it
+ * @param std::string&: error string pointer
+ * @returns bool: True if succeeded
+**/
+
+bool database::begin(std::string& error) {
+
+  std::lock_guard<std::mutex> lock(dbMutex);
+  if (inTransaction) {
+    error = "Transaction already open";
+    return false;
+  }
+  if (!open(error)) {
+    return false;
+  }
+  char* errMsg = 0;
+  if (sqlite3_exec(db, "BEGIN;", NULL, 0, &errMsg) != SQLITE_OK) {
+    error = std::string(errMsg);
+    sqlite3_free(errMsg);
+    std::string closeError;
+    close(closeError);
+    return false;
+  }
+  sqlite3_free(errMsg);
+  inTransaction = true;
+  transactionOwner = std::this_thread::get_id();
+  return true;
+}
+
+/**
+ * @function commit
+ * @description Commit the open transaction
+ * @param std::string&: error string pointer
+ * @returns bool: True if succeeded
+**/
+
+bool database::commit(std::string& error) {
+  std::lock_guard<std::mutex> lock(dbMutex);
+  return endTransaction("COMMIT;", error);
+}
+
+/**
+ * @function rollback
+ * @description Discard the changes of the open transaction
+ * @param std::string&: error string pointer
+ * @returns bool: True if succeeded
+**/
+
+bool database::rollback(std::string& error) {
+  std::lock_guard<std::mutex> lock(dbMutex);
+  return endTransaction("ROLLBACK;", error);
 }
@@ -47,6 +47,24 @@ bool getOpts(options* optStruct, int argc, char* argv[], std::string& error) {
     const std::string arg = argv[i];
     if (arg == "-D") {
       optStruct->command = Command::DAEMON;
+    } else if (arg == "-X" || arg == "--agentx") {
+      //Can have master agent socket as argument
+      optStruct->command = Command::AGENTX;
+      if (argc > (i + 1)) {
+        if (std::string(argv[i + 1]).at(0) != '-') {
+          optStruct->args.reserve(1);
+          optStruct->args.push_back(std::string(argv[++i]));
+        }
+      }
+    } else if (arg == "-P" || arg == "--snmp") {
+      //Can have [address:]port as argument
+      optStruct->command = Command::SNMP_AGENT;
+      if (argc > (i + 1)) {
+        if (std::string(argv[i + 1]).at(0) != '-') {
+          optStruct->args.reserve(1);
+          optStruct->args.push_back(std::string(argv[++i]));
+        }
+      }
     } else if (arg == "-g") {
       //Get has 1 arg => OID
       if (argc <= (i + 1)) {
@@ -76,6 +94,15 @@ bool getOpts(options* optStruct, int argc, char* argv[], std::string& error) {
       optStruct->command = Command::GET_NEXT;
       optStruct->args.reserve(1);
       optStruct->args.push_back(std::string(argv[++i]));
+    } else if (arg == "--walk") {
+      //Walk has 1 arg => subtree root OID
+      if (argc <= (i + 1)) {
+        error = "Missing OID argument";
+        return false;
+      }
+      optStruct->command = Command::WALK;
+      optStruct->args.reserve(1);
+      optStruct->args.push_back(std::string(argv[++i]));
     } else if (arg == "-M" || arg == "--parse-mib") {
       //Mib parsing has 2 arg => [rootOid, mib file]
       if (argc <= (i + 2)) {
@@ -104,6 +131,15 @@ bool getOpts(options* optStruct, int argc, char* argv[], std::string& error) {
           optStruct->args.push_back(std::string(argv[++i]));
         }
       }
+    } else if (arg == "--dump-metrics") {
+      //Can have file as argument
+      optStruct->command = Command::DUMP_METRICS;
+      if (argc > (i + 1)) {
+        if (std::string(argv[i + 1]).at(0) != '-') {
+          optStruct->args.reserve(1);
+          optStruct->args.push_back(std::string(argv[++i]));
+        }
+      }
     } else if (arg == "--reset") {
       optStruct->command = Command::RESET;
     } else if (arg == "-C" || arg == "--change") {
@@ -115,6 +151,15 @@ bool getOpts(options* optStruct, int argc, char* argv[], std::string& error) {
       optStruct->args.reserve(2);
       optStruct->args.push_back(std::string(argv[++i]));
       optStruct->args.push_back(std::string(argv[++i]));
+    } else if (arg == "--batch") {
+      //Batch has 1 arg => file of requests; '-' for stdin
+      if (argc <= (i + 1)) {
+        error = "Missing batch file argument";
+        return false;
+      }
+      optStruct->command = Command::BATCH;
+      optStruct->args.reserve(1);
+      optStruct->args.push_back(std::string(argv[++i]));
     } else if (arg == "-h" || arg == "--help") {
       optStruct->command = Command::HELP;
     } else if (arg == "-l") {
@@ -140,6 +185,81 @@ bool getOpts(options* optStruct, int argc, char* argv[], std::string& error) {
       }
       optStruct->logFileSet = true;
       optStruct->logFile = argv[++i];
+    } else if (arg == "-T") {
+      if (argc <= (i + 1)) {
+        error = "Missing execution timeout argument";
+        return false;
+      }
+      optStruct->execTimeoutSet = true;
+      try {
+        optStruct->execTimeout = std::stoi(argv[++i]);
+      } catch (std::invalid_argument& ex) {
+        error = "execution timeout is not a number";
+        return false;
+      }
+      if (optStruct->execTimeout < 0) {
+        error = "execution timeout can't be negative";
+        return false;
+      }
+    } else if (arg == "-Q") {
+      if (argc <= (i + 1)) {
+        error = "Missing execution class argument";
+        return false;
+      }
+      optStruct->execClasses.push_back(argv[++i]);
+    } else if (arg == "-U") {
+      if (argc <= (i + 1)) {
+        error = "Missing socket path argument";
+        return false;
+      }
+      optStruct->socketPathSet = true;
+      optStruct->socketPath = argv[++i];
+    } else if (arg == "-W") {
+      if (argc <= (i + 1)) {
+        error = "Missing workers argument";
+        return false;
+      }
+      optStruct->workersSet = true;
+      try {
+        optStruct->workers = std::stoi(argv[++i]);
+      } catch (std::invalid_argument& ex) {
+        error = "workers is not a number";
+        return false;
+      }
+      if (optStruct->workers < 1) {
+        error = "at least one worker is required";
+        return false;
+      }
+    } else if (arg == "-c" || arg == "--community") {
+      if (argc <= (i + 1)) {
+        error = "Missing community argument";
+        return false;
+      }
+      optStruct->communities.push_back(argv[++i]);
+    } else if (arg == "--snmp-threads") {
+      if (argc <= (i + 1)) {
+        error = "Missing SNMP threads argument";
+        return false;
+      }
+      optStruct->snmpThreadsSet = true;
+      try {
+        optStruct->snmpThreads = std::stoi(argv[++i]);
+      } catch (std::invalid_argument& ex) {
+        error = "SNMP threads is not a number";
+        return false;
+      }
+      if (optStruct->snmpThreads < 1) {
+        error = "at least one SNMP thread is required";
+        return false;
+      }
+    } else if (arg == "--ingest") {
+      //Can have ring file as argument
+      optStruct->ingestSet = true;
+      if (argc > (i + 1)) {
+        if (std::string(argv[i + 1]).at(0) != '-') {
+          optStruct->ingestPath = argv[++i];
+        }
+      }
     } else if (arg == "-d") {
       if (argc <= (i + 1)) {
         error = "Missing database path argument";
@@ -95,3 +95,46 @@ void logger::log(const std::string& component, int level, const std::string& log
   }
   return;
 }
+
+/**
+ * @function RateLimit
+ * @description class constructor
+ * @param std::string component the messages are logged for
+ * @param int log level of the messages
+ * @param unsigned amount of messages admitted per interval
+ * @param unsigned interval length in seconds
+**/
+
+RateLimit::RateLimit(const std::string& component, int level, unsigned burst, unsigned interval) : component(component), level(level), burst(burst), interval(interval), windowStart(0), admitted(0), suppressed(0) {
+}
+
+/**
+ * @function admit
+ * @description check whether a message can be logged; when an interval starts, the amount of messages suppressed
+ * in the previous one is logged. Callers should build the message only once it has been admitted
+ * @returns bool: true if the message has to be logged
+**/
+
+bool RateLimit::admit() {
+
+  //Check if this message has to be logged at all
+  if (level > logLevel) {
+    return false;
+  }
+  time_t now = time(nullptr);
+  time_t start = windowStart.load(std::memory_order_relaxed);
+  if (now - start >= interval && windowStart.compare_exchange_strong(start, now)) {
+    admitted = 0;
+    unsigned dropped = suppressed.exchange(0);
+    if (dropped > 0) {
+      std::stringstream logstream;
+      logstream << dropped << " similar messages suppressed in the last " << now - start << " seconds";
+      log(component, level, logstream.str());
+    }
+  }
+  if (admitted.fetch_add(1, std::memory_order_relaxed) < burst) {
+    return true;
+  }
+  suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
@@ -0,0 +1,745 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <utils/process.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#define EXECUTOR_MAX_MESSAGE 65536 //Max size of a request/response exchanged with the executor
+#define EXECUTOR_REPLY_GRACE 5000 //Time the executor is given to reply past command timeout and kill grace (ms)
+#define EXECUTOR_CHECK_INTERVAL 1000 //Interval between checks that the executor is alive while waiting for a reply (ms)
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_SHIFT 13
+#define EXECCLASS_AMOUNT 2
+
+extern char** environ;
+
+//Executor state (daemon side)
+static int executorFd = -1;
+static pid_t executorPid = -1;
+static uint32_t nextRequestId = 1;
+static bool readerActive = false;
+static std::map<uint32_t, std::string> executorReplies;
+static std::set<uint32_t> abandonedRequests; //Requests given up on; their late replies are discarded
+static std::mutex executorMutex;
+static std::condition_variable executorCond;
+
+//Execution classes state; waiting executions are ordered by (deadline, arrival)
+typedef std::pair<std::chrono::steady_clock::time_point, uint64_t> queueKey;
+static process::classSettings classes[EXECCLASS_AMOUNT] = {{0, 0, -1}, {DEFAULT_BACKGROUND_SLOTS, DEFAULT_BACKGROUND_NICENESS, DEFAULT_BACKGROUND_IOPRIORITY}};
+static int runningExecutions[EXECCLASS_AMOUNT] = {0, 0};
+static std::set<queueKey> classQueues[EXECCLASS_AMOUNT];
+static uint64_t nextArrival = 0;
+static std::mutex classMutex;
+static std::condition_variable classCond;
+
+static process::runHook commandHook = nullptr;
+
+/**
+ * @function drainOutput
+ * @description read available command output from pipe, keeping at most MAX_COMMAND_OUTPUT bytes
+ * @param int& pipe file descriptor; set to -1 when closed
+ * @param std::string& output
+**/
+
+static void drainOutput(int& outFd, std::string& output) {
+
+  char buffer[1024];
+  while (outFd >= 0) {
+    ssize_t readBytes = read(outFd, buffer, sizeof(buffer));
+    if (readBytes > 0) {
+      size_t room = output.length() < MAX_COMMAND_OUTPUT ? MAX_COMMAND_OUTPUT - output.length() : 0;
+      output.append(buffer, std::min(static_cast<size_t>(readBytes), room));
+    } else if (readBytes < 0 && errno == EINTR) {
+      continue;
+    } else if (readBytes < 0 && errno == EAGAIN) {
+      return;
+    } else {
+      //EOF or error
+      close(outFd);
+      outFd = -1;
+    }
+  }
+}
+
+/**
+ * @function waitChild
+ * @description wait for child termination, at most until deadline, collecting its output meanwhile
+ * @param pid_t child pid
+ * @param int& status
+ * @param time_point deadline
+ * @param int& output pipe file descriptor (-1 if closed)
+ * @param std::string& output
+ * @returns bool: true if child has terminated
+**/
+
+static bool waitChild(pid_t pid, int& status, std::chrono::steady_clock::time_point deadline, int& outFd, std::string& output) {
+
+  std::chrono::milliseconds pollInterval(1);
+  while (true) {
+    pid_t waitRes = waitpid(pid, &status, WNOHANG);
+    if (waitRes == pid || (waitRes < 0 && errno != EINTR)) {
+      drainOutput(outFd, output);
+      return true;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return false;
+    }
+    //Poll more rarely as time passes; wake up earlier if output is available
+    std::chrono::milliseconds wait = std::min(pollInterval, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+    if (outFd >= 0) {
+      struct pollfd pfd = {outFd, POLLIN, 0};
+      if (poll(&pfd, 1, static_cast<int>(wait.count())) > 0) {
+        drainOutput(outFd, output);
+      }
+    } else {
+      std::this_thread::sleep_for(wait);
+    }
+    pollInterval = std::min(pollInterval * 2, std::chrono::milliseconds(50));
+  }
+}
+
+/**
+ * @function runLocal
+ * @description execute a shell command in its own process group, forking from the current process
+ * @param std::string command to execute with /bin/sh
+ * @param std::vector<std::string> variables (NAME=value) to add to the environment
+ * @param int timeout in milliseconds; 0 to wait forever
+ * @param int time in milliseconds between SIGTERM and SIGKILL when timeout expires
+ * @param int nice increment of the command
+ * @param int best-effort I/O priority of the command; -1 to inherit
+ * @param execResult& result
+ * @param std::string& error string pointer
+ * @returns bool: true if command has been executed
+**/
+
+static bool runLocal(const std::string& command, const std::vector<std::string>& environment, int timeout, int killGrace, int niceness, int ioPriority, process::execResult& result, std::string& error) {
+
+  //Prepare arguments and environment before forking; variables must be NAME=value
+  std::vector<const std::string*> extraVariables;
+  for (auto& extra : environment) {
+    size_t eqPos = extra.find('=');
+    if (eqPos != std::string::npos && eqPos > 0) {
+      extraVariables.push_back(&extra);
+    }
+  }
+  std::vector<std::string> envStrings;
+  for (char** env = environ; *env != nullptr; env++) {
+    std::string variable(*env);
+    bool overridden = false;
+    for (auto& extra : extraVariables) {
+      size_t eqPos = extra->find('=');
+      if (variable.compare(0, eqPos + 1, *extra, 0, eqPos + 1) == 0) {
+        overridden = true;
+        break;
+      }
+    }
+    if (!overridden) {
+      envStrings.push_back(variable);
+    }
+  }
+  for (auto& extra : extraVariables) {
+    envStrings.push_back(*extra);
+  }
+  std::vector<char*> envp;
+  for (auto& variable : envStrings) {
+    envp.push_back(const_cast<char*>(variable.c_str()));
+  }
+  envp.push_back(nullptr);
+  const char* argv[] = {"/bin/sh", "-c", command.c_str(), nullptr};
+
+  //Command output is collected through a pipe (stdout and stderr)
+  int outPipe[2];
+  if (pipe2(outPipe, O_CLOEXEC) < 0) {
+    error = "pipe failed: " + std::string(strerror(errno));
+    return false;
+  }
+
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    error = "fork failed: " + std::string(strerror(errno));
+    close(outPipe[0]);
+    close(outPipe[1]);
+    return false;
+  } else if (pid == 0) {
+    //Child: new process group, so that the whole command tree can be killed
+    setpgid(0, 0);
+    //Apply execution class priority
+    if (niceness != 0) {
+      setpriority(PRIO_PROCESS, 0, getpriority(PRIO_PROCESS, 0) + niceness);
+    }
+    if (ioPriority >= 0) {
+      syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | ioPriority);
+    }
+    //Commands must not read daemon's stdin nor write to its stdout
+    int devNull = open("/dev/null", O_RDONLY);
+    if (devNull >= 0) {
+      dup2(devNull, STDIN_FILENO);
+    }
+    dup2(outPipe[1], STDOUT_FILENO);
+    dup2(outPipe[1], STDERR_FILENO);
+    execve("/bin/sh", const_cast<char**>(argv), envp.data());
+    _exit(127);
+  }
+  setpgid(pid, pid);
+  close(outPipe[1]);
+  int outFd = outPipe[0];
+  fcntl(outFd, F_SETFL, fcntl(outFd, F_GETFL) | O_NONBLOCK);
+
+  int status = 0;
+  result.timedOut = false;
+  result.output.clear();
+  std::chrono::steady_clock::time_point deadline = timeout <= 0 ? std::chrono::steady_clock::time_point::max() : startTime + std::chrono::milliseconds(timeout);
+  if (!waitChild(pid, status, deadline, outFd, result.output)) {
+    //Timeout expired: terminate gently, then kill
+    result.timedOut = true;
+    kill(-pid, SIGTERM);
+    if (!waitChild(pid, status, std::chrono::steady_clock::now() + std::chrono::milliseconds(killGrace), outFd, result.output)) {
+      kill(-pid, SIGKILL);
+      while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+      }
+    }
+  }
+  if (outFd >= 0) {
+    close(outFd);
+  }
+  result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+  result.signaled = WIFSIGNALED(status);
+  result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  return true;
+}
+
+//Message encoding: integers are in host byte order (both ends are the same binary); strings are length-prefixed
+
+static void putInt(std::string& buffer, int64_t value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putString(std::string& buffer, const std::string& value) {
+  putInt(buffer, static_cast<int64_t>(value.length()));
+  buffer.append(value);
+}
+
+static bool getInt(const std::string& buffer, size_t& offset, int64_t& value) {
+  if (offset + sizeof(value) > buffer.length()) {
+    return false;
+  }
+  memcpy(&value, buffer.data() + offset, sizeof(value));
+  offset += sizeof(value);
+  return true;
+}
+
+static bool getString(const std::string& buffer, size_t& offset, std::string& value) {
+  int64_t length;
+  if (!getInt(buffer, offset, length) || length < 0 || offset + static_cast<size_t>(length) > buffer.length()) {
+    return false;
+  }
+  value = buffer.substr(offset, static_cast<size_t>(length));
+  offset += static_cast<size_t>(length);
+  return true;
+}
+
+/**
+ * @function sendReply
+ * @description executor: send the result of a request back to the daemon
+ * @param int socket
+ * @param int64_t request id
+ * @param bool: true if command has been executed
+ * @param execResult& result
+ * @param std::string error, if command hasn't been executed
+ * @returns bool: true if reply has been sent
+**/
+
+static bool sendReply(int sockFd, int64_t requestId, bool executed, const process::execResult& result, const std::string& error) {
+
+  std::string response;
+  putInt(response, requestId);
+  putInt(response, executed ? 1 : 0);
+  putInt(response, executed ? result.exitCode : -1);
+  putInt(response, executed && result.signaled ? 1 : 0);
+  putInt(response, executed && result.timedOut ? 1 : 0);
+  putInt(response, executed ? result.duration.count() : 0);
+  putString(response, executed ? result.output : error);
+  return send(sockFd, response.data(), response.length(), MSG_NOSIGNAL) >= 0;
+}
+
+/**
+ * @function serveRequest
+ * @description executor: execute a request and send the response back to the daemon; every request with a readable id
+ * is replied to, failures included, so that the daemon doesn't wait for it
+ * @param int socket
+ * @param std::string request
+**/
+
+static void serveRequest(int sockFd, const std::string& request) {
+
+  size_t offset = 0;
+  int64_t requestId, timeout, killGrace, niceness, ioPriority, envAmount;
+  std::string command;
+  std::vector<std::string> environment;
+  process::execResult result;
+  if (!getInt(request, offset, requestId)) {
+    return;
+  }
+  bool valid = getInt(request, offset, timeout) && getInt(request, offset, killGrace) && getInt(request, offset, niceness) && getInt(request, offset, ioPriority) && getString(request, offset, command) && getInt(request, offset, envAmount);
+  for (int64_t i = 0; valid && i < envAmount; i++) {
+    std::string variable;
+    valid = getString(request, offset, variable);
+    environment.push_back(variable);
+  }
+  if (!valid) {
+    sendReply(sockFd, requestId, false, result, "Malformed request to executor");
+    return;
+  }
+
+  std::string error;
+  bool executed = runLocal(command, environment, static_cast<int>(timeout), static_cast<int>(killGrace), static_cast<int>(niceness), static_cast<int>(ioPriority), result, error);
+  if (!sendReply(sockFd, requestId, executed, result, error) && executed) {
+    sendReply(sockFd, requestId, false, result, "Could not send command result: " + std::string(strerror(errno)));
+  }
+}
+
+/**
+ * @function executorMain
+ * @description executor process main loop; each request is served by a forked runner, so requests run concurrently
+ * @param int socket
+**/
+
+static void executorMain(int sockFd) {
+
+  prctl(PR_SET_NAME, "murmure-exec", 0, 0, 0);
+  //Reloads are for the daemon only; runners are reaped automatically
+  signal(SIGHUP, SIG_IGN);
+  signal(SIGCHLD, SIG_IGN);
+  char* buffer = new char[EXECUTOR_MAX_MESSAGE];
+  while (true) {
+    ssize_t recvBytes = recv(sockFd, buffer, EXECUTOR_MAX_MESSAGE, 0);
+    if (recvBytes < 0 && errno == EINTR) {
+      continue;
+    } else if (recvBytes <= 0) {
+      //Daemon has terminated
+      break;
+    }
+    std::string request(buffer, static_cast<size_t>(recvBytes));
+    pid_t runner = fork();
+    if (runner == 0) {
+      //Runner waits for its own command; commands get default signal dispositions
+      signal(SIGCHLD, SIG_DFL);
+      signal(SIGHUP, SIG_DFL);
+      serveRequest(sockFd, request);
+      _exit(0);
+    } else if (runner < 0) {
+      //Could not fork the runner; serve the request synchronously
+      signal(SIGCHLD, SIG_DFL);
+      serveRequest(sockFd, request);
+      signal(SIGCHLD, SIG_IGN);
+    }
+  }
+  delete[] buffer;
+  _exit(0);
+}
+
+/**
+ * @function startExecutor
+ * @description fork the executor process, which forks and executes commands on behalf of the daemon.
+ * Since the executor is small, forking from it costs the same regardless of daemon's memory size;
+ * it should be started as early as possible (before loading the MIB and before starting any thread)
+ * @param std::string& error string pointer
+ * @returns bool: true if executor has been started
+**/
+
+bool process::startExecutor(std::string& error) {
+
+  if (executorPid >= 0) {
+    return true;
+  }
+  int sockPair[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockPair) < 0) {
+    error = "socketpair failed: " + std::string(strerror(errno));
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    error = "fork failed: " + std::string(strerror(errno));
+    close(sockPair[0]);
+    close(sockPair[1]);
+    return false;
+  } else if (pid == 0) {
+    close(sockPair[0]);
+    executorMain(sockPair[1]);
+  }
+  close(sockPair[1]);
+  executorFd = sockPair[0];
+  executorPid = pid;
+  return true;
+}
+
+/**
+ * @function stopExecutor
+ * @description stop the executor process; commands are forked by the current process from now on
+**/
+
+void process::stopExecutor() {
+
+  std::unique_lock<std::mutex> lock(executorMutex);
+  if (executorPid < 0) {
+    return;
+  }
+  //Executor terminates when the socket is closed
+  if (executorFd >= 0) {
+    shutdown(executorFd, SHUT_RDWR);
+  }
+  while (readerActive) {
+    executorCond.wait(lock);
+  }
+  if (executorFd >= 0) {
+    close(executorFd);
+    executorFd = -1;
+  }
+  while (waitpid(executorPid, nullptr, 0) < 0 && errno == EINTR) {
+  }
+  executorPid = -1;
+}
+
+/**
+ * @function dropExecutor
+ * @description close the connection to a dead executor; commands are forked locally from then on. Executor mutex must be held
+**/
+
+static void dropExecutor() {
+
+  if (executorFd >= 0) {
+    close(executorFd);
+    executorFd = -1;
+    waitpid(executorPid, nullptr, WNOHANG);
+  }
+  abandonedRequests.clear();
+  executorCond.notify_all();
+}
+
+/**
+ * @function runRemote
+ * @description execute a command through the executor; responses are demultiplexed by request id,
+ * the first waiting thread reads from the socket on behalf of the others.
+ * If the executor is gone before the request is sent, the command is forked locally; if it dies or doesn't reply
+ * within timeout, kill grace and EXECUTOR_REPLY_GRACE, the request is given up on
+ * @param std::string command to execute with /bin/sh
+ * @param std::vector<std::string> variables (NAME=value) to add to the environment
+ * @param int timeout in milliseconds; 0 to wait forever
+ * @param int time in milliseconds between SIGTERM and SIGKILL when timeout expires
+ * @param int nice increment of the command
+ * @param int best-effort I/O priority of the command; -1 to inherit
+ * @param execResult& result
+ * @param std::string& error string pointer
+ * @returns bool: true if command has been executed
+**/
+
+static bool runRemote(const std::string& command, const std::vector<std::string>& environment, int timeout, int killGrace, int niceness, int ioPriority, process::execResult& result, std::string& error) {
+
+  std::unique_lock<std::mutex> lock(executorMutex);
+  uint32_t requestId = nextRequestId++;
+  std::string request;
+  putInt(request, requestId);
+  putInt(request, timeout);
+  putInt(request, killGrace);
+  putInt(request, niceness);
+  putInt(request, ioPriority);
+  putString(request, command);
+  putInt(request, static_cast<int64_t>(environment.size()));
+  for (auto& variable : environment) {
+    putString(request, variable);
+  }
+  if (request.length() > EXECUTOR_MAX_MESSAGE) {
+    error = "Command too long for executor";
+    return false;
+  }
+  if (executorFd < 0 || send(executorFd, request.data(), request.length(), MSG_NOSIGNAL) < 0) {
+    if (executorFd >= 0 && errno != EPIPE && errno != ECONNRESET) {
+      error = "Could not send command to executor: " + std::string(strerror(errno));
+      return false;
+    }
+    //Executor is gone; the command hasn't been received, so it can be forked here
+    dropExecutor();
+    lock.unlock();
+    return runLocal(command, environment, timeout, killGrace, niceness, ioPriority, result, error);
+  }
+
+  //Command is killed by the executor within timeout and kill grace; a reply taking longer will never come
+  std::chrono::steady_clock::time_point replyDeadline = std::chrono::steady_clock::time_point::max();
+  if (timeout > 0) {
+    replyDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout + killGrace + EXECUTOR_REPLY_GRACE);
+  }
+  std::map<uint32_t, std::string>::iterator reply;
+  while ((reply = executorReplies.find(requestId)) == executorReplies.end()) {
+    if (executorFd < 0) {
+      error = "Executor terminated";
+      return false;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now >= replyDeadline) {
+      abandonedRequests.insert(requestId);
+      error = "Executor did not reply in time";
+      return false;
+    }
+    if (readerActive) {
+      executorCond.wait_for(lock, std::min(std::chrono::duration_cast<std::chrono::milliseconds>(replyDeadline - now), std::chrono::milliseconds(EXECUTOR_CHECK_INTERVAL)));
+      continue;
+    }
+    //Read a response for whoever is waiting for it; the executor is checked periodically meanwhile
+    readerActive = true;
+    int sockFd = executorFd;
+    pid_t pid = executorPid;
+    lock.unlock();
+    int pollTimeout = static_cast<int>(std::min(std::chrono::duration_cast<std::chrono::milliseconds>(replyDeadline - now), std::chrono::milliseconds(EXECUTOR_CHECK_INTERVAL)).count());
+    struct pollfd pfd = {sockFd, POLLIN, 0};
+    int ready = poll(&pfd, 1, pollTimeout);
+    bool alive = true;
+    std::string response;
+    if (ready > 0) {
+      response.resize(EXECUTOR_MAX_MESSAGE);
+      ssize_t recvBytes;
+      while ((recvBytes = recv(sockFd, &response[0], response.length(), 0)) < 0 && errno == EINTR) {
+      }
+      alive = recvBytes > 0;
+      response.resize(alive ? static_cast<size_t>(recvBytes) : 0);
+    } else if (ready == 0) {
+      pid_t waitRes = waitpid(pid, nullptr, WNOHANG);
+      alive = waitRes == 0 || (waitRes < 0 && errno == EINTR);
+    }
+    lock.lock();
+    readerActive = false;
+    if (!alive) {
+      //Executor is gone; commands are forked locally from now on
+      dropExecutor();
+      error = "Executor terminated";
+      return false;
+    }
+    size_t offset = 0;
+    int64_t responseId;
+    if (getInt(response, offset, responseId) && abandonedRequests.erase(static_cast<uint32_t>(responseId)) == 0) {
+      executorReplies[static_cast<uint32_t>(responseId)] = response;
+    }
+    executorCond.notify_all();
+  }
+  std::string response = reply->second;
+  executorReplies.erase(reply);
+  lock.unlock();
+
+  size_t offset = sizeof(int64_t);
+  int64_t executed, exitCode, signaled, timedOut, duration;
+  std::string output;
+  if (!(getInt(response, offset, executed) && getInt(response, offset, exitCode) && getInt(response, offset, signaled) && getInt(response, offset, timedOut) && getInt(response, offset, duration) && getString(response, offset, output))) {
+    error = "Invalid response from executor";
+    return false;
+  }
+  if (!executed) {
+    error = output;
+    return false;
+  }
+  result.exitCode = static_cast<int>(exitCode);
+  result.signaled = signaled != 0;
+  result.timedOut = timedOut != 0;
+  result.duration = std::chrono::milliseconds(duration);
+  result.output = output;
+  return true;
+}
+
+/**
+ * @function configureClass
+ * @description configure an execution class from a specification string
+ * @param std::string specification: <class>:<slots>[:<niceness>[:<I/O priority>]]
+ * @param std::string& error string pointer
+ * @returns bool: true if specification is valid
+**/
+
+bool process::configureClass(const std::string& spec, std::string& error) {
+
+  std::vector<std::string> tokens;
+  size_t start = 0;
+  size_t sepPos;
+  while ((sepPos = spec.find(':', start)) != std::string::npos) {
+    tokens.push_back(spec.substr(start, sepPos - start));
+    start = sepPos + 1;
+  }
+  tokens.push_back(spec.substr(start));
+  if (tokens.size() < 2 || tokens.size() > 4) {
+    error = "Invalid execution class '" + spec + "' (expected <class>:<slots>[:<niceness>[:<I/O priority>]])";
+    return false;
+  }
+  ExecClass execClass;
+  if (tokens.at(0) == EXECCLASS_REQUEST) {
+    execClass = ExecClass::REQUEST;
+  } else if (tokens.at(0) == EXECCLASS_BACKGROUND) {
+    execClass = ExecClass::BACKGROUND;
+  } else {
+    error = "Unknown execution class '" + tokens.at(0) + "'";
+    return false;
+  }
+  classSettings settings;
+  {
+    std::lock_guard<std::mutex> lock(classMutex);
+    settings = classes[static_cast<int>(execClass)];
+  }
+  try {
+    settings.slots = std::stoi(tokens.at(1));
+    if (tokens.size() > 2) {
+      settings.niceness = std::stoi(tokens.at(2));
+    }
+    if (tokens.size() > 3) {
+      settings.ioPriority = std::stoi(tokens.at(3));
+    }
+  } catch (std::exception& ex) {
+    error = "Invalid execution class '" + spec + "': not a number";
+    return false;
+  }
+  if (settings.slots < 0 || settings.niceness < 0 || settings.niceness > 19 || settings.ioPriority < -1 || settings.ioPriority > 7) {
+    error = "Invalid execution class '" + spec + "': slots must be >= 0, niceness in range 0-19, I/O priority in range 0-7";
+    return false;
+  }
+  setClassSettings(execClass, settings);
+  return true;
+}
+
+/**
+ * @function setClassSettings
+ * @description set limits and priority of an execution class
+ * @param ExecClass
+ * @param classSettings
+**/
+
+void process::setClassSettings(ExecClass execClass, const classSettings& settings) {
+  std::lock_guard<std::mutex> lock(classMutex);
+  classes[static_cast<int>(execClass)] = settings;
+  classCond.notify_all();
+}
+
+/**
+ * @function setRunHook
+ * @description replace command execution with a function; must be set before any command is executed
+ * @param runHook hook; nullptr to execute commands
+**/
+
+void process::setRunHook(runHook hook) {
+  commandHook = hook;
+}
+
+/**
+ * @function acquireSlot
+ * @description wait for a free slot of the execution class; waiting executions are served earliest deadline first
+ * @param ExecClass
+ * @param time_point deadline of the execution (time_point::max() if none: served by arrival)
+ * @returns classSettings: settings of the class at admission
+**/
+
+static process::classSettings acquireSlot(process::ExecClass execClass, std::chrono::steady_clock::time_point deadline) {
+
+  int classIndex = static_cast<int>(execClass);
+  std::unique_lock<std::mutex> lock(classMutex);
+  queueKey key(deadline, nextArrival++);
+  std::set<queueKey>& queue = classQueues[classIndex];
+  queue.insert(key);
+  classCond.wait(lock, [&]() {
+    int slots = classes[classIndex].slots;
+    return *queue.begin() == key && (slots == 0 || runningExecutions[classIndex] < slots);
+  });
+  queue.erase(key);
+  runningExecutions[classIndex]++;
+  //Next in queue may be admitted too
+  classCond.notify_all();
+  return classes[classIndex];
+}
+
+/**
+ * @function releaseSlot
+ * @description release a slot of the execution class
+ * @param ExecClass
+**/
+
+static void releaseSlot(process::ExecClass execClass) {
+  std::lock_guard<std::mutex> lock(classMutex);
+  runningExecutions[static_cast<int>(execClass)]--;
+  classCond.notify_all();
+}
+
+/**
+ * @function run
+ * @description execute a shell command in its own process group and wait for it;
+ * the command is forked by the executor when running, by the current process otherwise
+ * @param std::string command to execute with /bin/sh
+ * @param std::vector<std::string> variables (NAME=value) to add to the environment
+ * @param int timeout in milliseconds; 0 to wait forever
+ * @param int time in milliseconds between SIGTERM and SIGKILL when timeout expires
+ * @param execResult& result
+ * @param std::string& error string pointer
+ * @param ExecClass class which limits and prioritizes the execution
+ * @param time_point execution deadline; orders waiting executions of the class
+ * @returns bool: true if command has been executed
+**/
+
+bool process::run(const std::string& command, const std::vector<std::string>& environment, int timeout, int killGrace, execResult& result, std::string& error, ExecClass execClass /* = ExecClass::BACKGROUND */, std::chrono::steady_clock::time_point deadline /* = time_point::max() */) {
+
+  if (commandHook != nullptr) {
+    return commandHook(command, environment, result, error);
+  }
+  classSettings settings = acquireSlot(execClass, deadline);
+  //Time spent in queue is part of the timeout
+  if (timeout > 0 && deadline != std::chrono::steady_clock::time_point::max()) {
+    int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    timeout = std::max(std::min(timeout, remaining), 1);
+  }
+  bool useExecutor;
+  {
+    std::lock_guard<std::mutex> lock(executorMutex);
+    useExecutor = executorFd >= 0;
+  }
+  bool executed;
+  if (useExecutor) {
+    executed = runRemote(command, environment, timeout, killGrace, settings.niceness, settings.ioPriority, result, error);
+  } else {
+    executed = runLocal(command, environment, timeout, killGrace, settings.niceness, settings.ioPriority, result, error);
+  }
+  releaseSlot(execClass);
+  return executed;
+}
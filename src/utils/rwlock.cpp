@@ -0,0 +1,125 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <utils/rwlock.hpp>
+
+namespace murmure {
+
+/**
+ * @function RWLock
+ * @description RWLock class constructor; writers are preferred, so that a stream of readers can't starve them
+**/
+
+RWLock::RWLock() {
+  pthread_rwlockattr_t attributes;
+  pthread_rwlockattr_init(&attributes);
+  pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&rwlock, &attributes);
+  pthread_rwlockattr_destroy(&attributes);
+}
+
+/**
+ * @function ~RWLock
+ * @description RWLock class destructor
+**/
+
+RWLock::~RWLock() {
+  pthread_rwlock_destroy(&rwlock);
+}
+
+/**
+ * @function lockShared
+ * @description acquire lock in shared (read) mode
+ * NOTE: not recursive; a thread must not acquire it twice
+**/
+
+void RWLock::lockShared() {
+  pthread_rwlock_rdlock(&rwlock);
+}
+
+/**
+ * @function unlockShared
+ * @description release lock acquired in shared mode
+**/
+
+void RWLock::unlockShared() {
+  pthread_rwlock_unlock(&rwlock);
+}
+
+/**
+ * @function lock
+ * @description acquire lock in exclusive (write) mode
+**/
+
+void RWLock::lock() {
+  pthread_rwlock_wrlock(&rwlock);
+}
+
+/**
+ * @function unlock
+ * @description release lock acquired in exclusive mode
+**/
+
+void RWLock::unlock() {
+  pthread_rwlock_unlock(&rwlock);
+}
+
+/**
+ * @function ReadGuard
+ * @description acquire lock in shared mode
+ * @param RWLock&
+**/
+
+ReadGuard::ReadGuard(RWLock& lock) : rwlock(lock) {
+  rwlock.lockShared();
+}
+
+/**
+ * @function ~ReadGuard
+ * @description release lock
+**/
+
+ReadGuard::~ReadGuard() {
+  rwlock.unlockShared();
+}
+
+/**
+ * @function WriteGuard
+ * @description acquire lock in exclusive mode
+ * @param RWLock&
+**/
+
+WriteGuard::WriteGuard(RWLock& lock) : rwlock(lock) {
+  rwlock.lock();
+}
+
+/**
+ * @function ~WriteGuard
+ * @description release lock
+**/
+
+WriteGuard::~WriteGuard() {
+  rwlock.unlock();
+}
+
+}
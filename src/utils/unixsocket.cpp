@@ -0,0 +1,179 @@
+/**
+ *   Murmure - Net-SNMP MIB Versatile Extender
+ *   Developed by Christian Visintin
+ * 
+ * MIT License
+ * Copyright (c) 2019 Christian Visintin
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include <utils/unixsocket.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @function makeAddress
+ * @description fill unix socket address
+ * @param std::string socket path
+ * @param sockaddr_un& address
+ * @param std::string& error
+ * @returns bool: false if path is too long
+**/
+
+static bool makeAddress(const std::string& path, sockaddr_un& address, std::string& error) {
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.length() >= sizeof(address.sun_path)) {
+    error = "Invalid socket path '" + path + "'";
+    return false;
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  return true;
+}
+
+/**
+ * @function setTimeouts
+ * @description bound blocking writes and, optionally, reads on socket
+ * @param int socket
+ * @param bool: bound reads too
+**/
+
+static void setTimeouts(int sockFd, bool reads) {
+  timeval timeout;
+  timeout.tv_sec = UNIXSOCKET_IO_TIMEOUT / 1000;
+  timeout.tv_usec = (UNIXSOCKET_IO_TIMEOUT % 1000) * 1000;
+  if (reads) {
+    setsockopt(sockFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+  setsockopt(sockFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+/**
+ * @function listen
+ * @description create a listening unix socket; a stale socket file is replaced, a socket in use is not
+ * @param std::string socket path
+ * @param std::string& error
+ * @returns int: listening socket; -1 on error
+**/
+
+int unixsocket::listen(const std::string& path, std::string& error) {
+
+  sockaddr_un address;
+  if (!makeAddress(path, address, error)) {
+    return -1;
+  }
+  //Check if another daemon is already listening
+  std::string connectError;
+  int peerFd = unixsocket::connect(path, connectError);
+  if (peerFd >= 0) {
+    ::close(peerFd);
+    error = "Socket " + path + " is in use by another process";
+    return -1;
+  }
+  unlink(path.c_str());
+  int sockFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sockFd < 0) {
+    error = "Could not create socket: " + std::string(strerror(errno));
+    return -1;
+  }
+  if (bind(sockFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(sockFd, SOMAXCONN) != 0) {
+    error = "Could not listen on " + path + ": " + std::string(strerror(errno));
+    ::close(sockFd);
+    return -1;
+  }
+  return sockFd;
+}
+
+/**
+ * @function connect
+ * @description connect to a unix socket; writes time out after UNIXSOCKET_IO_TIMEOUT, while reads wait for the response
+ * as long as the peer takes to serve the request (e.g. running GET events)
+ * @param std::string socket path
+ * @param std::string& error
+ * @returns int: connected socket; -1 if nobody is listening
+**/
+
+int unixsocket::connect(const std::string& path, std::string& error) {
+
+  sockaddr_un address;
+  if (!makeAddress(path, address, error)) {
+    return -1;
+  }
+  int sockFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sockFd < 0) {
+    error = "Could not create socket: " + std::string(strerror(errno));
+    return -1;
+  }
+  if (::connect(sockFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    error = "Could not connect to " + path + ": " + std::string(strerror(errno));
+    ::close(sockFd);
+    return -1;
+  }
+  setTimeouts(sockFd, false);
+  return sockFd;
+}
+
+/**
+ * @function accept
+ * @description wait for a connection on a listening socket; reads and writes time out after UNIXSOCKET_IO_TIMEOUT
+ * @param int listening socket
+ * @returns int: connected socket; -1 if listening socket has been shut down
+**/
+
+int unixsocket::accept(int listenFd) {
+  while (true) {
+    int sockFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (sockFd >= 0) {
+      setTimeouts(sockFd, true);
+      return sockFd;
+    } else if (errno != EINTR && errno != ECONNABORTED) {
+      return -1;
+    }
+  }
+}
+
+/**
+ * @function shutdown
+ * @description stop a listening socket; threads blocked in accept are woken up
+ * @param int socket
+**/
+
+void unixsocket::shutdown(int sockFd) {
+  if (sockFd >= 0) {
+    ::shutdown(sockFd, SHUT_RDWR);
+  }
+}
+
+/**
+ * @function close
+ * @description close a listening socket and remove its file
+ * @param int socket
+ * @param std::string socket path
+**/
+
+void unixsocket::close(int sockFd, const std::string& path) {
+  if (sockFd >= 0) {
+    ::close(sockFd);
+    unlink(path.c_str());
+  }
+}